@@ -0,0 +1,60 @@
+import esphome.codegen as cg
+from esphome.components import seplos_bank, seplos_bms
+from esphome.components.canbus import CONF_CANBUS_ID, CanbusComponent
+import esphome.config_validation as cv
+from esphome.const import CONF_ID, CONF_TIMEOUT
+
+DEPENDENCIES = ["canbus", "seplos_bms"]
+CODEOWNERS = ["@syssi"]
+MULTI_CONF = True
+
+CONF_CHARGE_VOLTAGE = "charge_voltage"
+CONF_CHARGE_CURRENT = "charge_current"
+CONF_DISCHARGE_CURRENT = "discharge_current"
+CONF_DISCHARGE_VOLTAGE = "discharge_voltage"
+
+pylontech_can_ns = cg.esphome_ns.namespace("pylontech_can")
+PylontechCan = pylontech_can_ns.class_("PylontechCan", cg.PollingComponent)
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(PylontechCan),
+            cv.GenerateID(CONF_CANBUS_ID): cv.use_id(CanbusComponent),
+            # Report a single pack or all packs of a seplos_bank
+            cv.Optional(seplos_bms.CONF_SEPLOS_BMS_ID): cv.use_id(seplos_bms.SeplosBms),
+            cv.Optional(seplos_bank.CONF_SEPLOS_BANK_ID): cv.use_id(
+                seplos_bank.SeplosBank
+            ),
+            cv.Required(CONF_CHARGE_VOLTAGE): cv.voltage,
+            cv.Required(CONF_CHARGE_CURRENT): cv.current,
+            cv.Required(CONF_DISCHARGE_CURRENT): cv.current,
+            cv.Required(CONF_DISCHARGE_VOLTAGE): cv.voltage,
+            # Stop sending if the BMS didn't report for this long
+            cv.Optional(
+                CONF_TIMEOUT, default="30s"
+            ): cv.positive_time_period_milliseconds,
+        }
+    ).extend(cv.polling_component_schema("1s")),
+    cv.has_exactly_one_key(
+        seplos_bms.CONF_SEPLOS_BMS_ID, seplos_bank.CONF_SEPLOS_BANK_ID
+    ),
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    canbus = await cg.get_variable(config[CONF_CANBUS_ID])
+    cg.add(var.set_canbus(canbus))
+    for key in (seplos_bms.CONF_SEPLOS_BMS_ID, seplos_bank.CONF_SEPLOS_BANK_ID):
+        if key in config:
+            source = await cg.get_variable(config[key])
+            cg.add(var.set_source(source))
+
+    cg.add(var.set_charge_voltage(config[CONF_CHARGE_VOLTAGE]))
+    cg.add(var.set_charge_current(config[CONF_CHARGE_CURRENT]))
+    cg.add(var.set_discharge_current(config[CONF_DISCHARGE_CURRENT]))
+    cg.add(var.set_discharge_voltage(config[CONF_DISCHARGE_VOLTAGE]))
+    cg.add(var.set_timeout(config[CONF_TIMEOUT]))
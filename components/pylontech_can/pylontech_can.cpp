@@ -0,0 +1,181 @@
+#include "pylontech_can.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace pylontech_can {
+
+static const char *const TAG = "pylontech_can";
+
+static const uint8_t LIMITS_FRAME = 0;
+static const uint8_t STATE_FRAME = 1;
+static const uint8_t MEASUREMENTS_FRAME = 2;
+static const uint8_t ALARMS_FRAME = 3;
+static const uint8_t REQUEST_FRAME = 4;
+static const uint8_t MANUFACTURER_FRAME = 5;
+
+static constexpr uint64_t alarm_bit(uint8_t bit) { return uint64_t(1) << bit; }
+
+// Bits of the Seplos alarm events (see ALARMS of seplos_bms)
+static const uint64_t SYSTEM_FAULTS = 0xFF;  // Alarm event 1
+static const uint64_t CHARGE_BLOCKED = alarm_bit(9) | alarm_bit(13) | alarm_bit(17) | alarm_bit(19) | alarm_bit(33) |
+                                       alarm_bit(40) | alarm_bit(44);
+static const uint64_t DISCHARGE_BLOCKED = alarm_bit(11) | alarm_bit(15) | alarm_bit(21) | alarm_bit(23) |
+                                          alarm_bit(35) | alarm_bit(36) | alarm_bit(37) | alarm_bit(38) |
+                                          alarm_bit(39) | alarm_bit(43);
+// Not the cell low voltage charging prohibition (bit 44): the BMS refuses the charge the request would ask for
+static const uint64_t FORCE_CHARGE = alarm_bit(10) | alarm_bit(11);
+
+// Seplos alarm bit -> bit of the Pylontech protection (bytes 0-1) and alarm (bytes 2-3) flags of frame 0x359
+struct AlarmMapping {
+  uint8_t alarm;
+  uint8_t flag;
+};
+static const AlarmMapping ALARM_MAPPINGS[] = {
+    // Protections
+    {9, 1},    // Cell overvoltage
+    {13, 1},   // Total overvoltage
+    {11, 2},   // Cell undervoltage
+    {15, 2},   // Total undervoltage
+    {17, 3},   // Charging overtemperature
+    {21, 3},   // Discharging overtemperature
+    {19, 4},   // Charging undertemperature
+    {23, 4},   // Discharging undertemperature
+    {35, 7},   // Discharging overcurrent
+    {36, 7},   // Transient overcurrent
+    {37, 7},   // Output short circuit
+    {38, 7},   // Transient overcurrent lockout
+    {39, 7},   // Output short circuit lockout
+    {33, 8},   // Charging overcurrent
+    // Alarms
+    {8, 17},   // Cell high voltage
+    {12, 17},  // Total high voltage
+    {10, 18},  // Cell low voltage
+    {14, 18},  // Total low voltage
+    {16, 19},  // Charging high temperature
+    {20, 19},  // Discharging high temperature
+    {18, 20},  // Charging low temperature
+    {22, 20},  // Discharging low temperature
+    {34, 23},  // Discharging overcurrent
+    {32, 24},  // Charging overcurrent
+};
+static const uint8_t SYSTEM_ERROR_FLAG = 11;
+
+static void put_16bit(std::vector<uint8_t> &data, size_t pos, float value) {
+  // Signed and unsigned fields share the encoding, the inverter knows which one it is
+  int32_t raw = 0;
+  if (!std::isnan(value))
+    raw = lroundf(std::max<float>(INT16_MIN, std::min<float>(value, UINT16_MAX)));
+  data[pos + 0] = uint8_t(raw >> 0);
+  data[pos + 1] = uint8_t(raw >> 8);
+}
+
+void init_pylontech_frames(PylontechFrame (&frames)[PYLONTECH_FRAMES]) {
+  frames[LIMITS_FRAME] = {0x351, std::vector<uint8_t>(8, 0x00)};
+  frames[STATE_FRAME] = {0x355, std::vector<uint8_t>(4, 0x00)};
+  frames[MEASUREMENTS_FRAME] = {0x356, std::vector<uint8_t>(6, 0x00)};
+  frames[ALARMS_FRAME] = {0x359, {0x00, 0x00, 0x00, 0x00, 0x00, 'P', 'N', 0x00}};
+  frames[REQUEST_FRAME] = {0x35C, std::vector<uint8_t>(2, 0x00)};
+  frames[MANUFACTURER_FRAME] = {0x35E, {'P', 'Y', 'L', 'O', 'N', ' ', ' ', ' '}};
+}
+
+void encode_pylontech_frames(const seplos_bms::SeplosTelemetry &telemetry, const PylontechLimits &limits,
+                             PylontechFrame (&frames)[PYLONTECH_FRAMES]) {
+  const uint64_t alarms = telemetry.alarm_bitmask;
+  const bool charge_enabled = (alarms & CHARGE_BLOCKED) == 0;
+  const bool discharge_enabled = (alarms & DISCHARGE_BLOCKED) == 0;
+
+  // 0x351: Charge voltage (0.1 V), charge current limit (0.1 A), discharge current limit (0.1 A),
+  // discharge voltage (0.1 V)
+  std::vector<uint8_t> &limit = frames[LIMITS_FRAME].data;
+  put_16bit(limit, 0, limits.charge_voltage * 10.0f);
+  put_16bit(limit, 2, charge_enabled ? limits.charge_current * 10.0f : 0.0f);
+  put_16bit(limit, 4, discharge_enabled ? limits.discharge_current * 10.0f : 0.0f);
+  put_16bit(limit, 6, limits.discharge_voltage * 10.0f);
+
+  // 0x355: SOC (1 %), SOH (1 %)
+  std::vector<uint8_t> &state = frames[STATE_FRAME].data;
+  put_16bit(state, 0, telemetry.state_of_charge);
+  put_16bit(state, 2, telemetry.state_of_health);
+
+  // 0x356: Voltage (0.01 V), current (0.1 A), temperature (0.1 °C)
+  std::vector<uint8_t> &measurements = frames[MEASUREMENTS_FRAME].data;
+  put_16bit(measurements, 0, telemetry.total_voltage * 100.0f);
+  put_16bit(measurements, 2, telemetry.current * 10.0f);
+  put_16bit(measurements, 4, telemetry.max_temperature * 10.0f);
+
+  // 0x359: Protection flags, alarm flags, module count
+  std::vector<uint8_t> &flags = frames[ALARMS_FRAME].data;
+  uint32_t bits = (alarms & SYSTEM_FAULTS) ? (1 << SYSTEM_ERROR_FLAG) : 0;
+  for (const auto &mapping : ALARM_MAPPINGS) {
+    if (alarms & alarm_bit(mapping.alarm))
+      bits |= 1 << mapping.flag;
+  }
+  flags[0] = uint8_t(bits >> 0);
+  flags[1] = uint8_t(bits >> 8);
+  flags[2] = uint8_t(bits >> 16);
+  flags[3] = uint8_t(bits >> 24);
+  flags[4] = telemetry.packs;
+
+  // 0x35C: Bit 7: charge enable, bit 6: discharge enable, bit 5: request force charge
+  std::vector<uint8_t> &request = frames[REQUEST_FRAME].data;
+  request[0] = (charge_enabled ? 1 << 7 : 0) | (discharge_enabled ? 1 << 6 : 0);
+  if (alarms & FORCE_CHARGE)
+    request[0] |= 1 << 5;
+}
+
+void PylontechCan::setup() { init_pylontech_frames(this->frames_); }
+
+void PylontechCan::on_telemetry_(const seplos_bms::SeplosTelemetry &telemetry) {
+  // Neither report the protections as clear before the alarms are known nor an unknown SOC as an empty battery.
+  // The last valid frames are kept until the timeout suspends them
+  if (!telemetry.alarms_received || std::isnan(telemetry.state_of_charge)) {
+    ESP_LOGD(TAG, "Alarms or SOC unknown, skipping the telemetry");
+    return;
+  }
+
+  encode_pylontech_frames(telemetry, this->limits_, this->frames_);
+  this->received_ = true;
+  this->last_telemetry_ = millis();
+  if (this->stale_) {
+    ESP_LOGI(TAG, "Telemetry received again, resuming the inverter frames");
+    this->stale_ = false;
+  }
+}
+
+void PylontechCan::update() {
+  if (!this->received_)
+    return;
+
+  // Let the inverter fall back to its own safe mode instead of acting on outdated values
+  if (millis() - this->last_telemetry_ > this->timeout_) {
+    if (!this->stale_) {
+      ESP_LOGW(TAG, "No telemetry for %" PRIu32 " ms, suspending the inverter frames", this->timeout_);
+      this->stale_ = true;
+    }
+    return;
+  }
+
+  for (const auto &frame : this->frames_) {
+    if (this->canbus_->send_data(frame.can_id, false, false, frame.data) != canbus::ERROR_OK) {
+      ESP_LOGW(TAG, "Sending frame 0x%03" PRIX32 " failed", frame.can_id);
+    }
+  }
+}
+
+void PylontechCan::dump_config() {
+  ESP_LOGCONFIG(TAG, "PylontechCan:");
+  ESP_LOGCONFIG(TAG, "  Charge voltage: %.1f V", this->limits_.charge_voltage);
+  ESP_LOGCONFIG(TAG, "  Charge current: %.1f A", this->limits_.charge_current);
+  ESP_LOGCONFIG(TAG, "  Discharge current: %.1f A", this->limits_.discharge_current);
+  ESP_LOGCONFIG(TAG, "  Discharge voltage: %.1f V", this->limits_.discharge_voltage);
+  ESP_LOGCONFIG(TAG, "  Timeout: %" PRIu32 " ms", this->timeout_);
+  LOG_UPDATE_INTERVAL(this);
+}
+
+}  // namespace pylontech_can
+}  // namespace esphome
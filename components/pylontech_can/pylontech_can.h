@@ -0,0 +1,70 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/components/canbus/canbus.h"
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+#include <vector>
+
+namespace esphome {
+namespace pylontech_can {
+
+static const uint8_t PYLONTECH_FRAMES = 6;
+
+struct PylontechLimits {
+  float charge_voltage;
+  float charge_current;
+  float discharge_current;
+  float discharge_voltage;
+};
+
+struct PylontechFrame {
+  uint32_t can_id;
+  std::vector<uint8_t> data;
+};
+
+// Allocates the frame table once: 0x351 (limits), 0x355 (SOC/SOH), 0x356 (voltage, current, temperature),
+// 0x359 (protections and alarms), 0x35C (charge/discharge request) and 0x35E (manufacturer)
+void init_pylontech_frames(PylontechFrame (&frames)[PYLONTECH_FRAMES]);
+
+// Encodes the values of a pack or bank into the frame table in place
+void encode_pylontech_frames(const seplos_bms::SeplosTelemetry &telemetry, const PylontechLimits &limits,
+                             PylontechFrame (&frames)[PYLONTECH_FRAMES]);
+
+class PylontechCan : public PollingComponent {
+ public:
+  void set_canbus(canbus::Canbus *canbus) { canbus_ = canbus; }
+
+  // A seplos_bms pack or a seplos_bank. The frames carry its protections, so it has to poll the alarms
+  template<typename T> void set_source(T *source) {
+    source->set_alarms_required(true);
+    source->add_on_telemetry_callback(
+        [this](const seplos_bms::SeplosTelemetry &telemetry) { this->on_telemetry_(telemetry); });
+  }
+
+  void set_charge_voltage(float charge_voltage) { limits_.charge_voltage = charge_voltage; }
+  void set_charge_current(float charge_current) { limits_.charge_current = charge_current; }
+  void set_discharge_current(float discharge_current) { limits_.discharge_current = discharge_current; }
+  void set_discharge_voltage(float discharge_voltage) { limits_.discharge_voltage = discharge_voltage; }
+  void set_timeout(uint32_t timeout) { timeout_ = timeout; }
+
+  void setup() override;
+  void dump_config() override;
+  void update() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  canbus::Canbus *canbus_{nullptr};
+  PylontechLimits limits_{};
+  uint32_t timeout_{30000};
+
+  PylontechFrame frames_[PYLONTECH_FRAMES];
+  bool received_{false};
+  bool stale_{false};
+  uint32_t last_telemetry_{0};
+
+  void on_telemetry_(const seplos_bms::SeplosTelemetry &telemetry);
+};
+
+}  // namespace pylontech_can
+}  // namespace esphome
@@ -0,0 +1,40 @@
+import esphome.codegen as cg
+from esphome.components import seplos_modbus
+from esphome.components.seplos_modbus import CONF_SEPLOS_MODBUS_ID
+import esphome.config_validation as cv
+from esphome.const import CONF_ID
+from esphome.core import CORE
+
+AUTO_LOAD = ["sensor"]
+DEPENDENCIES = ["seplos_bms"]
+CODEOWNERS = ["@syssi"]
+MULTI_CONF = True
+
+CONF_SEPLOS_BANK_ID = "seplos_bank_id"
+CONF_PACK_TIMEOUT = "pack_timeout"
+
+seplos_bank_ns = cg.esphome_ns.namespace("seplos_bank")
+SeplosBank = seplos_bank_ns.class_("SeplosBank", cg.PollingComponent)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(SeplosBank),
+        # Aggregate all packs of this bus
+        cv.GenerateID(CONF_SEPLOS_MODBUS_ID): cv.use_id(seplos_modbus.SeplosModbus),
+        # Drop a pack from the aggregates if it didn't respond for this long
+        cv.Optional(
+            CONF_PACK_TIMEOUT, default="60s"
+        ): cv.positive_time_period_milliseconds,
+    }
+).extend(cv.polling_component_schema("10s"))
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    cg.add(var.set_pack_timeout(config[CONF_PACK_TIMEOUT]))
+    for pack in CORE.config.get("seplos_bms", []):
+        if pack[CONF_SEPLOS_MODBUS_ID].id == config[CONF_SEPLOS_MODBUS_ID].id:
+            bms = await cg.get_variable(pack[CONF_ID])
+            cg.add(var.add_pack(bms))
@@ -0,0 +1,215 @@
+#include "seplos_bank.h"
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
+namespace esphome {
+namespace seplos_bank {
+
+static const char *const TAG = "seplos_bank";
+
+void SeplosBank::add_pack(seplos_bms::SeplosBms *pack) {
+  const uint8_t index = this->packs_.size();
+  this->packs_.push_back(Pack{});
+  this->packs_.back().component = pack;
+  if (this->alarms_required_)
+    pack->set_alarms_required(true);
+  pack->add_on_telemetry_callback(
+      [this, index](const seplos_bms::SeplosTelemetry &telemetry) { this->on_telemetry_(index, telemetry); });
+}
+
+void SeplosBank::set_alarms_required(bool alarms_required) {
+  this->alarms_required_ = alarms_required;
+  for (auto &pack : this->packs_)
+    pack.component->set_alarms_required(alarms_required);
+}
+
+void SeplosBank::on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry) {
+  Pack &pack = this->packs_[index];
+  if (pack.online) {
+    this->remove_contribution_(pack);
+  } else {
+    ESP_LOGD(TAG, "Pack 0x%02X online", telemetry.pack);
+  }
+
+  pack.online = true;
+  pack.last_seen = millis();
+  pack.cells = telemetry.cells;
+  pack.current = lroundf(telemetry.current * 100.0f);
+  pack.total_voltage = lroundf(telemetry.total_voltage * 100.0f);
+  pack.power = int64_t(pack.current) * pack.total_voltage;
+  pack.residual_capacity = lroundf(telemetry.residual_capacity * 100.0f);
+  pack.battery_capacity = lroundf(telemetry.battery_capacity * 100.0f);
+  pack.weighted_state_of_charge = int64_t(lroundf(telemetry.state_of_charge * 10.0f)) * pack.battery_capacity;
+  pack.min_cell_voltage = (telemetry.cells > 0) ? telemetry.min_cell_voltage : NAN;
+  pack.max_cell_voltage = (telemetry.cells > 0) ? telemetry.max_cell_voltage : NAN;
+  pack.min_temperature = telemetry.min_temperature;
+  pack.max_temperature = telemetry.max_temperature;
+  pack.state_of_health = telemetry.state_of_health;
+  pack.alarm_bitmask = telemetry.alarm_bitmask;
+  pack.alarms_received = telemetry.alarms_received;
+
+  this->add_contribution_(pack);
+  this->track_extremes_(index);
+  this->publish_telemetry_();
+}
+
+void SeplosBank::add_contribution_(const Pack &pack) {
+  this->online_packs_++;
+  this->current_ += pack.current;
+  this->total_voltage_ += pack.total_voltage;
+  this->power_ += pack.power;
+  this->residual_capacity_ += pack.residual_capacity;
+  this->battery_capacity_ += pack.battery_capacity;
+  this->weighted_state_of_charge_ += pack.weighted_state_of_charge;
+  for (uint64_t bits = pack.alarm_bitmask; bits != 0; bits &= bits - 1) {
+    const uint8_t bit = __builtin_ctzll(bits);
+    if (this->alarm_counts_[bit]++ == 0)
+      this->alarm_bitmask_ |= uint64_t(1) << bit;
+  }
+  if (!pack.alarms_received)
+    this->packs_without_alarms_++;
+}
+
+void SeplosBank::remove_contribution_(const Pack &pack) {
+  this->online_packs_--;
+  this->current_ -= pack.current;
+  this->total_voltage_ -= pack.total_voltage;
+  this->power_ -= pack.power;
+  this->residual_capacity_ -= pack.residual_capacity;
+  this->battery_capacity_ -= pack.battery_capacity;
+  this->weighted_state_of_charge_ -= pack.weighted_state_of_charge;
+  for (uint64_t bits = pack.alarm_bitmask; bits != 0; bits &= bits - 1) {
+    const uint8_t bit = __builtin_ctzll(bits);
+    if (--this->alarm_counts_[bit] == 0)
+      this->alarm_bitmask_ &= ~(uint64_t(1) << bit);
+  }
+  if (!pack.alarms_received)
+    this->packs_without_alarms_--;
+}
+
+void SeplosBank::track_extremes_(uint8_t index) {
+  this->track_extreme_(this->min_cell_voltage_, index);
+  this->track_extreme_(this->max_cell_voltage_, index);
+  this->track_extreme_(this->min_temperature_, index);
+  this->track_extreme_(this->max_temperature_, index);
+  this->track_extreme_(this->min_state_of_health_, index);
+  this->track_extreme_(this->max_cells_, index);
+}
+
+void SeplosBank::track_extreme_(Extreme &extreme, uint8_t index) {
+  auto beats = [&extreme](float value, float other) {
+    return !std::isnan(value) && (std::isnan(other) || (extreme.maximum ? value >= other : value <= other));
+  };
+
+  const Pack &pack = this->packs_[index];
+  if (pack.online && beats(pack.*extreme.field, extreme.value)) {
+    extreme.pack = index;
+    extreme.value = pack.*extreme.field;
+    return;
+  }
+  if (extreme.pack != index)
+    return;
+
+  // The holder moved away from the extreme or went offline
+  extreme.pack = -1;
+  extreme.value = NAN;
+  for (uint8_t i = 0; i < this->packs_.size(); i++) {
+    if (this->packs_[i].online && beats(this->packs_[i].*extreme.field, extreme.value)) {
+      extreme.pack = i;
+      extreme.value = this->packs_[i].*extreme.field;
+    }
+  }
+}
+
+void SeplosBank::publish_telemetry_() {
+  if (this->online_packs_ == 0)
+    return;
+
+  seplos_bms::SeplosTelemetry telemetry{};
+  telemetry.pack = 0xFF;
+  telemetry.packs = this->online_packs_;
+  telemetry.cells = std::isnan(this->max_cells_.value) ? 0 : (uint8_t) this->max_cells_.value;
+  telemetry.state_of_health = this->min_state_of_health_.value;
+  telemetry.alarm_bitmask = this->alarm_bitmask_;
+  telemetry.alarms_received = this->packs_without_alarms_ == 0;
+  telemetry.min_cell_voltage = this->min_cell_voltage_.value;
+  telemetry.max_cell_voltage = this->max_cell_voltage_.value;
+  telemetry.min_temperature = this->min_temperature_.value;
+  telemetry.max_temperature = this->max_temperature_.value;
+  telemetry.current = this->current_ * 0.01f;
+  telemetry.total_voltage = this->total_voltage_ * 0.01f / this->online_packs_;
+  telemetry.residual_capacity = this->residual_capacity_ * 0.01f;
+  telemetry.battery_capacity = this->battery_capacity_ * 0.01f;
+  telemetry.state_of_charge =
+      (this->battery_capacity_ > 0) ? (float) this->weighted_state_of_charge_ / this->battery_capacity_ * 0.1f : NAN;
+  this->telemetry_callback_.call(telemetry);
+}
+
+void SeplosBank::update() {
+  const uint32_t now = millis();
+  for (uint8_t i = 0; i < this->packs_.size(); i++) {
+    Pack &pack = this->packs_[i];
+    if (pack.online && now - pack.last_seen > this->pack_timeout_) {
+      ESP_LOGW(TAG, "Pack %d offline", i);
+      this->remove_contribution_(pack);
+      pack.online = false;
+      this->track_extremes_(i);
+      this->publish_telemetry_();
+    }
+  }
+
+  this->publish_state_(this->online_packs_sensor_, (float) this->online_packs_);
+  if (this->online_packs_ == 0)
+    return;
+
+  this->publish_state_(this->current_sensor_, this->current_ * 0.01f);
+  this->publish_state_(this->power_sensor_, this->power_ * 0.0001f);
+  // The packs of a bank are connected in parallel
+  this->publish_state_(this->total_voltage_sensor_, this->total_voltage_ * 0.01f / this->online_packs_);
+  this->publish_state_(this->residual_capacity_sensor_, this->residual_capacity_ * 0.01f);
+  this->publish_state_(this->battery_capacity_sensor_, this->battery_capacity_ * 0.01f);
+  if (this->battery_capacity_ > 0) {
+    this->publish_state_(this->state_of_charge_sensor_,
+                         (float) this->weighted_state_of_charge_ / this->battery_capacity_ * 0.1f);
+  }
+
+  this->publish_state_(this->min_cell_voltage_sensor_, this->min_cell_voltage_.value);
+  this->publish_state_(this->max_cell_voltage_sensor_, this->max_cell_voltage_.value);
+  this->publish_state_(this->delta_cell_voltage_sensor_,
+                       this->max_cell_voltage_.value - this->min_cell_voltage_.value);
+  this->publish_state_(this->min_temperature_sensor_, this->min_temperature_.value);
+  this->publish_state_(this->max_temperature_sensor_, this->max_temperature_.value);
+}
+
+void SeplosBank::dump_config() {
+  ESP_LOGCONFIG(TAG, "SeplosBank:");
+  ESP_LOGCONFIG(TAG, "  Packs: %d", (int) this->packs_.size());
+  ESP_LOGCONFIG(TAG, "  Pack timeout: %" PRIu32 " ms", this->pack_timeout_);
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("", "Current", this->current_sensor_);
+  LOG_SENSOR("", "Power", this->power_sensor_);
+  LOG_SENSOR("", "Total Voltage", this->total_voltage_sensor_);
+  LOG_SENSOR("", "State of charge", this->state_of_charge_sensor_);
+  LOG_SENSOR("", "Residual capacity", this->residual_capacity_sensor_);
+  LOG_SENSOR("", "Battery capacity", this->battery_capacity_sensor_);
+  LOG_SENSOR("", "Minimum Cell Voltage", this->min_cell_voltage_sensor_);
+  LOG_SENSOR("", "Maximum Cell Voltage", this->max_cell_voltage_sensor_);
+  LOG_SENSOR("", "Delta Cell Voltage", this->delta_cell_voltage_sensor_);
+  LOG_SENSOR("", "Minimum Temperature", this->min_temperature_sensor_);
+  LOG_SENSOR("", "Maximum Temperature", this->max_temperature_sensor_);
+  LOG_SENSOR("", "Online Packs", this->online_packs_sensor_);
+}
+
+void SeplosBank::publish_state_(sensor::Sensor *sensor, float value) {
+  if (sensor == nullptr)
+    return;
+
+  sensor->publish_state(value);
+}
+
+}  // namespace seplos_bank
+}  // namespace esphome
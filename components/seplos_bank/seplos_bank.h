@@ -0,0 +1,139 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+#include <cmath>
+#include <vector>
+
+namespace esphome {
+namespace seplos_bank {
+
+class SeplosBank : public PollingComponent {
+ public:
+  void add_pack(seplos_bms::SeplosBms *pack);
+  // Makes every pack poll its alarms, see SeplosBms::set_alarms_required()
+  void set_alarms_required(bool alarms_required);
+
+  void set_current_sensor(sensor::Sensor *current_sensor) { current_sensor_ = current_sensor; }
+  void set_power_sensor(sensor::Sensor *power_sensor) { power_sensor_ = power_sensor; }
+  void set_total_voltage_sensor(sensor::Sensor *total_voltage_sensor) { total_voltage_sensor_ = total_voltage_sensor; }
+  void set_state_of_charge_sensor(sensor::Sensor *state_of_charge_sensor) {
+    state_of_charge_sensor_ = state_of_charge_sensor;
+  }
+  void set_residual_capacity_sensor(sensor::Sensor *residual_capacity_sensor) {
+    residual_capacity_sensor_ = residual_capacity_sensor;
+  }
+  void set_battery_capacity_sensor(sensor::Sensor *battery_capacity_sensor) {
+    battery_capacity_sensor_ = battery_capacity_sensor;
+  }
+  void set_min_cell_voltage_sensor(sensor::Sensor *min_cell_voltage_sensor) {
+    min_cell_voltage_sensor_ = min_cell_voltage_sensor;
+  }
+  void set_max_cell_voltage_sensor(sensor::Sensor *max_cell_voltage_sensor) {
+    max_cell_voltage_sensor_ = max_cell_voltage_sensor;
+  }
+  void set_delta_cell_voltage_sensor(sensor::Sensor *delta_cell_voltage_sensor) {
+    delta_cell_voltage_sensor_ = delta_cell_voltage_sensor;
+  }
+  void set_min_temperature_sensor(sensor::Sensor *min_temperature_sensor) {
+    min_temperature_sensor_ = min_temperature_sensor;
+  }
+  void set_max_temperature_sensor(sensor::Sensor *max_temperature_sensor) {
+    max_temperature_sensor_ = max_temperature_sensor;
+  }
+  void set_online_packs_sensor(sensor::Sensor *online_packs_sensor) { online_packs_sensor_ = online_packs_sensor; }
+
+  void set_pack_timeout(uint32_t pack_timeout) { pack_timeout_ = pack_timeout; }
+
+  // Called with the bank values whenever a pack reports or drops out
+  void add_on_telemetry_callback(std::function<void(const seplos_bms::SeplosTelemetry &)> &&callback) {
+    this->telemetry_callback_.add(std::move(callback));
+  }
+
+  void dump_config() override;
+  void update() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  sensor::Sensor *current_sensor_{nullptr};
+  sensor::Sensor *power_sensor_{nullptr};
+  sensor::Sensor *total_voltage_sensor_{nullptr};
+  sensor::Sensor *state_of_charge_sensor_{nullptr};
+  sensor::Sensor *residual_capacity_sensor_{nullptr};
+  sensor::Sensor *battery_capacity_sensor_{nullptr};
+  sensor::Sensor *min_cell_voltage_sensor_{nullptr};
+  sensor::Sensor *max_cell_voltage_sensor_{nullptr};
+  sensor::Sensor *delta_cell_voltage_sensor_{nullptr};
+  sensor::Sensor *min_temperature_sensor_{nullptr};
+  sensor::Sensor *max_temperature_sensor_{nullptr};
+  sensor::Sensor *online_packs_sensor_{nullptr};
+
+  uint32_t pack_timeout_{60000};
+  bool alarms_required_{false};
+
+  CallbackManager<void(const seplos_bms::SeplosTelemetry &)> telemetry_callback_;
+
+  // The contribution of a pack to the sums is kept in fixed point (0.01 A, 0.01 V, 0.01 Ah, 0.1 % * 0.01 Ah)
+  // so it can be taken back exactly when the next frame of the pack arrives
+  struct Pack {
+    seplos_bms::SeplosBms *component;
+    bool online;
+    uint32_t last_seen;
+    float cells;  // Tracked like the other extremes
+    int32_t current;
+    int32_t total_voltage;
+    int64_t power;
+    int32_t residual_capacity;
+    int32_t battery_capacity;
+    int64_t weighted_state_of_charge;
+    float min_cell_voltage;
+    float max_cell_voltage;
+    float min_temperature;
+    float max_temperature;
+    float state_of_health;
+    uint64_t alarm_bitmask;
+    bool alarms_received;
+  };
+  std::vector<Pack> packs_;
+
+  uint8_t online_packs_{0};
+  int32_t current_{0};
+  int64_t total_voltage_{0};
+  int64_t power_{0};
+  int32_t residual_capacity_{0};
+  int32_t battery_capacity_{0};
+  int64_t weighted_state_of_charge_{0};
+  // Number of online packs raising each alarm bit, the bitmask holds the bits of a count above 0
+  uint8_t alarm_counts_[64]{};
+  uint64_t alarm_bitmask_{0};
+  uint8_t packs_without_alarms_{0};
+
+  // An extreme value and the pack holding it. Only a holder moving away from its extreme requires a rescan
+  // of all packs
+  struct Extreme {
+    float Pack::*field;
+    bool maximum;
+    int8_t pack;
+    float value;
+  };
+  Extreme min_cell_voltage_{&Pack::min_cell_voltage, false, -1, NAN};
+  Extreme max_cell_voltage_{&Pack::max_cell_voltage, true, -1, NAN};
+  Extreme min_temperature_{&Pack::min_temperature, false, -1, NAN};
+  Extreme max_temperature_{&Pack::max_temperature, true, -1, NAN};
+  // The weakest pack limits the bank
+  Extreme min_state_of_health_{&Pack::state_of_health, false, -1, NAN};
+  Extreme max_cells_{&Pack::cells, true, -1, NAN};
+
+  void on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry);
+  void add_contribution_(const Pack &pack);
+  void remove_contribution_(const Pack &pack);
+  void track_extremes_(uint8_t index);
+  void track_extreme_(Extreme &extreme, uint8_t index);
+  void publish_telemetry_();
+  void publish_state_(sensor::Sensor *sensor, float value);
+};
+
+}  // namespace seplos_bank
+}  // namespace esphome
@@ -1,7 +1,13 @@
 import esphome.codegen as cg
 from esphome.components import seplos_modbus
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import (
+    CONF_CURRENT,
+    CONF_ID,
+    CONF_POWER,
+    CONF_TEMPERATURE,
+    CONF_UPDATE_INTERVAL,
+)
 
 AUTO_LOAD = ["seplos_modbus", "binary_sensor", "sensor", "text_sensor"]
 CODEOWNERS = ["@syssi"]
@@ -9,21 +15,99 @@ MULTI_CONF = True
 
 CONF_SEPLOS_BMS_ID = "seplos_bms_id"
 CONF_OVERRIDE_CELL_COUNT = "override_cell_count"
-
-DEFAULT_PROTOCOL_VERSION = 0x20
-DEFAULT_ADDRESS = 0x00
+CONF_ALARM_UPDATE_INTERVAL = "alarm_update_interval"
+CONF_HEARTBEAT_INTERVAL = "heartbeat_interval"
+CONF_INFO_UPDATE_INTERVAL = "info_update_interval"
+CONF_DEADBAND = "deadband"
+CONF_CELL_VOLTAGE = "cell_voltage"
+CONF_VOLTAGE = "voltage"
+CONF_ADAPTIVE_POLLING = "adaptive_polling"
+CONF_MAX_INTERVAL = "max_interval"
+CONF_CURRENT_THRESHOLD = "current_threshold"
+CONF_CELL_VOLTAGE_DELTA_THRESHOLD = "cell_voltage_delta_threshold"
+CONF_ENERGY_SAVE_INTERVAL = "energy_save_interval"
+CONF_FAST_WATCH = "fast_watch"
+CONF_ENABLED = "enabled"
+CONF_CID1 = "cid1"
+CONF_FUNCTION = "function"
 
 seplos_bms_ns = cg.esphome_ns.namespace("seplos_bms")
 SeplosBms = seplos_bms_ns.class_(
     "SeplosBms", cg.PollingComponent, seplos_modbus.SeplosModbusDevice
 )
 
-CONFIG_SCHEMA = (
+# INFO of a command (switch, button and number platforms)
+MAX_INFO_SIZE = 16
+INFO_SCHEMA = cv.All(cv.ensure_list(cv.hex_uint8_t), cv.Length(max=MAX_INFO_SIZE))
+COMMAND_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_SEPLOS_BMS_ID): cv.use_id(SeplosBms),
+        cv.Optional(CONF_CID1, default=0x46): cv.hex_uint8_t,
+        cv.Required(CONF_FUNCTION): cv.hex_uint8_t,
+    }
+)
+
+DEFAULT_PROTOCOL_VERSION = 0x20
+DEFAULT_ADDRESS = 0x00
+
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(SeplosBms),
             cv.Optional(CONF_OVERRIDE_CELL_COUNT, default=0): cv.int_range(
-                min=0, max=16
+                min=0, max=32
+            ),
+            # Poll the alarms (CID2 0x44) on a separate schedule. By default they are polled with the telemetry
+            cv.Optional(
+                CONF_ALARM_UPDATE_INTERVAL, default="0s"
+            ): cv.positive_time_period_milliseconds,
+            # Refresh the system parameters and manufacturer info (CID2 0x47, 0x51, 0x4F). They are fetched at
+            # startup and whenever the rated capacity of the pack changes as well
+            cv.Optional(
+                CONF_INFO_UPDATE_INTERVAL, default="6h"
+            ): cv.positive_time_period_milliseconds,
+            # Publish values on change only and all of them once per heartbeat interval. The deadbands apply
+            # without a heartbeat as well
+            cv.Optional(
+                CONF_HEARTBEAT_INTERVAL, default="0s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_DEADBAND, default={}): cv.Schema(
+                {
+                    cv.Optional(CONF_CELL_VOLTAGE, default=0.0): cv.positive_float,
+                    cv.Optional(CONF_VOLTAGE, default=0.0): cv.positive_float,
+                    cv.Optional(CONF_CURRENT, default=0.0): cv.positive_float,
+                    cv.Optional(CONF_POWER, default=0.0): cv.positive_float,
+                    cv.Optional(CONF_TEMPERATURE, default=0.0): cv.positive_float,
+                }
+            ),
+            # Poll at the update interval while the pack is busy and back off exponentially up to the
+            # max interval while it's idle
+            cv.Optional(CONF_ADAPTIVE_POLLING): cv.Schema(
+                {
+                    cv.Required(
+                        CONF_MAX_INTERVAL
+                    ): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_CURRENT_THRESHOLD, default=5.0): cv.positive_float,
+                    cv.Optional(
+                        CONF_CELL_VOLTAGE_DELTA_THRESHOLD, default=0.05
+                    ): cv.positive_float,
+                }
+            ),
+            # Write the charged and discharged energy counters to flash at most once per interval
+            cv.Optional(CONF_ENERGY_SAVE_INTERVAL, default="15min"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(minutes=1)),
+            ),
+            # Poll the cell voltages, current and total voltage at a high rate and publish them as a single
+            # payload to the fast_watch text sensor. The regular poll keeps its update interval
+            cv.Optional(CONF_FAST_WATCH): cv.Schema(
+                {
+                    cv.Optional(CONF_UPDATE_INTERVAL, default="1s"): cv.All(
+                        cv.positive_time_period_milliseconds,
+                        cv.Range(min=cv.TimePeriod(milliseconds=200)),
+                    ),
+                    cv.Optional(CONF_ENABLED, default=True): cv.boolean,
+                }
             ),
         }
     )
@@ -32,7 +116,8 @@ CONFIG_SCHEMA = (
         seplos_modbus.seplos_modbus_device_schema(
             DEFAULT_PROTOCOL_VERSION, DEFAULT_ADDRESS
         )
-    )
+    ),
+    seplos_modbus.validate_seplos_modbus_device,
 )
 
 
@@ -42,3 +127,27 @@ async def to_code(config):
     await seplos_modbus.register_seplos_modbus_device(var, config)
 
     cg.add(var.set_override_cell_count(config[CONF_OVERRIDE_CELL_COUNT]))
+    cg.add(var.set_alarm_update_interval(config[CONF_ALARM_UPDATE_INTERVAL]))
+    cg.add(var.set_heartbeat_interval(config[CONF_HEARTBEAT_INTERVAL]))
+    cg.add(var.set_info_update_interval(config[CONF_INFO_UPDATE_INTERVAL]))
+    cg.add(var.set_energy_save_interval(config[CONF_ENERGY_SAVE_INTERVAL]))
+    cg.add(var.set_energy_key(str(config[CONF_ID])))
+    if CONF_FAST_WATCH in config:
+        fast_watch = config[CONF_FAST_WATCH]
+        cg.add(var.set_fast_watch_interval(fast_watch[CONF_UPDATE_INTERVAL]))
+        cg.add(var.set_fast_watch_enabled(fast_watch[CONF_ENABLED]))
+    deadband = config[CONF_DEADBAND]
+    cg.add(var.set_cell_voltage_deadband(deadband[CONF_CELL_VOLTAGE]))
+    cg.add(var.set_voltage_deadband(deadband[CONF_VOLTAGE]))
+    cg.add(var.set_current_deadband(deadband[CONF_CURRENT]))
+    cg.add(var.set_power_deadband(deadband[CONF_POWER]))
+    cg.add(var.set_temperature_deadband(deadband[CONF_TEMPERATURE]))
+    if CONF_ADAPTIVE_POLLING in config:
+        adaptive = config[CONF_ADAPTIVE_POLLING]
+        cg.add(var.set_max_poll_interval(adaptive[CONF_MAX_INTERVAL]))
+        cg.add(var.set_current_threshold(adaptive[CONF_CURRENT_THRESHOLD]))
+        cg.add(
+            var.set_cell_voltage_delta_threshold(
+                adaptive[CONF_CELL_VOLTAGE_DELTA_THRESHOLD]
+            )
+        )
@@ -0,0 +1,128 @@
+#include "analytics.h"
+#include "esphome/core/helpers.h"
+
+#include <cmath>
+
+namespace esphome {
+namespace seplos_bms {
+
+// Intervals without a frame longer than this aren't integrated. The pack was offline
+static const uint32_t MAX_ENERGY_GAP = 10 * 60 * 1000;
+// 0.1 mW * ms per kWh
+static const double ENERGY_PER_KWH = 3.6e13;
+// The current must spread at least 1 A (in 10 mA) around its mean to fit a resistance
+static const int64_t MIN_CURRENT_SPREAD = 100;
+static const float DRIFT_SMOOTHING = 1.0f / 16.0f;
+
+void SeplosAnalytics::resize(uint8_t cells) {
+  if (cells == this->cells_)
+    return;
+
+  this->cells_ = cells;
+  this->samples_ = 0;
+  this->head_ = 0;
+  this->sum_current_ = 0;
+  this->sum_current_squared_ = 0;
+  this->cell_voltages_.assign(size_t(ANALYTICS_WINDOW) * cells, 0);
+  this->fits_.assign(cells, Cell{0, 0, 0.0f});
+  this->has_drift_ = false;
+}
+
+void SeplosAnalytics::add_sample(uint32_t now, const uint8_t *cell_voltages, uint8_t cells, int16_t current,
+                                 uint16_t total_voltage) {
+  this->add_energy_(int64_t(current) * total_voltage, now);
+
+  if (cells < this->cells_)
+    this->resize(cells);
+  if (this->cells_ == 0)
+    return;
+
+  int32_t total = 0;
+  for (uint8_t i = 0; i < cells; i++) {
+    total += encode_uint16(cell_voltages[i * 2], cell_voltages[i * 2 + 1]);
+  }
+  const float average = float(total) / cells;
+
+  // Replace the oldest sample of the ring once it's full
+  const bool full = this->samples_ == ANALYTICS_WINDOW;
+  const int16_t oldest_current = this->currents_[this->head_];
+  if (full) {
+    this->sum_current_ -= oldest_current;
+    this->sum_current_squared_ -= int32_t(oldest_current) * oldest_current;
+  } else {
+    this->samples_++;
+  }
+  this->currents_[this->head_] = current;
+  this->sum_current_ += current;
+  this->sum_current_squared_ += int32_t(current) * current;
+
+  uint16_t *row = &this->cell_voltages_[size_t(this->head_) * this->cells_];
+  for (uint8_t i = 0; i < this->cells_; i++) {
+    Cell &fit = this->fits_[i];
+    const uint16_t voltage = encode_uint16(cell_voltages[i * 2], cell_voltages[i * 2 + 1]);
+    if (full) {
+      fit.sum_voltage -= row[i];
+      fit.sum_voltage_current -= int32_t(row[i]) * oldest_current;
+    }
+    row[i] = voltage;
+    fit.sum_voltage += voltage;
+    fit.sum_voltage_current += int32_t(voltage) * current;
+
+    const float deviation = voltage - average;
+    fit.drift = this->has_drift_ ? fit.drift + (deviation - fit.drift) * DRIFT_SMOOTHING : deviation;
+  }
+  this->has_drift_ = true;
+  this->head_ = (this->head_ + 1) % ANALYTICS_WINDOW;
+}
+
+void SeplosAnalytics::add_energy_(int64_t power, uint32_t now) {
+  const uint32_t elapsed = now - this->last_sample_;
+  if (this->has_power_ && elapsed <= MAX_ENERGY_GAP) {
+    const int64_t previous = this->last_power_;
+    if (previous >= 0 && power >= 0) {
+      this->energy_.charged += uint64_t((previous + power) * elapsed / 2);
+    } else if (previous <= 0 && power <= 0) {
+      this->energy_.discharged += uint64_t(-(previous + power) * elapsed / 2);
+    } else {
+      // The power crossed zero. Each side gets the triangle up to the crossing
+      const double span = double(power) - double(previous);
+      const double charged = power > 0 ? power : previous;
+      const double discharged = power > 0 ? previous : power;
+      this->energy_.charged += uint64_t(charged * charged / std::fabs(span) * elapsed / 2);
+      this->energy_.discharged += uint64_t(discharged * discharged / std::fabs(span) * elapsed / 2);
+    }
+  }
+  this->has_power_ = true;
+  this->last_power_ = power;
+  this->last_sample_ = now;
+}
+
+float SeplosAnalytics::charged_energy() const { return this->energy_.charged / ENERGY_PER_KWH; }
+
+float SeplosAnalytics::discharged_energy() const { return this->energy_.discharged / ENERGY_PER_KWH; }
+
+float SeplosAnalytics::cell_resistance(uint8_t cell) const {
+  if (cell >= this->cells_ || this->samples_ < ANALYTICS_WINDOW)
+    return NAN;
+
+  // Slope of V = OCV + R * I, with a positive current while charging
+  const int64_t n = this->samples_;
+  const int64_t variance = n * this->sum_current_squared_ - int64_t(this->sum_current_) * this->sum_current_;
+  if (variance < n * n * MIN_CURRENT_SPREAD * MIN_CURRENT_SPREAD)
+    return NAN;
+
+  const Cell &fit = this->fits_[cell];
+  const int64_t covariance = n * fit.sum_voltage_current - int64_t(this->sum_current_) * fit.sum_voltage;
+  // mV / 10 mA = 100 mOhm
+  return float(covariance) / float(variance) * 100.0f;
+}
+
+float SeplosAnalytics::cell_drift(uint8_t cell) const {
+  if (cell >= this->cells_ || !this->has_drift_)
+    return NAN;
+
+  return this->fits_[cell].drift;
+}
+
+}  // namespace seplos_bms
+}  // namespace esphome
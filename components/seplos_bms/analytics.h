@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace seplos_bms {
+
+// Number of telemetry frames the internal resistance is fitted over
+static const uint8_t ANALYTICS_WINDOW = 32;
+
+// Charged and discharged energy in 0.1 mW * ms (the product of the raw current, voltage and millis())
+struct EnergyCounters {
+  uint64_t charged;
+  uint64_t discharged;
+};
+
+// Values derived from the telemetry frames of a pack. Every frame updates them in O(1) per cell:
+//  - the energy counters by trapezoidal integration of the power between two frames
+//  - the internal resistance of a cell by the least squares slope of its voltage over the current. The sums of
+//    the fit are kept up to date as the oldest sample of the ring is replaced by the newest
+//  - the drift of a cell by an EWMA of its deviation from the average cell voltage
+class SeplosAnalytics {
+ public:
+  // Allocates the rings of the cells. Resets the fits of all cells if the number of cells changes
+  void resize(uint8_t cells);
+  uint8_t cells() const { return this->cells_; }
+  // The last sample completed a pass over the ring
+  bool is_window_end() const { return this->samples_ > 0 && this->head_ == 0; }
+
+  // Raw telemetry values: cell voltages (uint16_t big endian, 1 mV), current (10 mA) and total voltage (10 mV)
+  void add_sample(uint32_t now, const uint8_t *cell_voltages, uint8_t cells, int16_t current, uint16_t total_voltage);
+
+  EnergyCounters &energy() { return this->energy_; }
+  // kWh
+  float charged_energy() const;
+  float discharged_energy() const;
+
+  // mOhm. NAN until the current of the window varied enough to fit a slope
+  float cell_resistance(uint8_t cell) const;
+  // mV. NAN until the cell has been seen
+  float cell_drift(uint8_t cell) const;
+
+ protected:
+  void add_energy_(int64_t power, uint32_t now);
+
+  EnergyCounters energy_{0, 0};
+  bool has_power_{false};
+  int64_t last_power_{0};
+  uint32_t last_sample_{0};
+
+  uint8_t cells_{0};
+  uint8_t samples_{0};
+  uint8_t head_{0};
+  // Ring of the currents and the cell voltages, one row of cells per sample
+  int16_t currents_[ANALYTICS_WINDOW]{};
+  std::vector<uint16_t> cell_voltages_;
+  int32_t sum_current_{0};
+  int64_t sum_current_squared_{0};
+
+  struct Cell {
+    int32_t sum_voltage;
+    int64_t sum_voltage_current;
+    float drift;  // mV
+  };
+  std::vector<Cell> fits_;
+  bool has_drift_{false};
+};
+
+}  // namespace seplos_bms
+}  // namespace esphome
@@ -9,17 +9,31 @@ DEPENDENCIES = ["seplos_bms"]
 
 CODEOWNERS = ["@syssi"]
 
-CONF_FAN_RUNNING = "fan_running"
+CONF_CHARGING_SWITCH = "charging_switch"
+CONF_DISCHARGING_SWITCH = "discharging_switch"
+CONF_BALANCING = "balancing"
+
+ICON_CHARGING_SWITCH = "mdi:battery-charging"
+ICON_DISCHARGING_SWITCH = "mdi:power-plug"
+ICON_BALANCING = "mdi:scale-balance"
 
 BINARY_SENSORS = [
-    CONF_FAN_RUNNING,
+    CONF_CHARGING_SWITCH,
+    CONF_DISCHARGING_SWITCH,
+    CONF_BALANCING,
 ]
 
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_SEPLOS_BMS_ID): cv.use_id(SeplosBms),
-        cv.Optional(CONF_FAN_RUNNING): binary_sensor.binary_sensor_schema(
-            icon="mdi:fan"
+        cv.Optional(CONF_CHARGING_SWITCH): binary_sensor.binary_sensor_schema(
+            icon=ICON_CHARGING_SWITCH
+        ),
+        cv.Optional(CONF_DISCHARGING_SWITCH): binary_sensor.binary_sensor_schema(
+            icon=ICON_DISCHARGING_SWITCH
+        ),
+        cv.Optional(CONF_BALANCING): binary_sensor.binary_sensor_schema(
+            icon=ICON_BALANCING
         ),
     }
 )
@@ -0,0 +1,38 @@
+import esphome.codegen as cg
+from esphome.components import button
+import esphome.config_validation as cv
+from esphome.const import CONF_ID
+
+from . import (
+    COMMAND_SCHEMA,
+    CONF_CID1,
+    CONF_FUNCTION,
+    CONF_SEPLOS_BMS_ID,
+    INFO_SCHEMA,
+    seplos_bms_ns,
+)
+
+DEPENDENCIES = ["seplos_bms"]
+
+CODEOWNERS = ["@syssi"]
+
+CONF_INFO = "info"
+
+SeplosButton = seplos_bms_ns.class_("SeplosButton", button.Button)
+
+CONFIG_SCHEMA = button.BUTTON_SCHEMA.extend(COMMAND_SCHEMA).extend(
+    {
+        cv.GenerateID(): cv.declare_id(SeplosButton),
+        cv.Optional(CONF_INFO, default=[]): INFO_SCHEMA,
+    }
+)
+
+
+async def to_code(config):
+    hub = await cg.get_variable(config[CONF_SEPLOS_BMS_ID])
+    var = cg.new_Pvariable(config[CONF_ID])
+    await button.register_button(var, config)
+    cg.add(var.set_parent(hub))
+    cg.add(var.set_cid1(config[CONF_CID1]))
+    cg.add(var.set_function(config[CONF_FUNCTION]))
+    cg.add(var.set_info(config[CONF_INFO]))
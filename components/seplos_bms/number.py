@@ -0,0 +1,67 @@
+import esphome.codegen as cg
+from esphome.components import number
+import esphome.config_validation as cv
+from esphome.const import CONF_ID, CONF_MAX_VALUE, CONF_MIN_VALUE, CONF_STEP
+
+from . import (
+    COMMAND_SCHEMA,
+    CONF_CID1,
+    CONF_FUNCTION,
+    CONF_SEPLOS_BMS_ID,
+    INFO_SCHEMA,
+    MAX_INFO_SIZE,
+    seplos_bms_ns,
+)
+
+DEPENDENCIES = ["seplos_bms"]
+
+CODEOWNERS = ["@syssi"]
+
+CONF_INFO_PREFIX = "info_prefix"
+CONF_MULTIPLIER = "multiplier"
+
+SeplosNumber = seplos_bms_ns.class_("SeplosNumber", number.Number)
+
+
+def validate_range(config):
+    # The value is written as uint16_t behind the prefix
+    if len(config[CONF_INFO_PREFIX]) > MAX_INFO_SIZE - 2:
+        raise cv.Invalid(f"The info prefix is limited to {MAX_INFO_SIZE - 2} bytes")
+    multiplier = config[CONF_MULTIPLIER]
+    if config[CONF_MIN_VALUE] * multiplier < 0 or config[CONF_MAX_VALUE] * multiplier > 0xFFFF:
+        raise cv.Invalid("The scaled range must fit into 0..65535")
+    if config[CONF_MIN_VALUE] >= config[CONF_MAX_VALUE]:
+        raise cv.Invalid("The min value must be smaller than the max value")
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    number.NUMBER_SCHEMA.extend(COMMAND_SCHEMA).extend(
+        {
+            cv.GenerateID(): cv.declare_id(SeplosNumber),
+            cv.Optional(CONF_INFO_PREFIX, default=[]): INFO_SCHEMA,
+            cv.Optional(CONF_MULTIPLIER, default=1.0): cv.positive_not_null_float,
+            cv.Required(CONF_MIN_VALUE): cv.float_,
+            cv.Required(CONF_MAX_VALUE): cv.float_,
+            cv.Optional(CONF_STEP, default=1.0): cv.positive_float,
+        }
+    ),
+    validate_range,
+)
+
+
+async def to_code(config):
+    hub = await cg.get_variable(config[CONF_SEPLOS_BMS_ID])
+    var = cg.new_Pvariable(config[CONF_ID])
+    await number.register_number(
+        var,
+        config,
+        min_value=config[CONF_MIN_VALUE],
+        max_value=config[CONF_MAX_VALUE],
+        step=config[CONF_STEP],
+    )
+    cg.add(var.set_parent(hub))
+    cg.add(var.set_cid1(config[CONF_CID1]))
+    cg.add(var.set_function(config[CONF_FUNCTION]))
+    cg.add(var.set_info_prefix(config[CONF_INFO_PREFIX]))
+    cg.add(var.set_multiplier(config[CONF_MULTIPLIER]))
@@ -4,18 +4,24 @@ import esphome.config_validation as cv
 from esphome.const import (
     CONF_CURRENT,
     CONF_POWER,
+    ENTITY_CATEGORY_DIAGNOSTIC,
     DEVICE_CLASS_BATTERY,
     DEVICE_CLASS_CURRENT,
     DEVICE_CLASS_EMPTY,
+    DEVICE_CLASS_ENERGY,
     DEVICE_CLASS_POWER,
     DEVICE_CLASS_TEMPERATURE,
     DEVICE_CLASS_VOLTAGE,
     ICON_EMPTY,
     STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
     UNIT_AMPERE,
     UNIT_CELSIUS,
     UNIT_EMPTY,
+    UNIT_KILOWATT_HOURS,
+    UNIT_MILLISECOND,
     UNIT_PERCENT,
+    UNIT_SECOND,
     UNIT_VOLT,
     UNIT_WATT,
 )
@@ -45,31 +51,16 @@ CONF_RATED_CAPACITY = "rated_capacity"
 CONF_CHARGING_CYCLES = "charging_cycles"
 CONF_STATE_OF_HEALTH = "state_of_health"
 CONF_PORT_VOLTAGE = "port_voltage"
-
-CONF_CELL_VOLTAGE_1 = "cell_voltage_1"
-CONF_CELL_VOLTAGE_2 = "cell_voltage_2"
-CONF_CELL_VOLTAGE_3 = "cell_voltage_3"
-CONF_CELL_VOLTAGE_4 = "cell_voltage_4"
-CONF_CELL_VOLTAGE_5 = "cell_voltage_5"
-CONF_CELL_VOLTAGE_6 = "cell_voltage_6"
-CONF_CELL_VOLTAGE_7 = "cell_voltage_7"
-CONF_CELL_VOLTAGE_8 = "cell_voltage_8"
-CONF_CELL_VOLTAGE_9 = "cell_voltage_9"
-CONF_CELL_VOLTAGE_10 = "cell_voltage_10"
-CONF_CELL_VOLTAGE_11 = "cell_voltage_11"
-CONF_CELL_VOLTAGE_12 = "cell_voltage_12"
-CONF_CELL_VOLTAGE_13 = "cell_voltage_13"
-CONF_CELL_VOLTAGE_14 = "cell_voltage_14"
-CONF_CELL_VOLTAGE_15 = "cell_voltage_15"
-CONF_CELL_VOLTAGE_16 = "cell_voltage_16"
-
-CONF_TEMPERATURE_1 = "temperature_1"
-CONF_TEMPERATURE_2 = "temperature_2"
-CONF_TEMPERATURE_3 = "temperature_3"
-CONF_TEMPERATURE_4 = "temperature_4"
-CONF_TEMPERATURE_5 = "temperature_5"
-CONF_TEMPERATURE_6 = "temperature_6"
-# CONF_TEMPERATURE_7 = "temperature_7"
+CONF_POLL_LATENCY = "poll_latency"
+CONF_POLL_TIMEOUTS = "poll_timeouts"
+CONF_MIN_POLL_LATENCY = "min_poll_latency"
+CONF_AVERAGE_POLL_LATENCY = "average_poll_latency"
+CONF_P95_POLL_LATENCY = "p95_poll_latency"
+CONF_PUBLISHES_SENT = "publishes_sent"
+CONF_PUBLISHES_SUPPRESSED = "publishes_suppressed"
+CONF_POLL_INTERVAL = "poll_interval"
+CONF_CHARGED_ENERGY = "charged_energy"
+CONF_DISCHARGED_ENERGY = "discharged_energy"
 
 ICON_CURRENT_DC = "mdi:current-dc"
 ICON_MIN_VOLTAGE_CELL = "mdi:battery-minus-outline"
@@ -80,37 +71,42 @@ ICON_RATED_CAPACITY = "mdi:battery-50"
 
 ICON_CHARGING_CYCLES = "mdi:battery-sync"
 ICON_STATE_OF_HEALTH = "mdi:heart-flash"
+ICON_POLL_LATENCY = "mdi:timer-outline"
+ICON_POLL_TIMEOUTS = "mdi:timer-alert-outline"
+ICON_PUBLISHES_SENT = "mdi:upload-network-outline"
+ICON_PUBLISHES_SUPPRESSED = "mdi:upload-off-outline"
+ICON_POLL_INTERVAL = "mdi:timer-sync-outline"
+ICON_CELL_RESISTANCE = "mdi:omega"
+ICON_CELL_DRIFT = "mdi:chart-bell-curve"
 
 UNIT_AMPERE_HOURS = "Ah"
+UNIT_MILLIOHM = "mΩ"
+UNIT_MILLIVOLT = "mV"
 
-CELLS = [
-    CONF_CELL_VOLTAGE_1,
-    CONF_CELL_VOLTAGE_2,
-    CONF_CELL_VOLTAGE_3,
-    CONF_CELL_VOLTAGE_4,
-    CONF_CELL_VOLTAGE_5,
-    CONF_CELL_VOLTAGE_6,
-    CONF_CELL_VOLTAGE_7,
-    CONF_CELL_VOLTAGE_8,
-    CONF_CELL_VOLTAGE_9,
-    CONF_CELL_VOLTAGE_10,
-    CONF_CELL_VOLTAGE_11,
-    CONF_CELL_VOLTAGE_12,
-    CONF_CELL_VOLTAGE_13,
-    CONF_CELL_VOLTAGE_14,
-    CONF_CELL_VOLTAGE_15,
-    CONF_CELL_VOLTAGE_16,
-]
+MAX_CELLS = 32
+MAX_TEMPERATURES = 12
 
-TEMPERATURES = [
-    CONF_TEMPERATURE_1,
-    CONF_TEMPERATURE_2,
-    CONF_TEMPERATURE_3,
-    CONF_TEMPERATURE_4,
-    CONF_TEMPERATURE_5,
-    CONF_TEMPERATURE_6,
-    # CONF_TEMPERATURE_7
-]
+CELLS = [f"cell_voltage_{i}" for i in range(1, MAX_CELLS + 1)]
+TEMPERATURES = [f"temperature_{i}" for i in range(1, MAX_TEMPERATURES + 1)]
+# Derived from the cell voltages and the current of the last frames
+CELL_RESISTANCES = [f"cell_resistance_{i}" for i in range(1, MAX_CELLS + 1)]
+CELL_DRIFTS = [f"cell_drift_{i}" for i in range(1, MAX_CELLS + 1)]
+
+# System parameters (CID2 0x47) in the order of SYSTEM_PARAMETER_LAYOUT: unit, device class, accuracy
+SYSTEM_PARAMETERS = {
+    "cell_high_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 3),
+    "cell_low_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 3),
+    "cell_under_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 3),
+    "charge_high_temperature_limit": (UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, 1),
+    "charge_low_temperature_limit": (UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, 1),
+    "charge_current_limit": (UNIT_AMPERE, DEVICE_CLASS_CURRENT, 2),
+    "module_high_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 2),
+    "module_low_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 2),
+    "module_under_voltage_limit": (UNIT_VOLT, DEVICE_CLASS_VOLTAGE, 2),
+    "discharge_high_temperature_limit": (UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, 1),
+    "discharge_low_temperature_limit": (UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, 1),
+    "discharge_current_limit": (UNIT_AMPERE, DEVICE_CLASS_CURRENT, 2),
+}
 
 SENSORS = [
     CONF_MIN_CELL_VOLTAGE,
@@ -131,6 +127,16 @@ SENSORS = [
     CONF_CHARGING_CYCLES,
     CONF_STATE_OF_HEALTH,
     CONF_PORT_VOLTAGE,
+    CONF_POLL_LATENCY,
+    CONF_POLL_TIMEOUTS,
+    CONF_MIN_POLL_LATENCY,
+    CONF_AVERAGE_POLL_LATENCY,
+    CONF_P95_POLL_LATENCY,
+    CONF_PUBLISHES_SENT,
+    CONF_PUBLISHES_SUPPRESSED,
+    CONF_POLL_INTERVAL,
+    CONF_CHARGED_ENERGY,
+    CONF_DISCHARGED_ENERGY,
 ]
 
 # pylint: disable=too-many-function-args
@@ -179,167 +185,6 @@ CONFIG_SCHEMA = cv.Schema(
             device_class=DEVICE_CLASS_VOLTAGE,
             state_class=STATE_CLASS_MEASUREMENT,
         ),
-        cv.Optional(CONF_CELL_VOLTAGE_1): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_2): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_3): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_4): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_5): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_6): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_7): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_8): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_9): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_10): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_11): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_12): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_13): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_14): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_15): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_CELL_VOLTAGE_16): sensor.sensor_schema(
-            unit_of_measurement=UNIT_VOLT,
-            icon=ICON_EMPTY,
-            accuracy_decimals=3,
-            device_class=DEVICE_CLASS_VOLTAGE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_1): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_2): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_3): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_4): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_5): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        cv.Optional(CONF_TEMPERATURE_6): sensor.sensor_schema(
-            unit_of_measurement=UNIT_CELSIUS,
-            icon=ICON_EMPTY,
-            accuracy_decimals=0,
-            device_class=DEVICE_CLASS_TEMPERATURE,
-            state_class=STATE_CLASS_MEASUREMENT,
-        ),
-        # cv.Optional(CONF_TEMPERATURE_7): sensor.sensor_schema(
-        #     unit_of_measurement=UNIT_CELSIUS,
-        #     icon=ICON_EMPTY,
-        #     accuracy_decimals=0,
-        #     device_class=DEVICE_CLASS_TEMPERATURE,
-        #     state_class=STATE_CLASS_MEASUREMENT,
-        # ),
         cv.Optional(CONF_TOTAL_VOLTAGE): sensor.sensor_schema(
             unit_of_measurement=UNIT_VOLT,
             icon=ICON_EMPTY,
@@ -423,22 +268,180 @@ CONFIG_SCHEMA = cv.Schema(
             device_class=DEVICE_CLASS_VOLTAGE,
             state_class=STATE_CLASS_MEASUREMENT,
         ),
+        cv.Optional(CONF_POLL_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_POLL_LATENCY,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_POLL_TIMEOUTS): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_POLL_TIMEOUTS,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_MIN_POLL_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_POLL_LATENCY,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_AVERAGE_POLL_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_POLL_LATENCY,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_P95_POLL_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_POLL_LATENCY,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_PUBLISHES_SENT): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_PUBLISHES_SENT,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_PUBLISHES_SUPPRESSED): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_PUBLISHES_SUPPRESSED,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_POLL_INTERVAL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            icon=ICON_POLL_INTERVAL,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_CHARGED_ENERGY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_KILOWATT_HOURS,
+            icon=ICON_EMPTY,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_ENERGY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_DISCHARGED_ENERGY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_KILOWATT_HOURS,
+            icon=ICON_EMPTY,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_ENERGY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
     }
+).extend(
+    {
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=UNIT_VOLT,
+            icon=ICON_EMPTY,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_VOLTAGE,
+            state_class=STATE_CLASS_MEASUREMENT,
+        )
+        for key in CELLS
+    },
+    {
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=UNIT_CELSIUS,
+            icon=ICON_EMPTY,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_TEMPERATURE,
+            state_class=STATE_CLASS_MEASUREMENT,
+        )
+        for key in TEMPERATURES
+    },
+    {
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIOHM,
+            icon=ICON_CELL_RESISTANCE,
+            accuracy_decimals=2,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        )
+        for key in CELL_RESISTANCES
+    },
+    {
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIVOLT,
+            icon=ICON_CELL_DRIFT,
+            accuracy_decimals=1,
+            device_class=DEVICE_CLASS_VOLTAGE,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        )
+        for key in CELL_DRIFTS
+    },
+    {
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=unit,
+            icon=ICON_EMPTY,
+            accuracy_decimals=accuracy,
+            device_class=device_class,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        )
+        for key, (unit, device_class, accuracy) in SYSTEM_PARAMETERS.items()
+    },
 )
 
 
 async def to_code(config):
     hub = await cg.get_variable(config[CONF_SEPLOS_BMS_ID])
+    # Allocate the slots up to the highest cell and temperature configured
+    cells = [
+        i + 1
+        for keys in (CELLS, CELL_RESISTANCES, CELL_DRIFTS)
+        for i, key in enumerate(keys)
+        if key in config
+    ]
+    if cells:
+        cg.add(hub.set_cell_count(max(cells)))
+    temperatures = [i + 1 for i, key in enumerate(TEMPERATURES) if key in config]
+    if temperatures:
+        cg.add(hub.set_temperature_count(max(temperatures)))
     for i, key in enumerate(CELLS):
         if key in config:
             conf = config[key]
             sens = await sensor.new_sensor(conf)
             cg.add(hub.set_cell_voltage_sensor(i, sens))
+    for i, key in enumerate(CELL_RESISTANCES):
+        if key in config:
+            conf = config[key]
+            sens = await sensor.new_sensor(conf)
+            cg.add(hub.set_cell_resistance_sensor(i, sens))
+    for i, key in enumerate(CELL_DRIFTS):
+        if key in config:
+            conf = config[key]
+            sens = await sensor.new_sensor(conf)
+            cg.add(hub.set_cell_drift_sensor(i, sens))
     for i, key in enumerate(TEMPERATURES):
         if key in config:
             conf = config[key]
             sens = await sensor.new_sensor(conf)
             cg.add(hub.set_temperature_sensor(i, sens))
+    for i, key in enumerate(SYSTEM_PARAMETERS):
+        if key in config:
+            conf = config[key]
+            sens = await sensor.new_sensor(conf)
+            cg.add(hub.set_system_parameter_sensor(i, sens))
     for key in SENSORS:
         if key in config:
             conf = config[key]
@@ -2,96 +2,569 @@
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
 
+#include <cinttypes>
+#include <cstring>
+
 namespace esphome {
 namespace seplos_bms {
 
 static const char *const TAG = "seplos_bms";
 
-// 协议版本定义
-#define SEPLOS_PROTOCOL_V21 0x21
-#define SEPLOS_PROTOCOL_V25 0x25
-
-// 字段偏移量配置（根据你的数据样本修正）
-typedef struct {
-  uint8_t cell_count_offset;       // 电池数量字段偏移
-  uint8_t cell_voltages_start;     // 电池电压起始偏移
-  uint8_t temp_sensor_count_offset;// 温度传感器数量偏移
-  uint8_t temp_sensors_start;      // 温度传感器起始偏移
-  uint8_t current_offset;          // 电流字段偏移
-  uint8_t total_voltage_offset;    // 总电压字段偏移
-  uint8_t residual_capacity_offset;// 剩余容量偏移
-  uint8_t battery_capacity_offset; // 电池容量偏移
-  uint8_t soc_offset;              // SOC偏移
-  uint8_t rated_capacity_offset;   // 额定容量偏移
-  uint8_t cycles_offset;           // 循环次数偏移
-  uint8_t soh_offset;              // SOH偏移
-  uint8_t port_voltage_offset;     // 端口电压偏移
-} seplos_offsets_t;
-
-// 协议版本字段映射表（修正后的 2.5 版本偏移量）
-static const std::map<uint8_t, seplos_offsets_t> OFFSET_MAP = {
-    {SEPLOS_PROTOCOL_V21,
-     {
-         .cell_count_offset = 7,
-         .cell_voltages_start = 8,
-         .temp_sensor_count_offset = 38,
-         .temp_sensors_start = 39,
-         .current_offset = 53,
-         .total_voltage_offset = 55,
-         .residual_capacity_offset = 57,
-         .battery_capacity_offset = 61,
-         .soc_offset = 63,
-         .rated_capacity_offset = 65,
-         .cycles_offset = 67,
-         .soh_offset = 69,
-         .port_voltage_offset = 71,
-     }},
-    {SEPLOS_PROTOCOL_V25,  // 根据你的数据样本修正
-     {
-         .cell_count_offset = 8,          // 数据样本中第8字节是 0x0F (15 cells)
-         .cell_voltages_start = 9,        // 电压从第9字节开始 (0x0CF9)
-         .temp_sensor_count_offset = 39,   // 第39字节是温度数量 0x06
-         .temp_sensors_start = 40,        // 温度从第40字节开始
-         .current_offset = 52,            // 电流在第52-53字节 (0x005C)
-         .total_voltage_offset = 54,       // 总电压在54-55字节 (0xC27B)
-         .residual_capacity_offset = 56,   // 剩余容量在56-57字节 (0x0801)
-         .battery_capacity_offset = 60,    // 电池容量在60-61字节 (0x0028)
-         .soc_offset = 62,                 // SOC在62-63字节 (0x0BB8)
-         .rated_capacity_offset = 64,      // 额定容量在64-65字节 (未在样本中)
-         .cycles_offset = 66,              // 循环次数在66-67字节 (未在样本中)
-         .soh_offset = 68,                 // SOH在68-69字节 (未在样本中)
-         .port_voltage_offset = 70,        // 端口电压在70-71字节 (0xE35A)
-     }}};
-
-void SeplosBms::on_seplos_modbus_data(const std::vector<uint8_t> &data) {
-  if (data.size() < 8) {
-    ESP_LOGE(TAG, "Invalid data length: %zu", data.size());
+// Field offsets of the telemetry record (CID2 0x42) per protocol version. The offsets of a dynamic layout shift
+// with the number of cells and temperature sensors: The temperature offsets are relative to the end of the cell
+// voltages and all following offsets are relative to the end of the temperatures.
+struct SeplosLayout {
+  uint8_t protocol_version;
+  bool dynamic;
+  uint16_t cell_count_offset;         // 电池数量字段偏移
+  uint16_t cell_voltages_start;       // 电池电压起始偏移
+  uint16_t temp_sensor_count_offset;  // 温度传感器数量偏移
+  uint16_t temp_sensors_start;        // 温度传感器起始偏移
+  uint16_t current_offset;            // 电流字段偏移
+  uint16_t total_voltage_offset;      // 总电压字段偏移
+  uint16_t residual_capacity_offset;  // 剩余容量偏移
+  uint16_t battery_capacity_offset;   // 电池容量偏移
+  uint16_t soc_offset;                // SOC偏移
+  uint16_t rated_capacity_offset;     // 额定容量偏移
+  uint16_t cycles_offset;             // 循环次数偏移
+  uint16_t soh_offset;                // SOH偏移
+  uint16_t port_voltage_offset;       // 端口电压偏移
+};
+
+static constexpr SeplosLayout LAYOUTS[] = {
+    {
+        .protocol_version = 0x20,
+        .dynamic = true,
+        .cell_count_offset = 8,
+        .cell_voltages_start = 9,
+        .temp_sensor_count_offset = 0,
+        .temp_sensors_start = 1,
+        .current_offset = 0,
+        .total_voltage_offset = 2,
+        .residual_capacity_offset = 4,
+        .battery_capacity_offset = 7,
+        .soc_offset = 9,
+        .rated_capacity_offset = 11,
+        .cycles_offset = 13,
+        .soh_offset = 15,
+        .port_voltage_offset = 17,
+    },
+    {
+        .protocol_version = 0x21,
+        .dynamic = false,
+        .cell_count_offset = 7,
+        .cell_voltages_start = 8,
+        .temp_sensor_count_offset = 38,
+        .temp_sensors_start = 39,
+        .current_offset = 53,
+        .total_voltage_offset = 55,
+        .residual_capacity_offset = 57,
+        .battery_capacity_offset = 61,
+        .soc_offset = 63,
+        .rated_capacity_offset = 65,
+        .cycles_offset = 67,
+        .soh_offset = 69,
+        .port_voltage_offset = 71,
+    },
+    {
+        // 根据你的数据样本修正
+        .protocol_version = 0x25,
+        .dynamic = false,
+        .cell_count_offset = 8,          // 数据样本中第8字节是 0x0F (15 cells)
+        .cell_voltages_start = 9,        // 电压从第9字节开始 (0x0CF9)
+        .temp_sensor_count_offset = 39,  // 第39字节是温度数量 0x06
+        .temp_sensors_start = 40,        // 温度从第40字节开始
+        .current_offset = 52,            // 电流在第52-53字节 (0x005C)
+        .total_voltage_offset = 54,      // 总电压在54-55字节 (0xC27B)
+        .residual_capacity_offset = 56,  // 剩余容量在56-57字节 (0x0801)
+        .battery_capacity_offset = 60,   // 电池容量在60-61字节 (0x0028)
+        .soc_offset = 62,                // SOC在62-63字节 (0x0BB8)
+        .rated_capacity_offset = 64,     // 额定容量在64-65字节 (未在样本中)
+        .cycles_offset = 66,             // 循环次数在66-67字节 (未在样本中)
+        .soh_offset = 68,                // SOH在68-69字节 (未在样本中)
+        .port_voltage_offset = 70,       // 端口电压在70-71字节 (0xE35A)
+    },
+};
+
+static const SeplosLayout *find_layout(uint8_t protocol_version) {
+  for (const auto &layout : LAYOUTS) {
+    if (layout.protocol_version == protocol_version)
+      return &layout;
+  }
+  return nullptr;
+}
+
+static const uint8_t ALARMS_SIZE = 64;
+static const char *const ALARMS[ALARMS_SIZE] = {
+    // Alarm event 1
+    "Voltage sensor fault",
+    "Temperature sensor fault",
+    "Current sensor fault",
+    "Key switch fault",
+    "Cell voltage difference sensing fault",
+    "Charging switch fault",
+    "Discharging switch fault",
+    "Current limit switch fault",
+    // Alarm event 2
+    "Cell high voltage alarm",
+    "Cell overvoltage protection",
+    "Cell low voltage alarm",
+    "Cell undervoltage protection",
+    "Total high voltage alarm",
+    "Total overvoltage protection",
+    "Total low voltage alarm",
+    "Total undervoltage protection",
+    // Alarm event 3
+    "Charging high temperature alarm",
+    "Charging overtemperature protection",
+    "Charging low temperature alarm",
+    "Charging undertemperature protection",
+    "Discharging high temperature alarm",
+    "Discharging overtemperature protection",
+    "Discharging low temperature alarm",
+    "Discharging undertemperature protection",
+    // Alarm event 4
+    "Ambient high temperature alarm",
+    "Ambient overtemperature protection",
+    "Ambient low temperature alarm",
+    "Ambient undertemperature protection",
+    "Power overtemperature protection",
+    "Power high temperature alarm",
+    "Cell low temperature heating",
+    nullptr,
+    // Alarm event 5
+    "Charging overcurrent alarm",
+    "Charging overcurrent protection",
+    "Discharging overcurrent alarm",
+    "Discharging overcurrent protection",
+    "Transient overcurrent protection",
+    "Output short circuit protection",
+    "Transient overcurrent lockout",
+    "Output short circuit lockout",
+    // Alarm event 6
+    "Charging high voltage protection",
+    "Intermittent recharge waiting",
+    "Residual capacity alarm",
+    "Residual capacity protection",
+    "Cell low voltage charging prohibition",
+    "Output reverse polarity protection",
+    "Output connection fault",
+    nullptr,
+    // Alarm event 7
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    "Automatic charging waiting",
+    "Manual charging waiting",
+    nullptr,
+    nullptr,
+    // Alarm event 8
+    "EEPROM storage fault",
+    "RTC clock fault",
+    "Voltage calibration missing",
+    "Current calibration missing",
+    "Zero point calibration missing",
+    nullptr,
+    nullptr,
+    nullptr,
+};
+
+// Thresholds among the system parameters (CID2 0x47). The response holds them as alarm/recovery and
+// protection/recovery pairs of 16 bit words starting at byte 8. The word indices follow the response captured
+// in tests/esp8266-fake-bms.yaml
+struct SystemParameter {
+  const char *name;
+  uint8_t word;
+  float coefficient;
+  float offset;
+  bool is_signed;
+};
+static const SystemParameter SYSTEM_PARAMETER_LAYOUT[SYSTEM_PARAMETERS] = {
+    {"Cell high voltage limit", 0, 0.001f, 0.0f, false},             // Alarm, 3.500 V
+    {"Cell low voltage limit", 2, 0.001f, 0.0f, false},              // Alarm, 2.900 V
+    {"Cell under voltage limit", 6, 0.001f, 0.0f, false},            // Protection, 2.600 V
+    {"Charge high temperature limit", 20, 0.1f, -273.1f, false},     // Alarm, 55.0 °C
+    {"Charge low temperature limit", 22, 0.1f, -273.1f, false},      // Alarm, 2.0 °C
+    {"Charge current limit", 50, 0.01f, 0.0f, true},                 // Alarm, 100.00 A
+    {"Module high voltage limit", 10, 0.01f, 0.0f, false},           // Alarm, 54.00 V
+    {"Module low voltage limit", 12, 0.01f, 0.0f, false},            // Alarm, 43.50 V
+    {"Module under voltage limit", 16, 0.01f, 0.0f, false},          // Protection, 39.00 V
+    {"Discharge high temperature limit", 28, 0.1f, -273.1f, false},  // Alarm, 55.0 °C
+    {"Discharge low temperature limit", 30, 0.1f, -273.1f, false},   // Alarm, -10.0 °C
+    {"Discharge current limit", 52, 0.01f, 0.0f, true},              // Alarm, -105.00 A
+};
+static const uint8_t SYSTEM_PARAMETER_WORDS = 54;
+
+// Register blocks of a V3 BMS (Modbus-RTU), see docs/XZH BMS Modbus-RTU Protocol.pdf
+static const uint16_t PACK_INFO_A = 0x1000;
+static const uint16_t PACK_INFO_B = 0x1100;
+static const uint16_t PACK_INFO_B_REGISTERS = 26;
+static const uint16_t PACK_INFO_C = 0x1200;
+static const uint16_t PACK_INFO_C_COILS = 120;
+
+static const uint8_t INFO_SYSTEM_PARAMETERS = 1 << 0;
+static const uint8_t INFO_MANUFACTURER = 1 << 1;
+static const uint8_t INFO_PROTOCOL_VERSION = 1 << 2;
+
+static uint8_t info_request(uint8_t function) {
+  switch (function) {
+    case 0x47:
+      return INFO_SYSTEM_PARAMETERS;
+    case 0x51:
+      return INFO_MANUFACTURER;
+    case 0x4F:
+      return INFO_PROTOCOL_VERSION;
+    default:
+      return 0;
+  }
+}
+
+// Fixed width ASCII field padded with spaces or NUL
+static std::string trim_ascii(const uint8_t *data, size_t length) {
+  while (length > 0 && (data[length - 1] == ' ' || data[length - 1] == 0x00))
+    length--;
+  return std::string(reinterpret_cast<const char *>(data), length);
+}
+
+void SeplosBms::setup() {
+  this->poll_interval_ = this->get_update_interval();
+
+  if (this->alarm_update_interval_ > 0) {
+    this->set_interval("alarms", this->alarm_update_interval_, [this]() { this->poll_alarms_(); });
+  }
+  if (this->info_update_interval_ > 0) {
+    this->set_interval("info", this->info_update_interval_, [this]() { this->request_info_(); });
+  }
+  if (this->fast_watch_interval_ > 0) {
+    this->set_interval("fast_watch", this->fast_watch_interval_, [this]() { this->poll_fast_watch_(); });
+  }
+
+  // The rings are allocated for the cells up to the highest one with a resistance or drift sensor
+  for (uint8_t i = 0; i < this->cells_.size(); i++) {
+    if (this->cells_[i].cell_resistance_sensor_ != nullptr || this->cells_[i].cell_drift_sensor_ != nullptr)
+      this->analytics_cells_ = i + 1;
+  }
+
+  if (this->charged_energy_sensor_ != nullptr || this->discharged_energy_sensor_ != nullptr) {
+    // The counters of a discovered pack are restored once its pack number is known
+    if (this->is_bound()) {
+      this->restore_energy_();
+    }
+    this->set_interval("energy", this->energy_save_interval_, [this]() { this->save_energy_(); });
+  }
+}
+
+void SeplosBms::on_seplos_modbus_discovered() {
+  this->layout_ = find_layout(this->protocol_version_);
+  ESP_LOGI(TAG, "Pack 0x%02X bound to address 0x%02X (protocol version 0x%02X%s)", this->pack_, this->address_,
+           this->protocol_version_, (this->layout_ == nullptr) ? ", unsupported" : "");
+
+  if (this->charged_energy_sensor_ != nullptr || this->discharged_energy_sensor_ != nullptr) {
+    this->restore_energy_();
+  }
+}
+
+// The preference is keyed by the pack number, so it's created once the device is bound
+void SeplosBms::restore_energy_() {
+  this->energy_preference_ = global_preferences->make_preference<EnergyCounters>(
+      fnv1_hash("seplos_bms_energy_" + this->energy_key_ + "_" + to_string(this->pack_)), true);
+  this->energy_preference_created_ = true;
+  if (this->energy_preference_.load(&this->analytics_.energy())) {
+    this->saved_energy_ = this->analytics_.energy();
+    ESP_LOGD(TAG, "Restored the energy counters of pack 0x%02X: %.3f kWh charged, %.3f kWh discharged", this->pack_,
+             this->analytics_.charged_energy(), this->analytics_.discharged_energy());
+  }
+}
+
+void SeplosBms::on_shutdown() {
+  if (this->charged_energy_sensor_ != nullptr || this->discharged_energy_sensor_ != nullptr) {
+    this->save_energy_();
+  }
+}
+
+void SeplosBms::on_seplos_modbus_data(uint8_t function, const uint8_t *data, uint16_t length) {
+  // The response to a command carries no INFO. Its RTN is the acknowledgement
+  if (this->complete_command_(function, true, data[3]))
+    return;
+
+  if (data[3] != 0x00) {
+    ESP_LOGW(TAG, "Request 0x%02X rejected by the BMS (RTN 0x%02X)", function, data[3]);
+    // Don't ask again for information the BMS doesn't provide
+    this->info_unsupported_ |= info_request(function);
     return;
   }
 
-  // 协议版本检测
-  const uint8_t protocol_version = data[0];
-  if (OFFSET_MAP.find(protocol_version) == OFFSET_MAP.end()) {
-    ESP_LOGW(TAG, "Unsupported protocol version: 0x%02X", protocol_version);
+  // Handler and minimum length of the response to each request. The response to 0x4F carries no INFO
+  static const struct {
+    uint8_t function;
+    uint8_t min_length;
+    void (SeplosBms::*handler)(const uint8_t *data, uint16_t length);
+  } HANDLERS[] = {
+      {0x42, 8, &SeplosBms::on_telemetry_frame_},   {0x44, 8, &SeplosBms::on_alarm_data_},
+      {0x47, 8, &SeplosBms::on_system_parameters_}, {0x4F, 6, &SeplosBms::on_protocol_version_},
+      {0x51, 8, &SeplosBms::on_manufacturer_info_},
+  };
+
+  for (const auto &entry : HANDLERS) {
+    if (entry.function != function)
+      continue;
+
+    if (length < entry.min_length) {
+      ESP_LOGE(TAG, "Invalid data length: %d", length);
+      return;
+    }
+    (this->*entry.handler)(data, length);
     return;
   }
 
-  this->on_telemetry_data_(data);
+  ESP_LOGW(TAG, "Unexpected response to request 0x%02X", function);
+}
+
+void SeplosBms::on_telemetry_frame_(const uint8_t *data, uint16_t length) {
+  // The layout of the configured protocol version is resolved once. Frames of other versions are looked up
+  const SeplosLayout *layout = (data[0] == this->protocol_version_) ? this->layout_ : find_layout(data[0]);
+  if (layout == nullptr) {
+    ESP_LOGW(TAG, "Unsupported protocol version: 0x%02X", data[0]);
+    return;
+  }
+
+  this->on_telemetry_data_(data, length, *layout);
+}
+
+void SeplosBms::on_seplos_modbus_registers(uint8_t function, uint16_t register_address, const uint8_t *data,
+                                           uint16_t length) {
+  switch (register_address) {
+    case PACK_INFO_A:
+      if (length < sizeof(this->pack_info_a_)) {
+        ESP_LOGW(TAG, "Invalid pack info A (%d bytes)", length);
+        return;
+      }
+      memcpy(this->pack_info_a_, data, sizeof(this->pack_info_a_));
+      this->pack_info_a_received_ = true;
+      return;
+    case PACK_INFO_B:
+      this->on_pack_info_b_(data, length);
+      return;
+    case PACK_INFO_C:
+      this->on_pack_info_c_(data, length);
+      return;
+    default:
+      ESP_LOGW(TAG, "Unexpected registers 0x%04X (function 0x%02X)", register_address, function);
+      return;
+  }
 }
 
-void SeplosBms::on_telemetry_data_(const std::vector<uint8_t> &data) {
+void SeplosBms::on_seplos_modbus_failure(uint8_t function) { this->complete_command_(function, false, 0x00); }
+
+void SeplosBms::execute_command(uint8_t cid1, uint8_t function, const std::vector<uint8_t> &info,
+                                std::function<void(bool)> &&callback) {
+  if (this->transport_ != seplos_modbus::TRANSPORT_ASCII) {
+    ESP_LOGE(TAG, "Commands are not supported on the Modbus-RTU transport");
+  } else if (this->commands_.size() >= MAX_PENDING_COMMANDS) {
+    ESP_LOGW(TAG, "Too many pending commands. Dropping command 0x%02X of pack 0x%02X", function, this->pack_);
+  } else {
+    ESP_LOGD(TAG, "Sending command 0x%02X 0x%02X to pack 0x%02X: %s", cid1, function, this->pack_,
+             format_hex_pretty(info).c_str());
+    this->commands_.push_back({function, std::move(callback)});
+    this->send_command(cid1, function, info.data(), info.size());
+    return;
+  }
+
+  if (callback)
+    callback(false);
+}
+
+bool SeplosBms::complete_command_(uint8_t function, bool responded, uint8_t rtn) {
+  for (auto it = this->commands_.begin(); it != this->commands_.end(); ++it) {
+    if (it->function != function)
+      continue;
+
+    const bool acknowledged = responded && rtn == 0x00;
+    if (acknowledged) {
+      ESP_LOGI(TAG, "Command 0x%02X acknowledged by pack 0x%02X", function, this->pack_);
+    } else if (responded) {
+      ESP_LOGW(TAG, "Command 0x%02X rejected by pack 0x%02X (RTN 0x%02X)", function, this->pack_, rtn);
+    } else {
+      ESP_LOGW(TAG, "Command 0x%02X to pack 0x%02X failed", function, this->pack_);
+    }
+
+    auto callback = std::move(it->callback);
+    this->commands_.erase(it);
+    if (callback)
+      callback(acknowledged);
+    return true;
+  }
+  return false;
+}
+
+void SeplosBms::set_protocol_version(uint8_t protocol_version) {
+  seplos_modbus::SeplosModbusDevice::set_protocol_version(protocol_version);
+  this->layout_ = find_layout(protocol_version);
+}
+
+void SeplosBms::on_telemetry_data_(const uint8_t *data, uint16_t length, const SeplosLayout &layout) {
   auto seplos_get_16bit = [&](size_t i) -> uint16_t {
-    return (uint16_t(data[i]) << 8) | (uint16_t(data[i + 1]) << 0); // 修复括号错误
+    return (uint16_t(data[i]) << 8) | (uint16_t(data[i + 1]) << 0);
   };
 
   const uint8_t protocol_version = data[0];
-  const seplos_offsets_t &offsets = OFFSET_MAP.at(protocol_version);
+  ESP_LOGI(TAG, "Telemetry frame v%d.%d (%d bytes)", protocol_version >> 4, protocol_version & 0x0F, length);
+  ESP_LOGVV(TAG, "  %s", format_hex_pretty(data, length).c_str());
+
+  // Resolve the offsets of this frame and validate them against the frame length once
+  SeplosLayout offsets = layout;
+  if (offsets.cell_count_offset >= length) {
+    ESP_LOGW(TAG, "Telemetry frame too short (%d bytes)", length);
+    return;
+  }
+  // The blocks of a dynamic layout follow the cell count on the wire. The override only limits the cells published
+  uint8_t cells = data[offsets.cell_count_offset];
+  uint8_t temperature_sensors;
+  if (offsets.dynamic) {
+    const uint16_t cell_voltages_end = offsets.cell_voltages_start + cells * 2;
+    offsets.temp_sensor_count_offset += cell_voltages_end;
+    offsets.temp_sensors_start += cell_voltages_end;
+    if (offsets.temp_sensor_count_offset >= length) {
+      ESP_LOGW(TAG, "Telemetry frame too short (%d bytes, %d cells)", length, cells);
+      return;
+    }
+    temperature_sensors = data[offsets.temp_sensor_count_offset];
+    const uint16_t temperatures_end = offsets.temp_sensors_start + temperature_sensors * 2;
+    offsets.current_offset += temperatures_end;
+    offsets.total_voltage_offset += temperatures_end;
+    offsets.residual_capacity_offset += temperatures_end;
+    offsets.battery_capacity_offset += temperatures_end;
+    offsets.soc_offset += temperatures_end;
+    offsets.rated_capacity_offset += temperatures_end;
+    offsets.cycles_offset += temperatures_end;
+    offsets.soh_offset += temperatures_end;
+    offsets.port_voltage_offset += temperatures_end;
+    if (this->override_cell_count_)
+      cells = std::min(cells, this->override_cell_count_);
+  } else {
+    // The blocks of a fixed layout cannot grow
+    if (offsets.temp_sensor_count_offset >= length) {
+      ESP_LOGW(TAG, "Telemetry frame too short (%d bytes)", length);
+      return;
+    }
+    temperature_sensors = data[offsets.temp_sensor_count_offset];
+    if (this->override_cell_count_)
+      cells = this->override_cell_count_;
+    cells = std::min(cells, (uint8_t) ((offsets.temp_sensor_count_offset - offsets.cell_voltages_start) / 2));
+    temperature_sensors =
+        std::min(temperature_sensors, (uint8_t) ((offsets.current_offset - offsets.temp_sensors_start) / 2));
+  }
+  // The port voltage is the last field of every layout
+  if (offsets.port_voltage_offset + 2 > length) {
+    ESP_LOGW(TAG, "Telemetry frame too short (%d of %d bytes)", length, offsets.port_voltage_offset + 2);
+    return;
+  }
+
+  RawTelemetry raw{};
+  raw.cell_voltages = data + offsets.cell_voltages_start;
+  raw.cells = cells;
+  raw.temperatures = data + offsets.temp_sensors_start;
+  raw.temperature_sensors = temperature_sensors;
+  raw.current = (int16_t) seplos_get_16bit(offsets.current_offset);
+  raw.total_voltage = seplos_get_16bit(offsets.total_voltage_offset);
+  raw.residual_capacity = seplos_get_16bit(offsets.residual_capacity_offset);
+  raw.battery_capacity = seplos_get_16bit(offsets.battery_capacity_offset);
+  raw.state_of_charge = seplos_get_16bit(offsets.soc_offset);
+  raw.rated_capacity = seplos_get_16bit(offsets.rated_capacity_offset);
+  raw.cycles = seplos_get_16bit(offsets.cycles_offset);
+  raw.state_of_health = seplos_get_16bit(offsets.soh_offset);
+  raw.port_voltage = seplos_get_16bit(offsets.port_voltage_offset);
+  this->publish_telemetry_(raw);
+}
+
+void SeplosBms::on_pack_info_b_(const uint8_t *data, uint16_t length) {
+  // Pack info A (input registers 0x1000..0x1010)
+  //   0    Pack voltage             uint16_t    10 mV
+  //   1    Current                  int16_t     10 mA
+  //   2    Remaining capacity       uint16_t    10 mAh
+  //   3    Total capacity           uint16_t    10 mAh
+  //   4    Total discharge capacity uint16_t    10 Ah
+  //   5    SOC                      uint16_t    0.1 %
+  //   6    SOH                      uint16_t    0.1 %
+  //   7    Cycles                   uint16_t
+  //   8    Average cell voltage     uint16_t    1 mV
+  //   9    Average cell temperature uint16_t    0.1 K
+  //  10    Max, min cell voltage    2 x uint16_t    1 mV
+  //  12    Max, min temperature     2 x uint16_t    0.1 K
+  //  15    Max discharge current    uint16_t    1 A
+  //  16    Max charge current       uint16_t    1 A
+  //
+  // Pack info B (input registers 0x1100..0x1119)
+  //   0    Cell voltages 1..16      16 x uint16_t   1 mV
+  //  16    Cell temperatures 1..4   4 x uint16_t    0.1 K
+  //  20    Reserved                 4 x uint16_t
+  //  24    Ambient temperature      uint16_t    0.1 K
+  //  25    Power temperature        uint16_t    0.1 K
+  if (!this->pack_info_a_received_) {
+    ESP_LOGD(TAG, "Pack info B without pack info A. Skipping");
+    return;
+  }
+  this->pack_info_a_received_ = false;
+  if (length < PACK_INFO_B_REGISTERS * 2) {
+    ESP_LOGW(TAG, "Invalid pack info B (%d bytes)", length);
+    return;
+  }
+
+  const uint8_t *pack_info_a = this->pack_info_a_;
+  auto get_register = [pack_info_a](size_t i) -> uint16_t {
+    return encode_uint16(pack_info_a[i * 2], pack_info_a[i * 2 + 1]);
+  };
+
+  // The registers of missing cells read 0 mV
+  uint8_t cells = 16;
+  if (this->override_cell_count_) {
+    cells = std::min(cells, this->override_cell_count_);
+  } else {
+    while (cells > 0 && data[(cells - 1) * 2] == 0x00 && data[(cells - 1) * 2 + 1] == 0x00)
+      cells--;
+  }
 
-  ESP_LOGI(TAG, "Telemetry frame v%d.%d (%zu bytes)", protocol_version >> 4, protocol_version & 0x0F, data.size());
-  ESP_LOGVV(TAG, "  %s", format_hex_pretty(data.data(), data.size()).c_str());
+  // The temperatures in the order of the V2 frame: Cells 1..4, ambient, power
+  uint8_t temperatures[6 * 2];
+  memcpy(temperatures, data + 16 * 2, 4 * 2);
+  memcpy(temperatures + 4 * 2, data + 24 * 2, 2 * 2);
+
+  ESP_LOGI(TAG, "Telemetry registers (%d cells)", cells);
+  RawTelemetry raw{};
+  raw.cell_voltages = data;
+  raw.cells = cells;
+  raw.temperatures = temperatures;
+  raw.temperature_sensors = 6;
+  raw.current = (int16_t) get_register(1);
+  raw.total_voltage = get_register(0);
+  raw.residual_capacity = get_register(2);
+  raw.battery_capacity = get_register(3);
+  raw.state_of_charge = get_register(5);
+  raw.cycles = get_register(7);
+  raw.state_of_health = get_register(6);
+  this->publish_telemetry_(raw);
+}
+
+void SeplosBms::publish_telemetry_(const RawTelemetry &raw) {
+  if (this->fast_watch_enabled_) {
+    this->publish_fast_watch_(raw);
+    if (!this->telemetry_requested_)
+      return;
+  }
+  this->telemetry_requested_ = false;
+
+  const uint8_t cells = raw.cells;
+  const uint8_t temperature_sensors = raw.temperature_sensors;
+
+  // Publish every value regardless of the deadbands once per heartbeat interval
+  const uint32_t now = millis();
+  this->force_publish_ = this->heartbeat_interval_ > 0 && now - this->last_heartbeat_ >= this->heartbeat_interval_;
+  if (this->force_publish_) {
+    this->last_heartbeat_ = now;
+  }
 
   // 解析电池信息
-  uint8_t cells = (this->override_cell_count_) ? this->override_cell_count_ : data[offsets.cell_count_offset];
   ESP_LOGV(TAG, "Number of cells: %d", cells);
 
   float min_cell_voltage = 100.0f;
@@ -101,16 +574,14 @@ void SeplosBms::on_telemetry_data_(const std::vector<uint8_t> &data) {
   uint8_t max_voltage_cell = 0;
 
   // 解析电池电压（根据你的数据样本）
-  for (uint8_t i = 0; i < std::min((uint8_t) 16, cells); i++) {
-    const size_t pos = offsets.cell_voltages_start + (i * 2);
-    if (pos + 1 >= data.size()) break; // 确保不越界
-
-    uint16_t raw_voltage = seplos_get_16bit(pos);
+  // The statistics cover all cells of the frame. Only the configured ones are published
+  for (uint8_t i = 0; i < cells; i++) {
+    uint16_t raw_voltage = encode_uint16(raw.cell_voltages[i * 2], raw.cell_voltages[i * 2 + 1]);
     float cell_voltage = raw_voltage * 0.001f;
     average_cell_voltage += cell_voltage;
 
     // 调试输出原始数据
-    ESP_LOGVV(TAG, "Cell %d raw: 0x%04X, voltage: %.3f V", i+1, raw_voltage, cell_voltage);
+    ESP_LOGVV(TAG, "Cell %d raw: 0x%04X, voltage: %.3f V", i + 1, raw_voltage, cell_voltage);
 
     if (cell_voltage < min_cell_voltage) {
       min_cell_voltage = cell_voltage;
@@ -120,77 +591,386 @@ void SeplosBms::on_telemetry_data_(const std::vector<uint8_t> &data) {
       max_cell_voltage = cell_voltage;
       max_voltage_cell = i + 1;
     }
-    this->publish_state_(this->cells_[i].cell_voltage_sensor_, cell_voltage);
+    if (i < this->cells_.size()) {
+      this->publish_state_(this->cells_[i].cell_voltage_sensor_, cell_voltage, this->cell_voltage_deadband_);
+    }
+  }
+  if (cells > 0) {
+    average_cell_voltage /= cells;
   }
-  average_cell_voltage /= cells;
 
   // 发布统计电压
-  this->publish_state_(this->min_cell_voltage_sensor_, min_cell_voltage);
-  this->publish_state_(this->max_cell_voltage_sensor_, max_cell_voltage);
-  this->publish_state_(this->min_voltage_cell_sensor_, (float) min_voltage_cell);
-  this->publish_state_(this->max_voltage_cell_sensor_, (float) max_voltage_cell);
-  this->publish_state_(this->delta_cell_voltage_sensor_, max_cell_voltage - min_cell_voltage);
-  this->publish_state_(this->average_cell_voltage_sensor_, average_cell_voltage);
+  this->publish_state_(this->min_cell_voltage_sensor_, min_cell_voltage, this->cell_voltage_deadband_);
+  this->publish_state_(this->max_cell_voltage_sensor_, max_cell_voltage, this->cell_voltage_deadband_);
+  this->publish_state_(this->min_voltage_cell_sensor_, (float) min_voltage_cell, 0.0f);
+  this->publish_state_(this->max_voltage_cell_sensor_, (float) max_voltage_cell, 0.0f);
+  this->publish_state_(this->delta_cell_voltage_sensor_, max_cell_voltage - min_cell_voltage,
+                       this->cell_voltage_deadband_);
+  this->publish_state_(this->average_cell_voltage_sensor_, average_cell_voltage, this->cell_voltage_deadband_);
 
   // 解析温度传感器
-  uint8_t offset = offsets.temp_sensor_count_offset;
-  if (offset >= data.size()) return;
-
-  uint8_t temperature_sensors = data[offset];
   ESP_LOGV(TAG, "Temperature sensors: %d", temperature_sensors);
 
-  for (uint8_t i = 0; i < std::min((uint8_t) 6, temperature_sensors); i++) {
-    const size_t pos = offsets.temp_sensors_start + (i * 2);
-    if (pos + 1 >= data.size()) break;
-
-    uint16_t raw_temp = seplos_get_16bit(pos);
+  float min_temperature = NAN;
+  float max_temperature = NAN;
+  for (uint8_t i = 0; i < temperature_sensors; i++) {
+    uint16_t raw_temp = encode_uint16(raw.temperatures[i * 2], raw.temperatures[i * 2 + 1]);
     float temperature = (raw_temp - 2731.0f) * 0.1f;
-    ESP_LOGVV(TAG, "Temp %d raw: 0x%04X, value: %.1f C", i+1, raw_temp, temperature);
-    this->publish_state_(this->temperatures_[i].temperature_sensor_, temperature);
-  }
-
-  // 解析电流和总电压（关键修正部分）
-  if (offsets.current_offset + 1 < data.size()) {
-    // 电流处理（有符号16位）
-    int16_t raw_current = (int16_t)seplos_get_16bit(offsets.current_offset);
-    float current = raw_current * 0.01f;
-    ESP_LOGV(TAG, "Current raw: 0x%04X (%d), value: %.2f A", 
-            raw_current, raw_current, current);
-    this->publish_state_(this->current_sensor_, current);
-
-    // 总电压处理
-    if (offsets.total_voltage_offset + 1 < data.size()) {
-      uint16_t raw_voltage = seplos_get_16bit(offsets.total_voltage_offset);
-      float total_voltage = raw_voltage * 0.01f;
-      ESP_LOGV(TAG, "Total voltage raw: 0x%04X, value: %.2f V", raw_voltage, total_voltage);
-      this->publish_state_(this->total_voltage_sensor_, total_voltage);
-
-      // 计算功率
-      float power = total_voltage * current;
-      this->publish_state_(this->power_sensor_, power);
-      this->publish_state_(this->charging_power_sensor_, std::max(0.0f, power));
-      this->publish_state_(this->discharging_power_sensor_, std::abs(std::min(0.0f, power)));
+    ESP_LOGVV(TAG, "Temp %d raw: 0x%04X, value: %.1f C", i + 1, raw_temp, temperature);
+    min_temperature = std::isnan(min_temperature) ? temperature : std::min(min_temperature, temperature);
+    max_temperature = std::isnan(max_temperature) ? temperature : std::max(max_temperature, temperature);
+    if (i < this->temperatures_.size()) {
+      this->publish_state_(this->temperatures_[i].temperature_sensor_, temperature, this->temperature_deadband_);
     }
   }
 
-  // 安全发布数据的lambda（添加调试日志）
-  auto safe_publish = [&](sensor::Sensor *sensor, size_t pos, float coeff, const char* name) {
-    if (pos + 1 < data.size()) {
-      uint16_t raw = seplos_get_16bit(pos);
-      float value = raw * coeff;
-      ESP_LOGV(TAG, "%s raw: 0x%04X, value: %.2f", name, raw, value);
-      this->publish_state_(sensor, value);
-    }
+  // 电流处理（有符号16位）
+  int16_t raw_current = raw.current;
+  float current = raw_current * 0.01f;
+  ESP_LOGV(TAG, "Current raw: 0x%04X (%d), value: %.2f A", (uint16_t) raw_current, raw_current, current);
+  this->publish_state_(this->current_sensor_, current, this->current_deadband_);
+
+  // 总电压处理
+  uint16_t raw_total_voltage = raw.total_voltage;
+  float total_voltage = raw_total_voltage * 0.01f;
+  ESP_LOGV(TAG, "Total voltage raw: 0x%04X, value: %.2f V", raw_total_voltage, total_voltage);
+  this->publish_state_(this->total_voltage_sensor_, total_voltage, this->voltage_deadband_);
+
+  // 计算功率
+  float power = total_voltage * current;
+  this->publish_state_(this->power_sensor_, power, this->power_deadband_);
+  this->publish_state_(this->charging_power_sensor_, std::max(0.0f, power), this->power_deadband_);
+  this->publish_state_(this->discharging_power_sensor_, std::abs(std::min(0.0f, power)), this->power_deadband_);
+
+  this->publish_analytics_(raw);
+
+  auto publish_16bit = [&](sensor::Sensor *sensor, uint16_t raw, float coeff, const char *name, float deadband) {
+    float value = raw * coeff;
+    ESP_LOGV(TAG, "%s raw: 0x%04X, value: %.2f", name, raw, value);
+    this->publish_state_(sensor, value, deadband);
+    return value;
   };
 
   // 解析其他参数
-  safe_publish(this->residual_capacity_sensor_, offsets.residual_capacity_offset, 0.01f, "Residual Capacity");
-  safe_publish(this->battery_capacity_sensor_, offsets.battery_capacity_offset, 0.01f, "Battery Capacity");
-  safe_publish(this->state_of_charge_sensor_, offsets.soc_offset, 0.1f, "SOC");
-  safe_publish(this->rated_capacity_sensor_, offsets.rated_capacity_offset, 0.01f, "Rated Capacity");
-  safe_publish(this->charging_cycles_sensor_, offsets.cycles_offset, 1.0f, "Cycles");
-  safe_publish(this->state_of_health_sensor_, offsets.soh_offset, 0.1f, "SOH");
-  safe_publish(this->port_voltage_sensor_, offsets.port_voltage_offset, 0.01f, "Port Voltage");
+  const float residual_capacity =
+      publish_16bit(this->residual_capacity_sensor_, raw.residual_capacity, 0.01f, "Residual Capacity", 0.0f);
+  const float battery_capacity =
+      publish_16bit(this->battery_capacity_sensor_, raw.battery_capacity, 0.01f, "Battery Capacity", 0.0f);
+  const float state_of_charge = publish_16bit(this->state_of_charge_sensor_, raw.state_of_charge, 0.1f, "SOC", 0.0f);
+  if (raw.rated_capacity.has_value()) {
+    const uint16_t rated_capacity = *raw.rated_capacity;
+    publish_16bit(this->rated_capacity_sensor_, rated_capacity, 0.01f, "Rated Capacity", 0.0f);
+
+    // A changed rated capacity means the BMS was reconfigured
+    if (this->rated_capacity_ != 0 && rated_capacity != this->rated_capacity_) {
+      ESP_LOGI(TAG, "Rated capacity of pack 0x%02X changed. Refreshing the system parameters", this->pack_);
+      this->request_info_();
+    }
+    this->rated_capacity_ = rated_capacity;
+  }
+  publish_16bit(this->charging_cycles_sensor_, raw.cycles, 1.0f, "Cycles", 0.0f);
+  const float state_of_health = publish_16bit(this->state_of_health_sensor_, raw.state_of_health, 0.1f, "SOH", 0.0f);
+  if (raw.port_voltage.has_value()) {
+    publish_16bit(this->port_voltage_sensor_, *raw.port_voltage, 0.01f, "Port Voltage", this->voltage_deadband_);
+  }
+
+  SeplosTelemetry telemetry{};
+  telemetry.pack = this->pack_;
+  telemetry.packs = 1;
+  telemetry.cells = cells;
+  telemetry.min_cell_voltage = min_cell_voltage;
+  telemetry.max_cell_voltage = max_cell_voltage;
+  telemetry.min_temperature = min_temperature;
+  telemetry.max_temperature = max_temperature;
+  telemetry.current = current;
+  telemetry.total_voltage = total_voltage;
+  telemetry.residual_capacity = residual_capacity;
+  telemetry.battery_capacity = battery_capacity;
+  telemetry.state_of_charge = state_of_charge;
+  telemetry.state_of_health = state_of_health;
+  telemetry.alarm_bitmask = this->alarm_bitmask_;
+  telemetry.alarms_received = this->alarms_received_;
+  telemetry.cell_voltages = raw.cell_voltages;
+  telemetry.temperature_sensors = temperature_sensors;
+  telemetry.temperatures = raw.temperatures;
+  this->telemetry_callback_.call(telemetry);
+
+  if (this->max_poll_interval_ > 0) {
+    this->adapt_poll_interval_(std::fabs(current) >= this->current_threshold_ ||
+                               max_cell_voltage - min_cell_voltage >= this->cell_voltage_delta_threshold_ ||
+                               this->alarm_bitmask_ != 0);
+  }
+}
+
+void SeplosBms::publish_analytics_(const RawTelemetry &raw) {
+  if (this->charged_energy_sensor_ == nullptr && this->discharged_energy_sensor_ == nullptr &&
+      this->analytics_cells_ == 0)
+    return;
+
+  this->analytics_.resize(std::min(raw.cells, this->analytics_cells_));
+  this->analytics_.add_sample(millis(), raw.cell_voltages, raw.cells, raw.current, raw.total_voltage);
+  this->publish_state_(this->charged_energy_sensor_, this->analytics_.charged_energy(), 0.0f);
+  this->publish_state_(this->discharged_energy_sensor_, this->analytics_.discharged_energy(), 0.0f);
+
+  // The trends move slowly. They are published once per window of samples only
+  if (!this->analytics_.is_window_end())
+    return;
+  for (uint8_t i = 0; i < this->analytics_.cells(); i++) {
+    const float resistance = this->analytics_.cell_resistance(i);
+    if (!std::isnan(resistance)) {
+      this->publish_state_(this->cells_[i].cell_resistance_sensor_, resistance, 0.0f);
+    }
+    this->publish_state_(this->cells_[i].cell_drift_sensor_, this->analytics_.cell_drift(i), 0.0f);
+  }
+}
+
+void SeplosBms::save_energy_() {
+  // Not bound by the discovery yet
+  if (!this->energy_preference_created_)
+    return;
+
+  const EnergyCounters &energy = this->analytics_.energy();
+  if (energy.charged == this->saved_energy_.charged && energy.discharged == this->saved_energy_.discharged)
+    return;
+
+  if (this->energy_preference_.save(&energy)) {
+    this->saved_energy_ = energy;
+  } else {
+    ESP_LOGW(TAG, "Saving the energy counters of pack 0x%02X failed", this->pack_);
+  }
+}
+
+void SeplosBms::publish_fast_watch_(const RawTelemetry &raw) {
+  if (this->fast_watch_text_sensor_ == nullptr)
+    return;
+
+  // {"t":<uptime ms>,"u":<total voltage 10 mV>,"i":<current 10 mA>,"c":[<cell voltage mV>,...]}
+  char value[16];
+  std::string &payload = this->fast_watch_payload_;
+  snprintf(value, sizeof(value), "%" PRIu32, millis());
+  payload.assign("{\"t\":").append(value);
+  snprintf(value, sizeof(value), "%u", raw.total_voltage);
+  payload.append(",\"u\":").append(value);
+  snprintf(value, sizeof(value), "%d", raw.current);
+  payload.append(",\"i\":").append(value).append(",\"c\":[");
+  for (uint8_t i = 0; i < raw.cells; i++) {
+    snprintf(value, sizeof(value), "%s%u", (i > 0) ? "," : "",
+             encode_uint16(raw.cell_voltages[i * 2], raw.cell_voltages[i * 2 + 1]));
+    payload.append(value);
+  }
+  payload.append("]}");
+  this->fast_watch_text_sensor_->publish_state(payload);
+}
+
+void SeplosBms::poll_fast_watch_() {
+  if (!this->fast_watch_enabled_)
+    return;
+
+  // The protocols have no request for a subset of the telemetry. The blocks of the regular poll are read
+  if (this->transport_ == seplos_modbus::TRANSPORT_MODBUS_RTU) {
+    this->read_registers(0x04, PACK_INFO_A, PACK_INFO_A_REGISTERS);
+    this->read_registers(0x04, PACK_INFO_B, PACK_INFO_B_REGISTERS);
+  } else {
+    // Other packs of a batch poll keep their schedule
+    this->send_direct(0x42, this->pack_);
+  }
+}
+
+void SeplosBms::adapt_poll_interval_(bool active) {
+  const uint32_t poll_interval =
+      active ? this->get_update_interval() : std::min(this->poll_interval_ * 2, this->max_poll_interval_);
+  if (poll_interval != this->poll_interval_) {
+    ESP_LOGD(TAG, "Poll interval of pack 0x%02X: %" PRIu32 " ms", this->pack_, poll_interval);
+    this->poll_interval_ = poll_interval;
+  }
+}
+
+void SeplosBms::on_alarm_data_(const uint8_t *data, uint16_t length) {
+  // -> 0x20 0x00 0x46 0x00 0xA0 0x60 0x00 0x01 0x0F 0x00 ... 0x06 0x00 ... 0x00 0x00 0x14 0x00 ...
+  //   0    Protocol version         uint8_t     0x20
+  //   1    Device address           uint8_t     0x00
+  //   2    Device type              uint8_t     0x46
+  //   3    Function code            uint8_t     0x00    Response
+  //   4    Data length              uint16_t    0xA060
+  //   6    Data flag                uint8_t     0x00
+  //   7    Command group            uint8_t     0x01
+  //   8    Number of cells M        uint8_t     0x0F
+  //   9    Cell alarms              M bytes             0x00: normal, 0x01: below limit, 0x02: above limit
+  //        Number of temperatures N uint8_t     0x06
+  //        Temperature alarms       N bytes
+  //        Current alarm            uint8_t
+  //        Total voltage alarm      uint8_t
+  //        Number of custom alarms  uint8_t     0x14
+  //        Alarm event 1..6         6 bytes
+  //        On-off state             uint8_t     0x03    Bit 0: discharging switch, bit 1: charging switch
+  //        Equilibrium state 1..2   2 bytes             Balancing cells 1-8 and 9-16
+  //        System state             uint8_t     0x02
+  //        Disconnection state 1..2 2 bytes
+  //        Alarm event 7..8         2 bytes
+  uint16_t offset = 8;
+  if (offset >= length)
+    return;
+  offset += 1 + data[offset];
+  if (offset >= length)
+    return;
+  offset += 1 + data[offset] + 2;
+  if (offset >= length || data[offset] < 14 || offset + 14 >= length) {
+    ESP_LOGW(TAG, "Invalid alarm frame (%d bytes)", length);
+    return;
+  }
+  const uint8_t *custom = data + offset + 1;
+
+  uint64_t alarm_bitmask = 0;
+  const uint8_t events[8] = {custom[0], custom[1], custom[2], custom[3], custom[4], custom[5], custom[12], custom[13]};
+  for (uint8_t i = 0; i < 8; i++) {
+    alarm_bitmask |= uint64_t(events[i]) << (i * 8);
+  }
+  this->publish_alarms_(alarm_bitmask, custom[6], custom[7] != 0x00 || custom[8] != 0x00);
+}
+
+void SeplosBms::on_pack_info_c_(const uint8_t *data, uint16_t length) {
+  // Pack info C (coils 0x1200..0x1277), 8 coils per byte
+  //   0    Cell 1..8, 9..16 low voltage alarm       2 bytes
+  //   2    Cell 1..8, 9..16 high voltage alarm      2 bytes
+  //   4    Cell 1..8 low, high temperature alarm    2 bytes
+  //   6    Cell 1..8, 9..16 equalization            2 bytes
+  //   8    System state                             TB09
+  //   9    Voltage event                            TB02
+  //  10    Cell temperature event                   TB03
+  //  11    Ambient and power temperature event      TB04
+  //  12    Current event 1                          TB05
+  //  13    Current event 2                          TB16
+  //  14    Residual capacity                        TB06
+  //
+  // The events TB02..TB05 share the bit layout of the alarm events 2..5 of the V2 alarm frame
+  if (length < PACK_INFO_C_COILS / 8) {
+    ESP_LOGW(TAG, "Invalid pack info C (%d bytes)", length);
+    return;
+  }
+
+  uint64_t alarm_bitmask = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    alarm_bitmask |= uint64_t(data[9 + i]) << ((i + 1) * 8);
+  }
+  this->publish_alarms_(alarm_bitmask, this->switch_state_, data[6] != 0x00 || data[7] != 0x00);
+}
+
+void SeplosBms::publish_alarms_(uint64_t alarm_bitmask, uint8_t switch_state, bool balancing) {
+  if (this->alarms_received_ && alarm_bitmask == this->alarm_bitmask_ && switch_state == this->switch_state_ &&
+      balancing == this->balancing_) {
+    return;
+  }
+
+  ESP_LOGI(TAG, "Alarm state changed (alarms 0x%08X%08X, switches 0x%02X)", (unsigned) (alarm_bitmask >> 32),
+           (unsigned) alarm_bitmask, switch_state);
+  this->alarms_received_ = true;
+  this->alarm_bitmask_ = alarm_bitmask;
+  if (this->max_poll_interval_ > 0 && alarm_bitmask != 0) {
+    this->adapt_poll_interval_(true);
+  }
+  this->switch_state_ = switch_state;
+  this->balancing_ = balancing;
+
+  this->publish_state_(this->errors_text_sensor_, this->alarm_bitmask_to_string_(alarm_bitmask));
+  // The pack info of a V3 BMS doesn't carry the switch state
+  if (this->transport_ == seplos_modbus::TRANSPORT_ASCII) {
+    this->publish_state_(this->discharging_switch_binary_sensor_, switch_state & (1 << 0));
+    this->publish_state_(this->charging_switch_binary_sensor_, switch_state & (1 << 1));
+  }
+  this->publish_state_(this->balancing_binary_sensor_, balancing);
+}
+
+void SeplosBms::poll_alarms_() {
+  if (this->transport_ == seplos_modbus::TRANSPORT_MODBUS_RTU) {
+    this->read_registers(0x01, PACK_INFO_C, PACK_INFO_C_COILS);
+  } else {
+    this->send(0x44, this->pack_);
+  }
+}
+
+void SeplosBms::on_system_parameters_(const uint8_t *data, uint16_t length) {
+  // -> 0x20 0x00 0x46 0x00 0x81 0x52 0x01 0x3C 0x0D 0xAC 0x0D 0x48 0x0B 0x54 0x0B 0xB8 0x0E 0x42 ...
+  //   0    Header (VER, ADR, CID1, RTN, LENGTH)
+  //   6    Info flag                uint8_t
+  //   7    Unknown                  uint8_t             0x3C
+  //   8    Parameters               uint16_t words      See SYSTEM_PARAMETER_LAYOUT
+  if (length < 8 + SYSTEM_PARAMETER_WORDS * 2) {
+    ESP_LOGW(TAG, "Invalid system parameters frame (%d bytes)", length);
+    return;
+  }
+
+  for (uint8_t i = 0; i < SYSTEM_PARAMETERS; i++) {
+    const SystemParameter &parameter = SYSTEM_PARAMETER_LAYOUT[i];
+    const uint16_t raw = encode_uint16(data[8 + parameter.word * 2], data[9 + parameter.word * 2]);
+    if (this->system_parameters_received_ && raw == this->system_parameters_[i])
+      continue;
+
+    this->system_parameters_[i] = raw;
+    const float value =
+        (parameter.is_signed ? (float) (int16_t) raw : (float) raw) * parameter.coefficient + parameter.offset;
+    ESP_LOGD(TAG, "%s: %.3f", parameter.name, value);
+    this->publish_state_(this->system_parameter_sensors_[i], value);
+  }
+  this->system_parameters_received_ = true;
+}
+
+void SeplosBms::on_manufacturer_info_(const uint8_t *data, uint16_t length) {
+  // -> 0x20 0x00 0x46 0x00 0xC0 0x40 0x31 0x31 0x30 0x31 0x2D 0x53 0x50 0x31 0x35 0x20 0x02 0x07 0x43 0x41 ...
+  //   0    Header (VER, ADR, CID1, RTN, LENGTH)
+  //   6    Device name              10 chars            1101-SP15
+  //  16    Software version         2 bytes             2.7
+  //  18    Manufacturer name        20 chars            CANProtocol:Sofar
+  if (length < 6 + sizeof(this->manufacturer_info_)) {
+    ESP_LOGW(TAG, "Invalid manufacturer info frame (%d bytes)", length);
+    return;
+  }
+
+  const uint8_t *info = data + 6;
+  if (this->manufacturer_info_received_ &&
+      memcmp(info, this->manufacturer_info_, sizeof(this->manufacturer_info_)) == 0) {
+    return;
+  }
+
+  memcpy(this->manufacturer_info_, info, sizeof(this->manufacturer_info_));
+  this->manufacturer_info_received_ = true;
+
+  char software_version[8];
+  snprintf(software_version, sizeof(software_version), "%d.%d", info[10], info[11]);
+  ESP_LOGI(TAG, "Manufacturer info changed (%s %s)", trim_ascii(info, 10).c_str(), software_version);
+  this->publish_state_(this->device_name_text_sensor_, trim_ascii(info, 10));
+  this->publish_state_(this->software_version_text_sensor_, software_version);
+  this->publish_state_(this->manufacturer_name_text_sensor_, trim_ascii(info + 12, 20));
+}
+
+// The protocol version is the VER of the header
+void SeplosBms::on_protocol_version_(const uint8_t *data, uint16_t length) {
+  const uint8_t protocol_version = data[0];
+  if (protocol_version == this->info_protocol_version_)
+    return;
+
+  this->info_protocol_version_ = protocol_version;
+  char version[8];
+  snprintf(version, sizeof(version), "%d.%d", protocol_version >> 4, protocol_version & 0x0F);
+  this->publish_state_(this->protocol_version_text_sensor_, version);
+}
+
+void SeplosBms::request_info_() {
+  // Only ask for what is configured and supported
+  bool system_parameters = false;
+  for (auto *sensor : this->system_parameter_sensors_) {
+    system_parameters |= sensor != nullptr;
+  }
+  if (system_parameters && !(this->info_unsupported_ & INFO_SYSTEM_PARAMETERS)) {
+    this->send(0x47);
+  }
+  if ((this->device_name_text_sensor_ != nullptr || this->software_version_text_sensor_ != nullptr ||
+       this->manufacturer_name_text_sensor_ != nullptr) &&
+      !(this->info_unsupported_ & INFO_MANUFACTURER)) {
+    this->send(0x51);
+  }
+  if (this->protocol_version_text_sensor_ != nullptr && !(this->info_unsupported_ & INFO_PROTOCOL_VERSION)) {
+    this->send(0x4F);
+  }
 }
 
 void SeplosBms::dump_config() {
@@ -200,29 +980,12 @@ void SeplosBms::dump_config() {
   LOG_SENSOR("", "Minimum Voltage Cell", this->min_voltage_cell_sensor_);
   LOG_SENSOR("", "Maximum Voltage Cell", this->max_voltage_cell_sensor_);
   LOG_SENSOR("", "Delta Cell Voltage", this->delta_cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 1", this->cells_[0].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 2", this->cells_[1].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 3", this->cells_[2].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 4", this->cells_[3].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 5", this->cells_[4].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 6", this->cells_[5].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 7", this->cells_[6].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 8", this->cells_[7].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 9", this->cells_[8].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 10", this->cells_[9].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 11", this->cells_[10].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 12", this->cells_[11].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 13", this->cells_[12].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 14", this->cells_[13].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 15", this->cells_[14].cell_voltage_sensor_);
-  LOG_SENSOR("", "Cell Voltage 16", this->cells_[15].cell_voltage_sensor_);
-  LOG_SENSOR("", "Temperature 1", this->temperatures_[0].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 2", this->temperatures_[1].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 3", this->temperatures_[2].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 4", this->temperatures_[3].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 5", this->temperatures_[4].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 6", this->temperatures_[5].temperature_sensor_);
-  LOG_SENSOR("", "Temperature 7", this->temperatures_[6].temperature_sensor_);
+  for (auto &cell : this->cells_) {
+    LOG_SENSOR("", "Cell Voltage", cell.cell_voltage_sensor_);
+  }
+  for (auto &temperature : this->temperatures_) {
+    LOG_SENSOR("", "Temperature", temperature.temperature_sensor_);
+  }
   LOG_SENSOR("", "Total Voltage", this->total_voltage_sensor_);
   LOG_SENSOR("", "Current", this->current_sensor_);
   LOG_SENSOR("", "Power", this->power_sensor_);
@@ -236,6 +999,56 @@ void SeplosBms::dump_config() {
   LOG_SENSOR("", "Charging cycles", this->charging_cycles_sensor_);
   LOG_SENSOR("", "State of health", this->state_of_health_sensor_);
   LOG_SENSOR("", "Port Voltage", this->port_voltage_sensor_);
+  for (auto *system_parameter_sensor : this->system_parameter_sensors_) {
+    LOG_SENSOR("", "System Parameter", system_parameter_sensor);
+  }
+  LOG_TEXT_SENSOR("", "Errors", this->errors_text_sensor_);
+  LOG_TEXT_SENSOR("", "Device Name", this->device_name_text_sensor_);
+  LOG_TEXT_SENSOR("", "Software Version", this->software_version_text_sensor_);
+  LOG_TEXT_SENSOR("", "Manufacturer Name", this->manufacturer_name_text_sensor_);
+  LOG_TEXT_SENSOR("", "Protocol Version", this->protocol_version_text_sensor_);
+  LOG_TEXT_SENSOR("", "Fast Watch", this->fast_watch_text_sensor_);
+  LOG_BINARY_SENSOR("", "Charging Switch", this->charging_switch_binary_sensor_);
+  LOG_BINARY_SENSOR("", "Discharging Switch", this->discharging_switch_binary_sensor_);
+  LOG_BINARY_SENSOR("", "Balancing", this->balancing_binary_sensor_);
+  LOG_SENSOR("", "Poll Latency", this->poll_latency_sensor_);
+  LOG_SENSOR("", "Poll Timeouts", this->poll_timeouts_sensor_);
+  LOG_SENSOR("", "Minimum Poll Latency", this->min_poll_latency_sensor_);
+  LOG_SENSOR("", "Average Poll Latency", this->average_poll_latency_sensor_);
+  LOG_SENSOR("", "P95 Poll Latency", this->p95_poll_latency_sensor_);
+  LOG_SENSOR("", "Publishes Sent", this->publishes_sent_sensor_);
+  LOG_SENSOR("", "Publishes Suppressed", this->publishes_suppressed_sensor_);
+  LOG_SENSOR("", "Poll Interval", this->poll_interval_sensor_);
+  LOG_SENSOR("", "Charged Energy", this->charged_energy_sensor_);
+  LOG_SENSOR("", "Discharged Energy", this->discharged_energy_sensor_);
+  for (auto &cell : this->cells_) {
+    LOG_SENSOR("", "Cell Resistance", cell.cell_resistance_sensor_);
+    LOG_SENSOR("", "Cell Drift", cell.cell_drift_sensor_);
+  }
+  if (this->max_poll_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Adaptive polling: max interval %" PRIu32 " ms, current %.1f A, cell voltage delta %.3f V",
+                  this->max_poll_interval_, this->current_threshold_, this->cell_voltage_delta_threshold_);
+  }
+  ESP_LOGCONFIG(TAG, "  Transport: %s",
+                (this->transport_ == seplos_modbus::TRANSPORT_MODBUS_RTU) ? "Modbus-RTU" : "ASCII");
+  if (!this->is_bound()) {
+    ESP_LOGCONFIG(TAG, "  Address and protocol version: discovering");
+  } else {
+    ESP_LOGCONFIG(TAG, "  Protocol version: 0x%02X%s", this->protocol_version_,
+                  (this->layout_ == nullptr) ? " (unsupported)" : "");
+  }
+  ESP_LOGCONFIG(TAG, "  Heartbeat interval: %" PRIu32 " ms", this->heartbeat_interval_);
+  if (this->fast_watch_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Fast watch: %" PRIu32 " ms%s", this->fast_watch_interval_,
+                  this->fast_watch_enabled_ ? "" : " (disabled)");
+  }
+  ESP_LOGCONFIG(TAG, "  Info update interval: %" PRIu32 " ms", this->info_update_interval_);
+  if (this->charged_energy_sensor_ != nullptr || this->discharged_energy_sensor_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Energy save interval: %" PRIu32 " ms", this->energy_save_interval_);
+  }
+  ESP_LOGCONFIG(TAG, "  Deadbands: cell voltage %.3f V, voltage %.2f V, current %.2f A, power %.1f W, temperature %.1f C",
+                this->cell_voltage_deadband_, this->voltage_deadband_, this->current_deadband_, this->power_deadband_,
+                this->temperature_deadband_);
 }
 
 float SeplosBms::get_setup_priority() const {
@@ -243,7 +1056,57 @@ float SeplosBms::get_setup_priority() const {
   return setup_priority::BUS - 1.0f;
 }
 
-void SeplosBms::update() { this->send(0x42, this->pack_); }
+void SeplosBms::update() {
+  // The address or protocol version is still to be discovered
+  if (!this->is_bound())
+    return;
+
+  // With adaptive polling the update interval is the tick of the schedule. Half a tick of jitter is tolerated
+  if (this->max_poll_interval_ > 0) {
+    const uint32_t now = millis();
+    if (this->last_poll_ != 0 && now - this->last_poll_ + this->get_update_interval() / 2 < this->poll_interval_)
+      return;
+    this->last_poll_ = now;
+  }
+  this->publish_state_(this->poll_interval_sensor_, this->poll_interval_ * 0.001f);
+
+  // Bus statistics of the previous poll cycle
+  const seplos_modbus::PollStatistics statistics = this->parent_->get_poll_statistics(this);
+  if (statistics.latency > 0) {
+    this->publish_state_(this->poll_latency_sensor_, (float) statistics.latency);
+  }
+  if (statistics.latencies.count() > 0) {
+    this->publish_state_(this->min_poll_latency_sensor_, (float) statistics.latencies.min());
+    this->publish_state_(this->average_poll_latency_sensor_, statistics.latencies.average());
+    this->publish_state_(this->p95_poll_latency_sensor_, (float) statistics.latencies.percentile(0.95f));
+  }
+  this->publish_state_(this->poll_timeouts_sensor_, (float) statistics.timeouts);
+  this->publish_state_(this->publishes_sent_sensor_, (float) this->publishes_sent_);
+  this->publish_state_(this->publishes_suppressed_sensor_, (float) this->publishes_suppressed_);
+
+  this->telemetry_requested_ = true;
+  if (this->transport_ == seplos_modbus::TRANSPORT_MODBUS_RTU) {
+    // Two block reads instead of a transaction per register
+    this->read_registers(0x04, PACK_INFO_A, PACK_INFO_A_REGISTERS);
+    this->read_registers(0x04, PACK_INFO_B, PACK_INFO_B_REGISTERS);
+  } else {
+    this->send(0x42, this->pack_);
+
+    // The static configuration is fetched once the bus is up and refreshed lazily afterwards
+    if (!this->info_requested_) {
+      this->info_requested_ = true;
+      this->request_info_();
+    }
+  }
+
+  // Poll the alarms along with the telemetry if there is no dedicated schedule
+  if (this->alarm_update_interval_ == 0 &&
+      (this->alarms_required_ || this->errors_text_sensor_ != nullptr ||
+       this->charging_switch_binary_sensor_ != nullptr || this->discharging_switch_binary_sensor_ != nullptr ||
+       this->balancing_binary_sensor_ != nullptr)) {
+    this->poll_alarms_();
+  }
+}
 
 void SeplosBms::publish_state_(binary_sensor::BinarySensor *binary_sensor, const bool &state) {
   if (binary_sensor == nullptr)
@@ -256,7 +1119,24 @@ void SeplosBms::publish_state_(sensor::Sensor *sensor, float value) {
   if (sensor == nullptr)
     return;
 
-  sensor->publish_state(value);
+  this->parent_->publish_sensor_state(sensor, value);
+}
+
+void SeplosBms::publish_state_(sensor::Sensor *sensor, float value, float deadband) {
+  if (sensor == nullptr)
+    return;
+
+  // Compared to the last value handed over by this component, which may still wait for the publish budget.
+  // Without a heartbeat only a deadband holds values back, with one also an unchanged value
+  float last_value;
+  if (!this->force_publish_ && (deadband > 0.0f || this->heartbeat_interval_ > 0) &&
+      this->parent_->get_sensor_state(sensor, &last_value) && std::fabs(last_value - value) <= deadband) {
+    this->publishes_suppressed_++;
+    return;
+  }
+
+  this->publishes_sent_++;
+  this->parent_->publish_sensor_state(sensor, value);
 }
 
 void SeplosBms::publish_state_(text_sensor::TextSensor *text_sensor, const std::string &state) {
@@ -266,5 +1146,21 @@ void SeplosBms::publish_state_(text_sensor::TextSensor *text_sensor, const std::
   text_sensor->publish_state(state);
 }
 
+std::string SeplosBms::alarm_bitmask_to_string_(uint64_t mask) {
+  std::string values = "";
+  if (mask) {
+    for (uint8_t i = 0; i < ALARMS_SIZE; i++) {
+      if ((mask & (uint64_t(1) << i)) && ALARMS[i] != nullptr) {
+        values.append(ALARMS[i]);
+        values.append(";");
+      }
+    }
+    if (!values.empty()) {
+      values.pop_back();
+    }
+  }
+  return values;
+}
+
 }  // namespace seplos_bms
 }  // namespace esphome
@@ -1,18 +1,59 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/text_sensor/text_sensor.h"
 #include "esphome/components/seplos_modbus/seplos_modbus.h"
+#include "analytics.h"
+
+#include <vector>
 
 namespace esphome {
 namespace seplos_bms {
 
+struct SeplosLayout;
+
+static const uint8_t SYSTEM_PARAMETERS = 12;
+static const uint8_t PACK_INFO_A_REGISTERS = 17;
+static const uint8_t MAX_PENDING_COMMANDS = 8;
+
+// The values of a telemetry frame handed to the subscribers of a pack
+struct SeplosTelemetry {
+  uint8_t pack;
+  uint8_t packs;  // Number of packs summarized by the values
+  uint8_t cells;
+  float min_cell_voltage;
+  float max_cell_voltage;
+  float min_temperature;  // NAN without temperature sensors
+  float max_temperature;
+  float current;
+  float total_voltage;
+  float residual_capacity;
+  float battery_capacity;
+  float state_of_charge;
+  float state_of_health;
+  uint64_t alarm_bitmask;  // Alarm events 1..8 of the last alarm frame, see ALARMS
+  bool alarms_received;    // The alarm bitmask is 0 until the first alarm frame
+  // The values of the frame in the units on the wire. Only valid during the callback, nullptr for a bank
+  const uint8_t *cell_voltages;  // uint16_t big endian, 1 mV
+  uint8_t temperature_sensors;
+  const uint8_t *temperatures;  // uint16_t big endian, 0.1 K
+};
+
 class SeplosBms : public PollingComponent, public seplos_modbus::SeplosModbusDevice {
  public:
-  void set_fan_running_binary_sensor(binary_sensor::BinarySensor *fan_running_binary_sensor) {
-    fan_running_binary_sensor_ = fan_running_binary_sensor;
+  void set_charging_switch_binary_sensor(binary_sensor::BinarySensor *charging_switch_binary_sensor) {
+    charging_switch_binary_sensor_ = charging_switch_binary_sensor;
+  }
+  void set_discharging_switch_binary_sensor(binary_sensor::BinarySensor *discharging_switch_binary_sensor) {
+    discharging_switch_binary_sensor_ = discharging_switch_binary_sensor;
+  }
+  void set_balancing_binary_sensor(binary_sensor::BinarySensor *balancing_binary_sensor) {
+    balancing_binary_sensor_ = balancing_binary_sensor;
   }
 
   void set_min_cell_voltage_sensor(sensor::Sensor *min_cell_voltage_sensor) {
@@ -33,12 +74,31 @@ class SeplosBms : public PollingComponent, public seplos_modbus::SeplosModbusDev
   void set_average_cell_voltage_sensor(sensor::Sensor *average_cell_voltage_sensor) {
     average_cell_voltage_sensor_ = average_cell_voltage_sensor;
   }
+  // The slots are allocated once by the code generation up to the highest cell and temperature configured
+  void set_cell_count(uint8_t cell_count) {
+    if (cell_count > this->cells_.size())
+      this->cells_.resize(cell_count);
+  }
+  void set_temperature_count(uint8_t temperature_count) {
+    if (temperature_count > this->temperatures_.size())
+      this->temperatures_.resize(temperature_count);
+  }
   void set_cell_voltage_sensor(uint8_t cell, sensor::Sensor *cell_voltage_sensor) {
+    this->set_cell_count(cell + 1);
     this->cells_[cell].cell_voltage_sensor_ = cell_voltage_sensor;
   }
   void set_temperature_sensor(uint8_t temperature, sensor::Sensor *temperature_sensor) {
+    this->set_temperature_count(temperature + 1);
     this->temperatures_[temperature].temperature_sensor_ = temperature_sensor;
   }
+  void set_cell_resistance_sensor(uint8_t cell, sensor::Sensor *cell_resistance_sensor) {
+    this->set_cell_count(cell + 1);
+    this->cells_[cell].cell_resistance_sensor_ = cell_resistance_sensor;
+  }
+  void set_cell_drift_sensor(uint8_t cell, sensor::Sensor *cell_drift_sensor) {
+    this->set_cell_count(cell + 1);
+    this->cells_[cell].cell_drift_sensor_ = cell_drift_sensor;
+  }
   void set_total_voltage_sensor(sensor::Sensor *total_voltage_sensor) { total_voltage_sensor_ = total_voltage_sensor; }
   void set_current_sensor(sensor::Sensor *current_sensor) { current_sensor_ = current_sensor; }
   void set_power_sensor(sensor::Sensor *power_sensor) { power_sensor_ = power_sensor; }
@@ -67,19 +127,109 @@ class SeplosBms : public PollingComponent, public seplos_modbus::SeplosModbusDev
     state_of_health_sensor_ = state_of_health_sensor;
   }
   void set_port_voltage_sensor(sensor::Sensor *port_voltage_sensor) { port_voltage_sensor_ = port_voltage_sensor; }
+  void set_poll_latency_sensor(sensor::Sensor *poll_latency_sensor) { poll_latency_sensor_ = poll_latency_sensor; }
+  void set_poll_timeouts_sensor(sensor::Sensor *poll_timeouts_sensor) { poll_timeouts_sensor_ = poll_timeouts_sensor; }
+  void set_min_poll_latency_sensor(sensor::Sensor *min_poll_latency_sensor) {
+    min_poll_latency_sensor_ = min_poll_latency_sensor;
+  }
+  void set_average_poll_latency_sensor(sensor::Sensor *average_poll_latency_sensor) {
+    average_poll_latency_sensor_ = average_poll_latency_sensor;
+  }
+  void set_p95_poll_latency_sensor(sensor::Sensor *p95_poll_latency_sensor) {
+    p95_poll_latency_sensor_ = p95_poll_latency_sensor;
+  }
+  void set_publishes_sent_sensor(sensor::Sensor *publishes_sent_sensor) {
+    publishes_sent_sensor_ = publishes_sent_sensor;
+  }
+  void set_publishes_suppressed_sensor(sensor::Sensor *publishes_suppressed_sensor) {
+    publishes_suppressed_sensor_ = publishes_suppressed_sensor;
+  }
+  void set_poll_interval_sensor(sensor::Sensor *poll_interval_sensor) { poll_interval_sensor_ = poll_interval_sensor; }
+  void set_charged_energy_sensor(sensor::Sensor *charged_energy_sensor) {
+    charged_energy_sensor_ = charged_energy_sensor;
+  }
+  void set_discharged_energy_sensor(sensor::Sensor *discharged_energy_sensor) {
+    discharged_energy_sensor_ = discharged_energy_sensor;
+  }
+
+  void set_system_parameter_sensor(uint8_t parameter, sensor::Sensor *system_parameter_sensor) {
+    this->system_parameter_sensors_[parameter] = system_parameter_sensor;
+  }
 
   void set_errors_text_sensor(text_sensor::TextSensor *errors_text_sensor) { errors_text_sensor_ = errors_text_sensor; }
+  void set_device_name_text_sensor(text_sensor::TextSensor *device_name_text_sensor) {
+    device_name_text_sensor_ = device_name_text_sensor;
+  }
+  void set_software_version_text_sensor(text_sensor::TextSensor *software_version_text_sensor) {
+    software_version_text_sensor_ = software_version_text_sensor;
+  }
+  void set_manufacturer_name_text_sensor(text_sensor::TextSensor *manufacturer_name_text_sensor) {
+    manufacturer_name_text_sensor_ = manufacturer_name_text_sensor;
+  }
+  void set_protocol_version_text_sensor(text_sensor::TextSensor *protocol_version_text_sensor) {
+    protocol_version_text_sensor_ = protocol_version_text_sensor;
+  }
+  void set_fast_watch_text_sensor(text_sensor::TextSensor *fast_watch_text_sensor) {
+    fast_watch_text_sensor_ = fast_watch_text_sensor;
+  }
 
   void set_override_cell_count(uint8_t override_cell_count) { this->override_cell_count_ = override_cell_count; }
+  // Polls the alarms along with the telemetry for a consumer of the alarm bitmask of the telemetry
+  void set_alarms_required(bool alarms_required) { this->alarms_required_ = alarms_required; }
+  void set_alarm_update_interval(uint32_t alarm_update_interval) {
+    this->alarm_update_interval_ = alarm_update_interval;
+  }
+  void set_heartbeat_interval(uint32_t heartbeat_interval) { this->heartbeat_interval_ = heartbeat_interval; }
+  void set_info_update_interval(uint32_t info_update_interval) { this->info_update_interval_ = info_update_interval; }
+  void set_cell_voltage_deadband(float cell_voltage_deadband) { this->cell_voltage_deadband_ = cell_voltage_deadband; }
+  void set_voltage_deadband(float voltage_deadband) { this->voltage_deadband_ = voltage_deadband; }
+  void set_current_deadband(float current_deadband) { this->current_deadband_ = current_deadband; }
+  void set_power_deadband(float power_deadband) { this->power_deadband_ = power_deadband; }
+  void set_temperature_deadband(float temperature_deadband) { this->temperature_deadband_ = temperature_deadband; }
+  void set_max_poll_interval(uint32_t max_poll_interval) { this->max_poll_interval_ = max_poll_interval; }
+  void set_current_threshold(float current_threshold) { this->current_threshold_ = current_threshold; }
+  void set_cell_voltage_delta_threshold(float cell_voltage_delta_threshold) {
+    this->cell_voltage_delta_threshold_ = cell_voltage_delta_threshold;
+  }
+  void set_energy_save_interval(uint32_t energy_save_interval) {
+    this->energy_save_interval_ = energy_save_interval;
+  }
+  // Tells the energy counters of packs with the same number on different buses apart
+  void set_energy_key(const std::string &energy_key) { this->energy_key_ = energy_key; }
+  void set_fast_watch_interval(uint32_t fast_watch_interval) { this->fast_watch_interval_ = fast_watch_interval; }
+  // Can be toggled at runtime, e.g. by a lambda for the duration of a balancing test
+  void set_fast_watch_enabled(bool fast_watch_enabled) { this->fast_watch_enabled_ = fast_watch_enabled; }
+  bool is_fast_watch_enabled() const { return this->fast_watch_enabled_; }
+
+  // Resolves the telemetry layout of the protocol version
+  void set_protocol_version(uint8_t protocol_version);
+
+  void add_on_telemetry_callback(std::function<void(const SeplosTelemetry &)> &&callback) {
+    this->telemetry_callback_.add(std::move(callback));
+  }
+
+  // Sends a command (CID1, CID2 and INFO) ahead of all polls of the bus. The callback gets whether the BMS
+  // acknowledged the command with RTN 0x00. Usable from lambdas for commands without an entity, e.g.
+  //   id(bms0).execute_command(0x46, 0x45, {0x01});
+  void execute_command(uint8_t cid1, uint8_t function, const std::vector<uint8_t> &info,
+                       std::function<void(bool)> &&callback = nullptr);
 
-  void on_seplos_modbus_data(const std::vector<uint8_t> &data) override;
+  void on_seplos_modbus_data(uint8_t function, const uint8_t *data, uint16_t length) override;
+  void on_seplos_modbus_registers(uint8_t function, uint16_t register_address, const uint8_t *data,
+                                  uint16_t length) override;
+  void on_seplos_modbus_failure(uint8_t function) override;
+  void on_seplos_modbus_discovered() override;
 
+  void setup() override;
+  void on_shutdown() override;
   void dump_config() override;
   void update() override;
   float get_setup_priority() const override;
 
  protected:
-  binary_sensor::BinarySensor *fan_running_binary_sensor_;
+  binary_sensor::BinarySensor *charging_switch_binary_sensor_;
+  binary_sensor::BinarySensor *discharging_switch_binary_sensor_;
+  binary_sensor::BinarySensor *balancing_binary_sensor_;
 
   sensor::Sensor *min_cell_voltage_sensor_;
   sensor::Sensor *max_cell_voltage_sensor_;
@@ -99,23 +249,149 @@ class SeplosBms : public PollingComponent, public seplos_modbus::SeplosModbusDev
   sensor::Sensor *charging_cycles_sensor_;
   sensor::Sensor *state_of_health_sensor_;
   sensor::Sensor *port_voltage_sensor_;
+  sensor::Sensor *poll_latency_sensor_;
+  sensor::Sensor *poll_timeouts_sensor_;
+  sensor::Sensor *min_poll_latency_sensor_;
+  sensor::Sensor *average_poll_latency_sensor_;
+  sensor::Sensor *p95_poll_latency_sensor_;
+  sensor::Sensor *publishes_sent_sensor_;
+  sensor::Sensor *publishes_suppressed_sensor_;
+  sensor::Sensor *poll_interval_sensor_;
+  sensor::Sensor *charged_energy_sensor_;
+  sensor::Sensor *discharged_energy_sensor_;
+
+  sensor::Sensor *system_parameter_sensors_[SYSTEM_PARAMETERS]{};
 
   text_sensor::TextSensor *errors_text_sensor_;
+  text_sensor::TextSensor *device_name_text_sensor_;
+  text_sensor::TextSensor *software_version_text_sensor_;
+  text_sensor::TextSensor *manufacturer_name_text_sensor_;
+  text_sensor::TextSensor *protocol_version_text_sensor_;
+  text_sensor::TextSensor *fast_watch_text_sensor_{nullptr};
 
   struct Cell {
     sensor::Sensor *cell_voltage_sensor_{nullptr};
-  } cells_[16];
+    sensor::Sensor *cell_resistance_sensor_{nullptr};
+    sensor::Sensor *cell_drift_sensor_{nullptr};
+  };
+  std::vector<Cell> cells_;
 
   struct Temperature {
     sensor::Sensor *temperature_sensor_{nullptr};
-  } temperatures_[6];
+  };
+  std::vector<Temperature> temperatures_;
 
   uint8_t override_cell_count_{0};
+  const SeplosLayout *layout_{nullptr};
+  CallbackManager<void(const SeplosTelemetry &)> telemetry_callback_;
+
+  uint32_t alarm_update_interval_{0};
+  bool alarms_required_{false};
+  bool alarms_received_{false};
+  uint64_t alarm_bitmask_{0};
+  uint8_t switch_state_{0};
+  bool balancing_{false};
+
+  // Static configuration of the BMS (CID2 0x47, 0x51 and 0x4F). Fetched once, refreshed on a long interval or
+  // if the telemetry hints at a reconfiguration and published only if it differs from the cached copy
+  uint32_t info_update_interval_{0};
+  bool info_requested_{false};
+  uint8_t info_unsupported_{0};
+  uint16_t rated_capacity_{0};
+  bool system_parameters_received_{false};
+  uint16_t system_parameters_[SYSTEM_PARAMETERS];
+  bool manufacturer_info_received_{false};
+  uint8_t manufacturer_info_[32];
+  uint8_t info_protocol_version_{0};
+
+  // Pack info A of a V3 BMS, kept until pack info B completes the telemetry of the poll
+  bool pack_info_a_received_{false};
+  uint8_t pack_info_a_[PACK_INFO_A_REGISTERS * 2];
+
+  uint32_t heartbeat_interval_{0};
+  uint32_t last_heartbeat_{0};
+  bool force_publish_{true};
+  float cell_voltage_deadband_{0.0f};
+  float voltage_deadband_{0.0f};
+  float current_deadband_{0.0f};
+  float power_deadband_{0.0f};
+  float temperature_deadband_{0.0f};
+  uint32_t publishes_sent_{0};
+  uint32_t publishes_suppressed_{0};
+
+  // Adaptive polling is enabled if there is a max poll interval. The update interval is the min poll interval
+  uint32_t max_poll_interval_{0};
+  float current_threshold_{5.0f};
+  float cell_voltage_delta_threshold_{0.05f};
+  uint32_t poll_interval_{0};
+  uint32_t last_poll_{0};
+
+  // Fast watch polls the telemetry at a high rate in between the regular polls. Its frames are decoded only
+  // for the cell voltages, current and total voltage, which are published as a single compact payload.
+  // The frame of a regular poll is decoded in full
+  uint32_t fast_watch_interval_{0};
+  bool fast_watch_enabled_{false};
+  bool telemetry_requested_{false};
+  std::string fast_watch_payload_;
+
+  // Commands waiting for their response. The responses of a device arrive in the order of its requests
+  struct PendingCommand {
+    uint8_t function;
+    std::function<void(bool)> callback;
+  };
+  std::vector<PendingCommand> commands_;
+
+  // Energy counters and the per cell trends. The energy counters are restored at boot and written back to flash
+  // at most once per save interval
+  SeplosAnalytics analytics_;
+  uint8_t analytics_cells_{0};
+  uint32_t energy_save_interval_{0};
+  std::string energy_key_;
+  ESPPreferenceObject energy_preference_;
+  bool energy_preference_created_{false};
+  EnergyCounters saved_energy_{0, 0};
 
   void publish_state_(binary_sensor::BinarySensor *binary_sensor, const bool &state);
   void publish_state_(sensor::Sensor *sensor, float value);
+  void publish_state_(sensor::Sensor *sensor, float value, float deadband);
   void publish_state_(text_sensor::TextSensor *text_sensor, const std::string &state);
-  void on_telemetry_data_(const std::vector<uint8_t> &data);
+  // The telemetry values in the units on the wire, which are the same for the V2 frame and the V3 registers
+  struct RawTelemetry {
+    const uint8_t *cell_voltages;  // uint16_t big endian, 1 mV
+    uint8_t cells;
+    const uint8_t *temperatures;  // uint16_t big endian, 0.1 K
+    uint8_t temperature_sensors;
+    int16_t current;             // 10 mA
+    uint16_t total_voltage;      // 10 mV
+    uint16_t residual_capacity;  // 10 mAh
+    uint16_t battery_capacity;   // 10 mAh
+    uint16_t state_of_charge;    // 0.1 %
+    uint16_t cycles;
+    uint16_t state_of_health;  // 0.1 %
+    optional<uint16_t> rated_capacity;
+    optional<uint16_t> port_voltage;
+  };
+
+  void on_telemetry_frame_(const uint8_t *data, uint16_t length);
+  void on_telemetry_data_(const uint8_t *data, uint16_t length, const SeplosLayout &layout);
+  void on_pack_info_b_(const uint8_t *data, uint16_t length);
+  void on_pack_info_c_(const uint8_t *data, uint16_t length);
+  void publish_telemetry_(const RawTelemetry &raw);
+  void publish_fast_watch_(const RawTelemetry &raw);
+  bool complete_command_(uint8_t function, bool responded, uint8_t rtn);
+  void poll_fast_watch_();
+  void on_alarm_data_(const uint8_t *data, uint16_t length);
+  void publish_alarms_(uint64_t alarm_bitmask, uint8_t switch_state, bool balancing);
+  void poll_alarms_();
+  void on_system_parameters_(const uint8_t *data, uint16_t length);
+  void on_manufacturer_info_(const uint8_t *data, uint16_t length);
+  void on_protocol_version_(const uint8_t *data, uint16_t length);
+  void request_info_();
+  void publish_analytics_(const RawTelemetry &raw);
+  void restore_energy_();
+  void save_energy_();
+  void adapt_poll_interval_(bool active);
+  std::string alarm_bitmask_to_string_(uint64_t mask);
 };
 
 }  // namespace seplos_bms
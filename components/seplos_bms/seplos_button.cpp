@@ -0,0 +1,13 @@
+#include "seplos_button.h"
+
+#ifdef USE_BUTTON
+
+namespace esphome {
+namespace seplos_bms {
+
+void SeplosButton::press_action() { this->parent_->execute_command(this->cid1_, this->function_, this->info_); }
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_BUTTON
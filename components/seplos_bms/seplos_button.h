@@ -0,0 +1,33 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_BUTTON
+#include "esphome/components/button/button.h"
+#include "seplos_bms.h"
+
+#include <vector>
+
+namespace esphome {
+namespace seplos_bms {
+
+class SeplosButton : public button::Button {
+ public:
+  void set_parent(SeplosBms *parent) { this->parent_ = parent; }
+  void set_cid1(uint8_t cid1) { this->cid1_ = cid1; }
+  void set_function(uint8_t function) { this->function_ = function; }
+  void set_info(const std::vector<uint8_t> &info) { this->info_ = info; }
+
+ protected:
+  void press_action() override;
+
+  SeplosBms *parent_;
+  uint8_t cid1_{0x46};
+  uint8_t function_;
+  std::vector<uint8_t> info_;
+};
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_BUTTON
@@ -0,0 +1,24 @@
+#include "seplos_number.h"
+
+#ifdef USE_NUMBER
+
+#include <cmath>
+
+namespace esphome {
+namespace seplos_bms {
+
+void SeplosNumber::control(float value) {
+  const uint16_t raw = (uint16_t) lroundf(value * this->multiplier_);
+  std::vector<uint8_t> info = this->info_prefix_;
+  info.push_back(raw >> 8);
+  info.push_back(raw >> 0);
+  this->parent_->execute_command(this->cid1_, this->function_, info, [this, value](bool acknowledged) {
+    // Republish the previous value to revert the frontend otherwise
+    this->publish_state(acknowledged ? value : this->state);
+  });
+}
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_NUMBER
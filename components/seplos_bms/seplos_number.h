@@ -0,0 +1,37 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_NUMBER
+#include "esphome/components/number/number.h"
+#include "seplos_bms.h"
+
+#include <vector>
+
+namespace esphome {
+namespace seplos_bms {
+
+// Writes the value as uint16_t big endian, scaled by the multiplier, behind the INFO prefix. The state follows
+// once the BMS acknowledged the write
+class SeplosNumber : public number::Number {
+ public:
+  void set_parent(SeplosBms *parent) { this->parent_ = parent; }
+  void set_cid1(uint8_t cid1) { this->cid1_ = cid1; }
+  void set_function(uint8_t function) { this->function_ = function; }
+  void set_info_prefix(const std::vector<uint8_t> &info_prefix) { this->info_prefix_ = info_prefix; }
+  void set_multiplier(float multiplier) { this->multiplier_ = multiplier; }
+
+ protected:
+  void control(float value) override;
+
+  SeplosBms *parent_;
+  uint8_t cid1_{0x46};
+  uint8_t function_;
+  std::vector<uint8_t> info_prefix_;
+  float multiplier_{1.0f};
+};
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_NUMBER
@@ -0,0 +1,19 @@
+#include "seplos_switch.h"
+
+#ifdef USE_SWITCH
+
+namespace esphome {
+namespace seplos_bms {
+
+void SeplosSwitch::write_state(bool state) {
+  this->parent_->execute_command(this->cid1_, this->function_, state ? this->turn_on_info_ : this->turn_off_info_,
+                                 [this, state](bool acknowledged) {
+                                   // Republish the previous state to revert the frontend otherwise
+                                   this->publish_state(acknowledged ? state : this->state);
+                                 });
+}
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_SWITCH
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_SWITCH
+#include "esphome/components/switch/switch.h"
+#include "seplos_bms.h"
+
+#include <vector>
+
+namespace esphome {
+namespace seplos_bms {
+
+// Sends the turn on or turn off command. The state follows once the BMS acknowledged the command
+class SeplosSwitch : public switch_::Switch {
+ public:
+  void set_parent(SeplosBms *parent) { this->parent_ = parent; }
+  void set_cid1(uint8_t cid1) { this->cid1_ = cid1; }
+  void set_function(uint8_t function) { this->function_ = function; }
+  void set_turn_on_info(const std::vector<uint8_t> &turn_on_info) { this->turn_on_info_ = turn_on_info; }
+  void set_turn_off_info(const std::vector<uint8_t> &turn_off_info) { this->turn_off_info_ = turn_off_info; }
+
+ protected:
+  void write_state(bool state) override;
+
+  SeplosBms *parent_;
+  uint8_t cid1_{0x46};
+  uint8_t function_;
+  std::vector<uint8_t> turn_on_info_;
+  std::vector<uint8_t> turn_off_info_;
+};
+
+}  // namespace seplos_bms
+}  // namespace esphome
+
+#endif  // USE_SWITCH
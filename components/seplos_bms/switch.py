@@ -0,0 +1,41 @@
+import esphome.codegen as cg
+from esphome.components import switch
+import esphome.config_validation as cv
+from esphome.const import CONF_ID
+
+from . import (
+    COMMAND_SCHEMA,
+    CONF_CID1,
+    CONF_FUNCTION,
+    CONF_SEPLOS_BMS_ID,
+    INFO_SCHEMA,
+    seplos_bms_ns,
+)
+
+DEPENDENCIES = ["seplos_bms"]
+
+CODEOWNERS = ["@syssi"]
+
+CONF_TURN_ON_INFO = "turn_on_info"
+CONF_TURN_OFF_INFO = "turn_off_info"
+
+SeplosSwitch = seplos_bms_ns.class_("SeplosSwitch", switch.Switch)
+
+CONFIG_SCHEMA = switch.SWITCH_SCHEMA.extend(COMMAND_SCHEMA).extend(
+    {
+        cv.GenerateID(): cv.declare_id(SeplosSwitch),
+        cv.Optional(CONF_TURN_ON_INFO, default=[]): INFO_SCHEMA,
+        cv.Optional(CONF_TURN_OFF_INFO, default=[]): INFO_SCHEMA,
+    }
+)
+
+
+async def to_code(config):
+    hub = await cg.get_variable(config[CONF_SEPLOS_BMS_ID])
+    var = cg.new_Pvariable(config[CONF_ID])
+    await switch.register_switch(var, config)
+    cg.add(var.set_parent(hub))
+    cg.add(var.set_cid1(config[CONF_CID1]))
+    cg.add(var.set_function(config[CONF_FUNCTION]))
+    cg.add(var.set_turn_on_info(config[CONF_TURN_ON_INFO]))
+    cg.add(var.set_turn_off_info(config[CONF_TURN_OFF_INFO]))
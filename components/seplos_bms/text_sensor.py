@@ -15,25 +15,44 @@ DEPENDENCIES = ["seplos_bms"]
 CODEOWNERS = ["@syssi"]
 
 CONF_ERRORS = "errors"
+CONF_DEVICE_NAME = "device_name"
+CONF_SOFTWARE_VERSION = "software_version"
+CONF_MANUFACTURER_NAME = "manufacturer_name"
+CONF_PROTOCOL_VERSION = "protocol_version"
+CONF_FAST_WATCH = "fast_watch"
 
 ICON_ERRORS = "mdi:alert-circle-outline"
+ICON_DEVICE_NAME = "mdi:car-battery"
+ICON_SOFTWARE_VERSION = "mdi:numeric"
+ICON_MANUFACTURER_NAME = "mdi:factory"
+ICON_PROTOCOL_VERSION = "mdi:numeric"
+ICON_FAST_WATCH = "mdi:chart-timeline-variant"
 
-TEXT_SENSORS = [
-    CONF_ERRORS,
-]
+TEXT_SENSORS = {
+    CONF_ERRORS: ICON_ERRORS,
+    CONF_DEVICE_NAME: ICON_DEVICE_NAME,
+    CONF_SOFTWARE_VERSION: ICON_SOFTWARE_VERSION,
+    CONF_MANUFACTURER_NAME: ICON_MANUFACTURER_NAME,
+    CONF_PROTOCOL_VERSION: ICON_PROTOCOL_VERSION,
+    CONF_FAST_WATCH: ICON_FAST_WATCH,
+}
 
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_SEPLOS_BMS_ID): cv.use_id(SeplosBms),
-        cv.Optional(CONF_ERRORS): text_sensor.TEXT_SENSOR_SCHEMA.extend(
+    }
+).extend(
+    {
+        cv.Optional(key): text_sensor.TEXT_SENSOR_SCHEMA.extend(
             {
                 cv.GenerateID(): cv.declare_id(text_sensor.TextSensor),
-                cv.Optional(CONF_ICON, default=ICON_ERRORS): cv.icon,
+                cv.Optional(CONF_ICON, default=icon): cv.icon,
                 cv.Optional(
                     CONF_ENTITY_CATEGORY, default=ENTITY_CATEGORY_DIAGNOSTIC
                 ): cv.entity_category,
             }
-        ),
+        )
+        for key, icon in TEXT_SENSORS.items()
     }
 )
 
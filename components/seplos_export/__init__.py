@@ -0,0 +1,69 @@
+from esphome import automation
+import esphome.codegen as cg
+from esphome.components import web_server_base
+from esphome.components.seplos_modbus import CONF_SEPLOS_MODBUS_ID, SeplosModbus
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
+import esphome.config_validation as cv
+from esphome.const import CONF_ID, CONF_TRIGGER_ID, CONF_URL
+from esphome.core import CORE
+
+DEPENDENCIES = ["seplos_bms"]
+CODEOWNERS = ["@syssi"]
+MULTI_CONF = True
+
+CONF_WEB_SERVER = "web_server"
+CONF_ON_RECORD = "on_record"
+
+seplos_export_ns = cg.esphome_ns.namespace("seplos_export")
+SeplosExport = seplos_export_ns.class_("SeplosExport", cg.Component)
+RecordTrigger = seplos_export_ns.class_(
+    "RecordTrigger", automation.Trigger.template(cg.std_vector.template(cg.uint8))
+)
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(SeplosExport),
+            # Export all packs of this bus
+            cv.GenerateID(CONF_SEPLOS_MODBUS_ID): cv.use_id(SeplosModbus),
+            # Serve the latest record of each pack at the URL of the web server
+            cv.Optional(CONF_WEB_SERVER): cv.Schema(
+                {
+                    cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(
+                        web_server_base.WebServerBase
+                    ),
+                    cv.Optional(CONF_URL, default="/seplos_export"): cv.string,
+                }
+            ),
+            # Hand over every record, e.g. to publish it to a single MQTT topic
+            cv.Optional(CONF_ON_RECORD): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(RecordTrigger),
+                }
+            ),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    cv.has_at_least_one_key(CONF_WEB_SERVER, CONF_ON_RECORD),
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    for pack in CORE.config.get("seplos_bms", []):
+        if pack[CONF_SEPLOS_MODBUS_ID].id == config[CONF_SEPLOS_MODBUS_ID].id:
+            bms = await cg.get_variable(pack[CONF_ID])
+            cg.add(var.add_pack(bms))
+
+    if CONF_WEB_SERVER in config:
+        web_server = config[CONF_WEB_SERVER]
+        cg.add_define("USE_SEPLOS_EXPORT_WEB_SERVER")
+        base = await cg.get_variable(web_server[CONF_WEB_SERVER_BASE_ID])
+        cg.add(var.set_web_server(base, web_server[CONF_URL]))
+
+    for conf in config.get(CONF_ON_RECORD, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger, [(cg.std_vector.template(cg.uint8), "x")], conf
+        )
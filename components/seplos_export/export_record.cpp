@@ -0,0 +1,75 @@
+#include "export_record.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace seplos_export {
+
+namespace {
+
+void put_uint16(std::vector<uint8_t> &out, uint16_t value) {
+  out.push_back(uint8_t(value >> 0));
+  out.push_back(uint8_t(value >> 8));
+}
+
+void put_uint32(std::vector<uint8_t> &out, uint32_t value) {
+  for (uint8_t i = 0; i < 4; i++) {
+    out.push_back(uint8_t(value >> (i * 8)));
+  }
+}
+
+// The largest value marks an unknown one
+uint16_t to_uint16(float value, float scale) {
+  if (std::isnan(value))
+    return 0xFFFF;
+  return uint16_t(std::max(0L, std::min(0xFFFEL, lroundf(value * scale))));
+}
+
+// The smallest value marks an unknown one
+int16_t to_int16(float value, float scale) {
+  if (std::isnan(value))
+    return INT16_MIN;
+  return int16_t(std::max(INT16_MIN + 1L, std::min(long(INT16_MAX), lroundf(value * scale))));
+}
+
+// The values of the frame are big endian
+void put_series(std::vector<uint8_t> &out, const uint8_t *values, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    put_uint16(out, encode_uint16(values[i * 2], values[i * 2 + 1]));
+  }
+}
+
+}  // namespace
+
+size_t encode_record(const seplos_bms::SeplosTelemetry &telemetry, uint32_t timestamp, std::vector<uint8_t> &out) {
+  uint8_t cells = telemetry.cell_voltages != nullptr ? telemetry.cells : 0;
+  uint8_t temperature_sensors = telemetry.temperatures != nullptr ? telemetry.temperature_sensors : 0;
+  const size_t space = (MAX_RECORD_SIZE - RECORD_HEADER_SIZE) / 2;
+  cells = std::min<size_t>(cells, space);
+  temperature_sensors = std::min<size_t>(temperature_sensors, space - cells);
+  const uint16_t size = RECORD_HEADER_SIZE + (cells + temperature_sensors) * 2;
+
+  out.push_back(SCHEMA_VERSION);
+  out.push_back(telemetry.pack);
+  put_uint16(out, size);
+  put_uint32(out, timestamp);
+  put_uint16(out, to_uint16(telemetry.state_of_charge, 10.0f));
+  put_uint16(out, uint16_t(to_int16(telemetry.current, 100.0f)));
+  put_uint16(out, to_uint16(telemetry.total_voltage, 100.0f));
+  put_uint16(out, to_uint16(telemetry.residual_capacity, 100.0f));
+  put_uint16(out, to_uint16(telemetry.battery_capacity, 100.0f));
+  put_uint16(out, to_uint16(telemetry.state_of_health, 10.0f));
+  put_uint32(out, uint32_t(telemetry.alarm_bitmask));
+  put_uint32(out, uint32_t(telemetry.alarm_bitmask >> 32));
+  out.push_back(cells);
+  out.push_back(temperature_sensors);
+  put_series(out, telemetry.cell_voltages, cells);
+  put_series(out, telemetry.temperatures, temperature_sensors);
+
+  return size;
+}
+
+}  // namespace seplos_export
+}  // namespace esphome
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+namespace esphome {
+namespace seplos_export {
+
+static const uint8_t SCHEMA_VERSION = 1;
+static const uint8_t RECORD_HEADER_SIZE = 30;
+// Largest record, the cells and temperatures beyond are left out
+static const uint16_t MAX_RECORD_SIZE = 256;
+
+// Encodes the telemetry of a pack into out. Returns the size of the record
+//
+//   0    Schema version                           uint8_t
+//   1    Pack                                     uint8_t
+//   2    Size of the record                       uint16_t
+//   4    Uptime (ms)                              uint32_t
+//   8    SOC (0.1 %)                              uint16_t, 0xFFFF if unknown
+//  10    Current (10 mA)                          int16_t, 0x8000 if unknown
+//  12    Total voltage (10 mV)                    uint16_t, 0xFFFF if unknown
+//  14    Residual capacity (10 mAh)               uint16_t, 0xFFFF if unknown
+//  16    Battery capacity (10 mAh)                uint16_t, 0xFFFF if unknown
+//  18    SOH (0.1 %)                              uint16_t, 0xFFFF if unknown
+//  20    Alarm events 1..8, see seplos_bms ALARMS uint64_t
+//  28    Number of cells M                        uint8_t
+//  29    Number of temperature sensors T          uint8_t
+//  30    M cell voltages (1 mV)                   uint16_t
+//        T temperatures (0.1 K)                   uint16_t
+//
+// All values are little endian. Later schema versions only append fields, so a reader skips the rest of a
+// record by its size. A 16 cell pack with 6 temperature sensors takes 74 bytes.
+size_t encode_record(const seplos_bms::SeplosTelemetry &telemetry, uint32_t timestamp, std::vector<uint8_t> &out);
+
+}  // namespace seplos_export
+}  // namespace esphome
@@ -0,0 +1,91 @@
+#include "seplos_export.h"
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+
+namespace esphome {
+namespace seplos_export {
+
+static const char *const TAG = "seplos_export";
+
+void SeplosExport::add_pack(seplos_bms::SeplosBms *pack) {
+  const uint8_t index = this->records_.size();
+  this->records_.emplace_back();
+  // A record never grows beyond, so rewriting it never allocates
+  this->records_.back().reserve(MAX_RECORD_SIZE);
+  pack->add_on_telemetry_callback(
+      [this, index](const seplos_bms::SeplosTelemetry &telemetry) { this->on_telemetry_(index, telemetry); });
+}
+
+void SeplosExport::setup() {
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+  if (this->web_server_base_ != nullptr) {
+    this->web_server_base_->add_handler(new SeplosExportHandler(this, this->url_));
+  }
+#endif
+}
+
+void SeplosExport::on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry) {
+  std::vector<uint8_t> &record = this->records_[index];
+  size_t size;
+  {
+    LockGuard guard(this->lock_);
+    record.clear();
+    size = encode_record(telemetry, millis(), record);
+  }
+  ESP_LOGV(TAG, "Exporting pack 0x%02X (%u bytes)", telemetry.pack, (unsigned) size);
+
+  this->record_callback_.call(record);
+}
+
+void SeplosExport::copy_to(std::vector<uint8_t> &out) {
+  // Allocate outside of the lock, a record never grows beyond MAX_RECORD_SIZE
+  out.clear();
+  out.reserve(this->records_.size() * MAX_RECORD_SIZE);
+
+  LockGuard guard(this->lock_);
+  for (const auto &record : this->records_) {
+    out.insert(out.end(), record.begin(), record.end());
+  }
+}
+
+void SeplosExport::dump_config() {
+  ESP_LOGCONFIG(TAG, "SeplosExport:");
+  ESP_LOGCONFIG(TAG, "  Packs: %d", (int) this->records_.size());
+  ESP_LOGCONFIG(TAG, "  Schema version: %u", SCHEMA_VERSION);
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+  if (this->web_server_base_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  URL: %s", this->url_);
+  }
+#endif
+}
+
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+void SeplosExportHandler::handleRequest(AsyncWebServerRequest *request) {
+  // A snapshot per response, taken at once for all packs
+  auto records = std::make_shared<std::vector<uint8_t>>();
+  this->parent_->copy_to(*records);
+#ifdef USE_ARDUINO
+  // Sent after handleRequest() returned, the filler keeps the snapshot alive until the response is destroyed
+  AsyncWebServerResponse *response =
+      request->beginResponse("application/octet-stream", records->size(),
+                             [records](uint8_t *buffer, size_t max_length, size_t index) -> size_t {
+                               const size_t length = std::min(max_length, records->size() - index);
+                               memcpy(buffer, records->data() + index, length);
+                               return length;
+                             });
+#else
+  // web_server_idf sends the response before send() returns
+  AsyncWebServerResponse *response =
+      request->beginResponse_P(200, "application/octet-stream", records->data(), records->size());
+#endif
+  request->send(response);
+}
+#endif
+
+}  // namespace seplos_export
+}  // namespace esphome
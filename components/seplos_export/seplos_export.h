@@ -0,0 +1,84 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+#include "esphome/components/web_server_base/web_server_base.h"
+#endif
+
+#include "export_record.h"
+
+#include <vector>
+
+namespace esphome {
+namespace seplos_export {
+
+// Hands over one binary record per telemetry frame of a pack, see encode_record(). The latest record of
+// each pack is also served at the URL of the web server for collectors scraping the node.
+class SeplosExport : public Component {
+ public:
+  void add_pack(seplos_bms::SeplosBms *pack);
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+  void set_web_server(web_server_base::WebServerBase *web_server_base, const char *url) {
+    web_server_base_ = web_server_base;
+    url_ = url;
+  }
+#endif
+
+  void add_on_record_callback(std::function<void(const std::vector<uint8_t> &)> &&callback) {
+    this->record_callback_.add(std::move(callback));
+  }
+
+  // Copies the latest record of each pack. Safe to call from another task, e.g. the one of the web server
+  void copy_to(std::vector<uint8_t> &out);
+
+  void setup() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+  web_server_base::WebServerBase *web_server_base_{nullptr};
+  const char *url_{nullptr};
+#endif
+
+  // Latest record of each pack, empty until the first frame. Guarded by lock_, which the task receiving the
+  // telemetry needs only while rewriting them
+  std::vector<std::vector<uint8_t>> records_;
+  Mutex lock_;
+
+  CallbackManager<void(const std::vector<uint8_t> &)> record_callback_;
+
+  void on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry);
+};
+
+#ifdef USE_SEPLOS_EXPORT_WEB_SERVER
+// Serves the latest records as application/octet-stream
+class SeplosExportHandler : public AsyncWebHandler {
+ public:
+  SeplosExportHandler(SeplosExport *parent, const char *url) : parent_(parent), url_(url) {}
+
+  bool canHandle(AsyncWebServerRequest *request) override {
+    return request->method() == HTTP_GET && request->url() == this->url_;
+  }
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ protected:
+  SeplosExport *parent_;
+  const char *url_;
+};
+#endif
+
+class RecordTrigger : public Trigger<std::vector<uint8_t>> {
+ public:
+  explicit RecordTrigger(SeplosExport *parent) {
+    parent->add_on_record_callback([this](const std::vector<uint8_t> &data) { this->trigger(data); });
+  }
+};
+
+}  // namespace seplos_export
+}  // namespace esphome
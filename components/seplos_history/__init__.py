@@ -0,0 +1,73 @@
+from esphome import automation
+import esphome.codegen as cg
+from esphome.components.seplos_modbus import CONF_SEPLOS_MODBUS_ID, SeplosModbus
+import esphome.config_validation as cv
+from esphome.const import CONF_BUFFER_SIZE, CONF_ID, CONF_TRIGGER_ID
+from esphome.core import CORE
+
+AUTO_LOAD = ["network"]
+DEPENDENCIES = ["seplos_bms"]
+CODEOWNERS = ["@syssi"]
+MULTI_CONF = True
+
+CONF_RECORD_INTERVAL = "record_interval"
+CONF_DRAIN_INTERVAL = "drain_interval"
+CONF_DRAIN_SIZE = "drain_size"
+CONF_ON_DRAIN = "on_drain"
+
+# Largest record plus the header of a chunk
+MIN_DRAIN_SIZE = 256 + 4
+
+seplos_history_ns = cg.esphome_ns.namespace("seplos_history")
+SeplosHistory = seplos_history_ns.class_("SeplosHistory", cg.Component)
+DrainTrigger = seplos_history_ns.class_(
+    "DrainTrigger", automation.Trigger.template(cg.std_vector.template(cg.uint8))
+)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(SeplosHistory),
+        # Record all packs of this bus
+        cv.GenerateID(CONF_SEPLOS_MODBUS_ID): cv.use_id(SeplosModbus),
+        # Ring buffer of the records, in PSRAM if available
+        cv.Optional(CONF_BUFFER_SIZE, default="16kB"): cv.All(
+            cv.validate_bytes, cv.int_range(min=1024)
+        ),
+        # Record a pack at most once per interval while offline
+        cv.Optional(
+            CONF_RECORD_INTERVAL, default="60s"
+        ): cv.positive_time_period_milliseconds,
+        # Hand over at most drain_size bytes per drain_interval once online again
+        cv.Optional(
+            CONF_DRAIN_INTERVAL, default="1s"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_DRAIN_SIZE, default=1024): cv.All(
+            cv.validate_bytes, cv.int_range(min=MIN_DRAIN_SIZE, max=65535)
+        ),
+        cv.Required(CONF_ON_DRAIN): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(DrainTrigger),
+            }
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    cg.add(var.set_buffer_size(config[CONF_BUFFER_SIZE]))
+    cg.add(var.set_record_interval(config[CONF_RECORD_INTERVAL]))
+    cg.add(var.set_drain_interval(config[CONF_DRAIN_INTERVAL]))
+    cg.add(var.set_drain_size(config[CONF_DRAIN_SIZE]))
+    for pack in CORE.config.get("seplos_bms", []):
+        if pack[CONF_SEPLOS_MODBUS_ID].id == config[CONF_SEPLOS_MODBUS_ID].id:
+            bms = await cg.get_variable(pack[CONF_ID])
+            cg.add(var.add_pack(bms))
+
+    for conf in config[CONF_ON_DRAIN]:
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger, [(cg.std_vector.template(cg.uint8), "x")], conf
+        )
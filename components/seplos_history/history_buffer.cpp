@@ -0,0 +1,129 @@
+#include "history_buffer.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace seplos_history {
+
+namespace {
+
+// Appends the values to a record. Stops writing once the record is full
+class RecordWriter {
+ public:
+  explicit RecordWriter(uint8_t *out) : out_(out) {}
+
+  void put(uint8_t byte) {
+    if (this->length_ < MAX_RECORD_SIZE) {
+      this->out_[this->length_] = byte;
+    }
+    this->length_++;
+  }
+  void put_varint(uint32_t value) {
+    while (value >= 0x80) {
+      this->put(uint8_t(value | 0x80));
+      value >>= 7;
+    }
+    this->put(uint8_t(value));
+  }
+  void put_zigzag(int32_t value) { this->put_varint((uint32_t(value) << 1) ^ uint32_t(value >> 31)); }
+  // The first value as is, the others as the difference to the preceding one
+  void put_series(const uint8_t *values, uint8_t count) {
+    this->put_varint(count);
+    uint16_t previous = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      const uint16_t value = encode_uint16(values[i * 2], values[i * 2 + 1]);
+      if (i == 0) {
+        this->put_varint(value);
+      } else {
+        this->put_zigzag(int32_t(value) - previous);
+      }
+      previous = value;
+    }
+  }
+
+  size_t length() const { return this->length_; }
+
+ protected:
+  uint8_t *out_;
+  size_t length_{0};
+};
+
+}  // namespace
+
+size_t encode_record(const HistorySample &sample, uint8_t *out) {
+  RecordWriter writer(out);
+  writer.put(0x00);  // Filled in below
+  writer.put(sample.pack);
+  for (uint8_t i = 0; i < 4; i++) {
+    writer.put(uint8_t(sample.timestamp >> (i * 8)));
+  }
+  writer.put_varint(sample.state_of_charge);
+  writer.put_zigzag(sample.current);
+  writer.put_varint(sample.total_voltage);
+  writer.put_series(sample.cell_voltages, sample.cell_voltages != nullptr ? sample.cells : 0);
+  writer.put_series(sample.temperatures, sample.temperatures != nullptr ? sample.temperature_sensors : 0);
+
+  if (writer.length() > MAX_RECORD_SIZE)
+    return 0;
+
+  out[0] = uint8_t(writer.length() - 1);
+  return writer.length();
+}
+
+bool HistoryBuffer::allocate(size_t size) {
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  this->buffer_ = allocator.allocate(size);
+  if (this->buffer_ == nullptr)
+    return false;
+
+  this->capacity_ = size;
+  return true;
+}
+
+void HistoryBuffer::push(const uint8_t *record, size_t length) {
+  if (this->buffer_ == nullptr || length > this->capacity_)
+    return;
+
+  while (this->capacity_ - this->length_ < length) {
+    this->drop_oldest_();
+  }
+
+  const size_t position = (this->head_ + this->length_) % this->capacity_;
+  const size_t first = std::min(length, this->capacity_ - position);
+  memcpy(this->buffer_ + position, record, first);
+  memcpy(this->buffer_, record + first, length - first);
+  this->length_ += length;
+  this->records_++;
+}
+
+size_t HistoryBuffer::pop(std::vector<uint8_t> &out, size_t max_length) {
+  size_t length = 0;
+  while (length < this->length_ && length + this->record_size_(this->head_ + length) <= max_length) {
+    length += this->record_size_(this->head_ + length);
+    this->records_--;
+  }
+  if (length == 0)
+    return 0;
+
+  const size_t offset = out.size();
+  out.resize(offset + length);
+  const size_t first = std::min(length, this->capacity_ - this->head_);
+  memcpy(out.data() + offset, this->buffer_ + this->head_, first);
+  memcpy(out.data() + offset + first, this->buffer_, length - first);
+  this->head_ = (this->head_ + length) % this->capacity_;
+  this->length_ -= length;
+  return length;
+}
+
+void HistoryBuffer::drop_oldest_() {
+  const size_t record_size = this->record_size_(this->head_);
+  this->head_ = (this->head_ + record_size) % this->capacity_;
+  this->length_ -= record_size;
+  this->records_--;
+  this->dropped_++;
+}
+
+}  // namespace seplos_history
+}  // namespace esphome
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace seplos_history {
+
+// Largest record including its length byte
+static const uint16_t MAX_RECORD_SIZE = 256;
+
+// The telemetry of a pack in the units on the wire
+struct HistorySample {
+  uint8_t pack;
+  uint32_t timestamp;        // ms
+  uint16_t state_of_charge;  // 0.1 %
+  int16_t current;           // 10 mA
+  uint16_t total_voltage;    // 10 mV
+  uint8_t cells;
+  const uint8_t *cell_voltages;  // uint16_t big endian, 1 mV
+  uint8_t temperature_sensors;
+  const uint8_t *temperatures;  // uint16_t big endian, 0.1 K
+};
+
+// Encodes a sample into out (MAX_RECORD_SIZE bytes). Returns the size of the record, 0 if it doesn't fit
+//
+//   0    Length N of the rest of the record       uint8_t
+//   1    Pack                                     uint8_t
+//   2    Timestamp (ms)                           uint32_t little endian
+//   6    SOC (0.1 %)                              varint
+//        Current (10 mA)                          zigzag varint
+//        Total voltage (10 mV)                    varint
+//        Number of cells M                        varint
+//        M cell voltages (1 mV)                   varint, then zigzag varints of the difference to the preceding cell
+//        Number of temperature sensors T          varint
+//        T temperatures (0.1 K)                   varint, then zigzag varints of the difference to the preceding one
+//
+// Varints are little endian base 128. The differences are taken within a record, so dropping the oldest record
+// of the ring never breaks the decoding of the next one. A 16 cell pack takes about 40 bytes.
+size_t encode_record(const HistorySample &sample, uint8_t *out);
+
+// Fixed-size ring of encoded records. The oldest records are dropped to make room for new ones
+class HistoryBuffer {
+ public:
+  // Prefers PSRAM where available
+  bool allocate(size_t size);
+  bool is_allocated() const { return this->buffer_ != nullptr; }
+
+  void push(const uint8_t *record, size_t length);
+  // Moves whole records, from the oldest on, to the end of out until max_length bytes were added
+  size_t pop(std::vector<uint8_t> &out, size_t max_length);
+
+  size_t size() const { return this->length_; }
+  size_t capacity() const { return this->capacity_; }
+  uint32_t records() const { return this->records_; }
+  uint32_t dropped() const { return this->dropped_; }
+
+ protected:
+  void drop_oldest_();
+  size_t record_size_(size_t position) const { return 1 + this->buffer_[position % this->capacity_]; }
+
+  uint8_t *buffer_{nullptr};
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t length_{0};
+  uint32_t records_{0};
+  uint32_t dropped_{0};
+};
+
+}  // namespace seplos_history
+}  // namespace esphome
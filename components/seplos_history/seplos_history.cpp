@@ -0,0 +1,120 @@
+#include "seplos_history.h"
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/network/util.h"
+
+#ifdef USE_API
+#include "esphome/components/api/api_server.h"
+#endif
+#ifdef USE_MQTT
+#include "esphome/components/mqtt/mqtt_client.h"
+#endif
+
+#include <cinttypes>
+#include <cmath>
+
+namespace esphome {
+namespace seplos_history {
+
+static const char *const TAG = "seplos_history";
+
+static const uint8_t CHUNK_HEADER_SIZE = 4;
+
+void SeplosHistory::add_pack(seplos_bms::SeplosBms *pack) {
+  const uint8_t index = this->packs_.size();
+  this->packs_.push_back(Pack{false, 0});
+  pack->add_on_telemetry_callback(
+      [this, index](const seplos_bms::SeplosTelemetry &telemetry) { this->on_telemetry_(index, telemetry); });
+}
+
+void SeplosHistory::setup() {
+  if (!this->buffer_.allocate(this->buffer_size_)) {
+    ESP_LOGE(TAG, "Could not allocate %u bytes", (unsigned) this->buffer_size_);
+    this->mark_failed();
+    return;
+  }
+
+  this->chunk_.reserve(this->drain_size_);
+  this->set_interval("drain", this->drain_interval_, [this]() { this->drain_(); });
+}
+
+void SeplosHistory::on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry) {
+  // The live values get through while the node is online
+  if (!this->buffer_.is_allocated() || this->is_online_())
+    return;
+
+  const uint32_t now = millis();
+  Pack &pack = this->packs_[index];
+  if (pack.recorded && now - pack.last_record < this->record_interval_)
+    return;
+
+  HistorySample sample{};
+  sample.pack = telemetry.pack;
+  sample.timestamp = now;
+  sample.state_of_charge = std::isnan(telemetry.state_of_charge) ? 0 : lroundf(telemetry.state_of_charge * 10.0f);
+  sample.current = lroundf(telemetry.current * 100.0f);
+  sample.total_voltage = lroundf(telemetry.total_voltage * 100.0f);
+  sample.cells = telemetry.cells;
+  sample.cell_voltages = telemetry.cell_voltages;
+  sample.temperature_sensors = telemetry.temperature_sensors;
+  sample.temperatures = telemetry.temperatures;
+
+  uint8_t record[MAX_RECORD_SIZE];
+  const size_t length = encode_record(sample, record);
+  if (length == 0) {
+    ESP_LOGW(TAG, "Telemetry of pack 0x%02X exceeds a record", telemetry.pack);
+    return;
+  }
+
+  const uint32_t dropped = this->buffer_.dropped();
+  this->buffer_.push(record, length);
+  if (this->buffer_.dropped() != dropped) {
+    ESP_LOGW(TAG, "Buffer full. Dropped the oldest record");
+  }
+  ESP_LOGV(TAG, "Recorded pack 0x%02X (%u bytes, %" PRIu32 " records)", telemetry.pack, (unsigned) length,
+           this->buffer_.records());
+
+  pack.recorded = true;
+  pack.last_record = now;
+}
+
+void SeplosHistory::drain_() {
+  if (this->buffer_.size() == 0 || !this->is_online_())
+    return;
+
+  const uint32_t now = millis();
+  this->chunk_.clear();
+  for (uint8_t i = 0; i < CHUNK_HEADER_SIZE; i++) {
+    this->chunk_.push_back(uint8_t(now >> (i * 8)));
+  }
+  this->buffer_.pop(this->chunk_, this->drain_size_ - CHUNK_HEADER_SIZE);
+
+  ESP_LOGD(TAG, "Draining %u bytes, %" PRIu32 " records left", (unsigned) this->chunk_.size(),
+           this->buffer_.records());
+  this->drain_callback_.call(this->chunk_);
+}
+
+// The records are handed over to the same connection the live values go through
+bool SeplosHistory::is_online_() const {
+#ifdef USE_MQTT
+  if (mqtt::global_mqtt_client != nullptr)
+    return mqtt::global_mqtt_client->is_connected();
+#endif
+#ifdef USE_API
+  if (api::global_api_server != nullptr)
+    return api::global_api_server->is_connected();
+#endif
+  return network::is_connected();
+}
+
+void SeplosHistory::dump_config() {
+  ESP_LOGCONFIG(TAG, "SeplosHistory:");
+  ESP_LOGCONFIG(TAG, "  Packs: %d", (int) this->packs_.size());
+  ESP_LOGCONFIG(TAG, "  Buffer size: %u bytes%s", (unsigned) this->buffer_size_,
+                this->buffer_.is_allocated() ? "" : " (allocation failed)");
+  ESP_LOGCONFIG(TAG, "  Record interval: %" PRIu32 " ms", this->record_interval_);
+  ESP_LOGCONFIG(TAG, "  Drain: %u bytes every %" PRIu32 " ms", this->drain_size_, this->drain_interval_);
+}
+
+}  // namespace seplos_history
+}  // namespace esphome
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+#include "history_buffer.h"
+
+#include <vector>
+
+namespace esphome {
+namespace seplos_history {
+
+// Keeps the telemetry of the packs while the node is offline and hands it over in chunks once it's back.
+// A chunk is the uptime in ms (uint32_t little endian) at the time of the drain followed by whole records,
+// see encode_record(). The receiver derives the time of a record from the difference of both uptimes.
+class SeplosHistory : public Component {
+ public:
+  void add_pack(seplos_bms::SeplosBms *pack);
+
+  void set_buffer_size(size_t buffer_size) { buffer_size_ = buffer_size; }
+  void set_record_interval(uint32_t record_interval) { record_interval_ = record_interval; }
+  void set_drain_interval(uint32_t drain_interval) { drain_interval_ = drain_interval; }
+  void set_drain_size(uint16_t drain_size) { drain_size_ = drain_size; }
+
+  void add_on_drain_callback(std::function<void(const std::vector<uint8_t> &)> &&callback) {
+    this->drain_callback_.add(std::move(callback));
+  }
+
+  void setup() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  size_t buffer_size_{16384};
+  uint32_t record_interval_{60000};
+  uint32_t drain_interval_{1000};
+  uint16_t drain_size_{1024};
+
+  HistoryBuffer buffer_;
+  // Time of the last record of each pack. Packs report more often than they are recorded
+  struct Pack {
+    bool recorded;
+    uint32_t last_record;
+  };
+  std::vector<Pack> packs_;
+  std::vector<uint8_t> chunk_;
+
+  CallbackManager<void(const std::vector<uint8_t> &)> drain_callback_;
+
+  void on_telemetry_(uint8_t index, const seplos_bms::SeplosTelemetry &telemetry);
+  void drain_();
+  bool is_online_() const;
+};
+
+class DrainTrigger : public Trigger<std::vector<uint8_t>> {
+ public:
+  explicit DrainTrigger(SeplosHistory *parent) {
+    parent->add_on_drain_callback([this](const std::vector<uint8_t> &data) { this->trigger(data); });
+  }
+};
+
+}  // namespace seplos_history
+}  // namespace esphome
@@ -1,21 +1,56 @@
 from esphome import pins
 import esphome.codegen as cg
-from esphome.components import uart
+from esphome.components import uart, web_server_base
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
 import esphome.config_validation as cv
-from esphome.const import CONF_ADDRESS, CONF_FLOW_CONTROL_PIN, CONF_ID
+from esphome.const import (
+    CONF_ADDRESS,
+    CONF_BUFFER_SIZE,
+    CONF_FLOW_CONTROL_PIN,
+    CONF_ID,
+    CONF_TIMEOUT,
+    CONF_URL,
+)
 from esphome.cpp_helpers import gpio_pin_expression
 
 DEPENDENCIES = ["uart"]
+AUTO_LOAD = ["sensor"]
 MULTI_CONF = True
 
 CONF_SEPLOS_MODBUS_ID = "seplos_modbus_id"
 CONF_RX_TIMEOUT = "rx_timeout"
+CONF_RESPONSE_TIMEOUT = "response_timeout"
+CONF_INTER_FRAME_GAP = "inter_frame_gap"
+CONF_MAX_RETRIES = "max_retries"
+CONF_BATCH_POLL = "batch_poll"
+CONF_BATCH_ADDRESS = "batch_address"
+CONF_UNSOLICITED_FRAMES = "unsolicited_frames"
+CONF_DEDICATED_TASK = "dedicated_task"
+CONF_CAPTURE = "capture"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_RX_BYTES = "rx_bytes"
+CONF_PUBLISHES = "publishes"
 CONF_PROTOCOL_VERSION = "protocol_version"
 CONF_OVERRIDE_PACK = "override_pack"
+CONF_TRANSPORT = "transport"
+CONF_DISCOVERY = "discovery"
+CONF_MAX_ADDRESS = "max_address"
+CONF_PROTOCOL_VERSIONS = "protocol_versions"
+
+# Learn the address or protocol version of a device from the discovery of the bus
+AUTO = "auto"
 
 seplos_modbus_ns = cg.esphome_ns.namespace("seplos_modbus")
-SeplosModbus = seplos_modbus_ns.class_("SeplosModbus", cg.Component, uart.UARTDevice)
+SeplosModbus = seplos_modbus_ns.class_(
+    "SeplosModbus", cg.PollingComponent, uart.UARTDevice
+)
 SeplosModbusDevice = seplos_modbus_ns.class_("SeplosModbusDevice")
+SeplosTransport = seplos_modbus_ns.enum("SeplosTransport")
+
+TRANSPORTS = {
+    "ascii": SeplosTransport.TRANSPORT_ASCII,
+    "modbus_rtu": SeplosTransport.TRANSPORT_MODBUS_RTU,
+}
 
 CONFIG_SCHEMA = (
     cv.Schema(
@@ -24,10 +59,64 @@ CONFIG_SCHEMA = (
             cv.Optional(
                 CONF_RX_TIMEOUT, default="150ms"
             ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_RESPONSE_TIMEOUT, default="500ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_INTER_FRAME_GAP, default="50ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_RETRIES, default=2): cv.int_range(min=0, max=10),
+            cv.Optional(CONF_BATCH_POLL, default=False): cv.boolean,
+            cv.Optional(CONF_BATCH_ADDRESS, default=0x00): cv.hex_uint8_t,
+            # Decode the frames of a BMS pushing its telemetry without being asked. Otherwise frames which
+            # don't answer the request in flight are dropped
+            cv.Optional(CONF_UNSOLICITED_FRAMES, default=False): cv.boolean,
+            # Serve the bus from its own FreeRTOS task so multiple buses don't block each other
+            cv.Optional(CONF_DEDICATED_TASK): cv.All(cv.only_on_esp32, cv.boolean),
+            # Bound the work of a main loop iteration: Parse at most rx_bytes, dispatch a finished frame in a
+            # loop of its own and publish at most `publishes` sensor states of all devices on the bus per loop
+            cv.Optional(CONF_LOOP_BUDGET): cv.Schema(
+                {
+                    cv.Optional(CONF_RX_BYTES, default=64): cv.int_range(
+                        min=16, max=1024
+                    ),
+                    cv.Optional(CONF_PUBLISHES, default=8): cv.int_range(
+                        min=1, max=255
+                    ),
+                }
+            ),
+            # Record the raw frames on the bus and serve them at the URL of the web server
+            cv.Optional(CONF_CAPTURE): cv.Schema(
+                {
+                    cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(
+                        web_server_base.WebServerBase
+                    ),
+                    cv.Optional(CONF_BUFFER_SIZE, default="4kB"): cv.All(
+                        cv.validate_bytes, cv.int_range(min=512)
+                    ),
+                    cv.Optional(CONF_URL, default="/seplos_modbus/capture"): cv.string,
+                }
+            ),
+            # Sweep the bus for the packs of devices with `address: auto` or `protocol_version: auto` at startup.
+            # The packs found are cached in flash and only verified on later boots
+            cv.Optional(CONF_DISCOVERY, default={}): cv.Schema(
+                {
+                    cv.Optional(CONF_MAX_ADDRESS, default=0x0F): cv.All(
+                        cv.hex_uint8_t, cv.Range(max=0xFE)
+                    ),
+                    cv.Optional(
+                        CONF_TIMEOUT, default="100ms"
+                    ): cv.positive_time_period_milliseconds,
+                    # VER of the probes, in this order. Seplos 0x20, Boqiang 0x26
+                    cv.Optional(
+                        CONF_PROTOCOL_VERSIONS, default=[0x20, 0x26]
+                    ): cv.All(cv.ensure_list(cv.hex_uint8_t), cv.Length(min=1, max=4)),
+                }
+            ),
             cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
         }
     )
-    .extend(cv.COMPONENT_SCHEMA)
+    .extend(cv.polling_component_schema("60s"))
     .extend(uart.UART_DEVICE_SCHEMA)
 )
 
@@ -39,6 +128,30 @@ async def to_code(config):
     await uart.register_uart_device(var, config)
 
     cg.add(var.set_rx_timeout(config[CONF_RX_TIMEOUT]))
+    cg.add(var.set_response_timeout(config[CONF_RESPONSE_TIMEOUT]))
+    cg.add(var.set_inter_frame_gap(config[CONF_INTER_FRAME_GAP]))
+    cg.add(var.set_max_retries(config[CONF_MAX_RETRIES]))
+    cg.add(var.set_batch_poll(config[CONF_BATCH_POLL]))
+    cg.add(var.set_batch_address(config[CONF_BATCH_ADDRESS]))
+    cg.add(var.set_unsolicited_frames(config[CONF_UNSOLICITED_FRAMES]))
+    if config.get(CONF_DEDICATED_TASK, False):
+        cg.add(var.set_dedicated_task(True))
+    if CONF_LOOP_BUDGET in config:
+        loop_budget = config[CONF_LOOP_BUDGET]
+        cg.add(var.set_rx_byte_budget(loop_budget[CONF_RX_BYTES]))
+        cg.add(var.set_publish_budget(loop_budget[CONF_PUBLISHES]))
+    if CONF_CAPTURE in config:
+        capture = config[CONF_CAPTURE]
+        cg.add_define("USE_SEPLOS_MODBUS_CAPTURE")
+        cg.add(var.set_capture_buffer_size(capture[CONF_BUFFER_SIZE]))
+        base = await cg.get_variable(capture[CONF_WEB_SERVER_BASE_ID])
+        cg.add(var.set_capture_web_server(base, capture[CONF_URL]))
+    discovery = config[CONF_DISCOVERY]
+    cg.add(var.set_discovery_key(str(config[CONF_ID])))
+    cg.add(var.set_discovery_max_address(discovery[CONF_MAX_ADDRESS]))
+    cg.add(var.set_discovery_timeout(discovery[CONF_TIMEOUT]))
+    for protocol_version in discovery[CONF_PROTOCOL_VERSIONS]:
+        cg.add(var.add_discovery_protocol_version(protocol_version))
     if CONF_FLOW_CONTROL_PIN in config:
         pin = await gpio_pin_expression(config[CONF_FLOW_CONTROL_PIN])
         cg.add(var.set_flow_control_pin(pin))
@@ -47,23 +160,44 @@ async def to_code(config):
 def seplos_modbus_device_schema(default_protocol_version, default_address):
     schema = {
         cv.GenerateID(CONF_SEPLOS_MODBUS_ID): cv.use_id(SeplosModbus),
-        cv.Optional(CONF_ADDRESS, default=default_address): cv.hex_uint8_t,
+        cv.Optional(CONF_ADDRESS, default=default_address): cv.Any(
+            cv.one_of(AUTO, lower=True), cv.hex_uint8_t
+        ),
         cv.Optional(
             CONF_PROTOCOL_VERSION, default=default_protocol_version
-        ): cv.hex_uint8_t,
+        ): cv.Any(cv.one_of(AUTO, lower=True), cv.hex_uint8_t),
         cv.Optional(CONF_OVERRIDE_PACK): cv.hex_uint8_t,
+        # Seplos V2 boards speak the ASCII protocol, V3 boards Modbus-RTU. Both can share a bus at the same baud rate
+        cv.Optional(CONF_TRANSPORT, default="ascii"): cv.enum(TRANSPORTS, lower=True),
     }
     return cv.Schema(schema)
 
 
+def validate_seplos_modbus_device(config):
+    if config[CONF_TRANSPORT] != "ascii" and AUTO in (
+        config[CONF_ADDRESS],
+        config[CONF_PROTOCOL_VERSION],
+    ):
+        raise cv.Invalid("The discovery is supported by the ASCII transport only")
+    return config
+
+
 async def register_seplos_modbus_device(var, config):
     parent = await cg.get_variable(config[CONF_SEPLOS_MODBUS_ID])
     cg.add(var.set_parent(parent))
-    cg.add(var.set_address(config[CONF_ADDRESS]))
-    cg.add(var.set_protocol_version(config[CONF_PROTOCOL_VERSION]))
+    if config[CONF_ADDRESS] == AUTO:
+        cg.add(var.set_discover_address(True))
+        cg.add(var.set_discover_pack(CONF_OVERRIDE_PACK not in config))
+    else:
+        cg.add(var.set_address(config[CONF_ADDRESS]))
+    if config[CONF_PROTOCOL_VERSION] == AUTO:
+        cg.add(var.set_discover_protocol_version(True))
+    else:
+        cg.add(var.set_protocol_version(config[CONF_PROTOCOL_VERSION]))
+    cg.add(var.set_transport(config[CONF_TRANSPORT]))
     cg.add(parent.register_device(var))
 
     if CONF_OVERRIDE_PACK in config:
         cg.add(var.set_pack(config[CONF_OVERRIDE_PACK]))
-    else:
+    elif config[CONF_ADDRESS] != AUTO:
         cg.add(var.set_pack(config[CONF_ADDRESS]))
@@ -0,0 +1,124 @@
+#include "capture.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace esphome {
+namespace seplos_modbus {
+
+bool SeplosModbusCapture::allocate(size_t size) {
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  this->buffer_ = allocator.allocate(size);
+  if (this->buffer_ == nullptr)
+    return false;
+
+  this->capacity_ = size;
+  return true;
+}
+
+void SeplosModbusCapture::begin_record(uint32_t timestamp, uint8_t direction) {
+  if (this->buffer_ == nullptr)
+    return;
+
+  this->end_record();
+  this->timestamp_ = timestamp;
+  this->direction_ = direction;
+  this->frame_length_ = 0;
+  this->recording_ = true;
+}
+
+void SeplosModbusCapture::append(const uint8_t *data, uint16_t length) {
+  if (!this->recording_)
+    return;
+
+  length = std::min<uint16_t>(length, CAPTURE_MAX_FRAME_SIZE - this->frame_length_);
+  memcpy(this->frame_ + this->frame_length_, data, length);
+  this->frame_length_ += length;
+}
+
+void SeplosModbusCapture::end_record() {
+  if (!this->recording_)
+    return;
+
+  this->recording_ = false;
+  if (this->frame_length_ == 0)
+    return;
+
+  uint8_t header[CAPTURE_HEADER_SIZE];
+  for (uint8_t i = 0; i < 4; i++) {
+    header[i] = uint8_t(this->timestamp_ >> (i * 8));
+  }
+  header[4] = this->direction_;
+  header[5] = uint8_t(this->frame_length_ >> 0);
+  header[6] = uint8_t(this->frame_length_ >> 8);
+  const size_t length = sizeof(header) + this->frame_length_;
+
+  LockGuard guard(this->lock_);
+  if (!this->make_room_(length))
+    return;
+
+  const size_t position = this->head_ + this->length_;
+  this->write_at_(position, header, sizeof(header));
+  this->write_at_(position + sizeof(header), this->frame_, this->frame_length_);
+  this->length_ += length;
+}
+
+void SeplosModbusCapture::copy_to(std::vector<uint8_t> &out) {
+  // Allocate outside of the lock, the ring never grows beyond its capacity
+  out.reserve(this->capacity_);
+
+  LockGuard guard(this->lock_);
+  out.resize(this->length_);
+  const size_t first = std::min(this->length_, this->capacity_ - this->head_);
+  memcpy(out.data(), this->buffer_ + this->head_, first);
+  memcpy(out.data() + first, this->buffer_, this->length_ - first);
+}
+
+bool SeplosModbusCapture::make_room_(size_t length) {
+  if (length > this->capacity_)
+    return false;
+
+  while (this->capacity_ - this->length_ < length) {
+    const size_t record_size =
+        CAPTURE_HEADER_SIZE + (this->read_at_(this->head_ + 5) | (this->read_at_(this->head_ + 6) << 8));
+    this->head_ = (this->head_ + record_size) % this->capacity_;
+    this->length_ -= record_size;
+  }
+  return true;
+}
+
+void SeplosModbusCapture::write_at_(size_t position, const uint8_t *data, size_t length) {
+  position %= this->capacity_;
+  const size_t first = std::min(length, this->capacity_ - position);
+  memcpy(this->buffer_ + position, data, first);
+  memcpy(this->buffer_, data + first, length - first);
+}
+
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+void SeplosModbusCaptureHandler::handleRequest(AsyncWebServerRequest *request) {
+  // Every response owns its copy, so concurrent downloads don't share a buffer
+  auto download = std::make_shared<std::vector<uint8_t>>();
+  this->capture_->copy_to(*download);
+#ifdef USE_ARDUINO
+  // The response is sent after handleRequest() returned. The copy lives as long as the response
+  AsyncWebServerResponse *response =
+      request->beginResponse("application/octet-stream", download->size(),
+                             [download](uint8_t *buffer, size_t max_length, size_t index) -> size_t {
+                               const size_t length = std::min(max_length, download->size() - index);
+                               memcpy(buffer, download->data() + index, length);
+                               return length;
+                             });
+#else
+  // The response is sent before send() returns
+  AsyncWebServerResponse *response =
+      request->beginResponse_P(200, "application/octet-stream", download->data(), download->size());
+#endif
+  response->addHeader("Content-Disposition", "attachment; filename=\"seplos_modbus.bin\"");
+  request->send(response);
+}
+#endif
+
+}  // namespace seplos_modbus
+}  // namespace esphome
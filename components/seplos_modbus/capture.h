@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+#include "esphome/components/web_server_base/web_server_base.h"
+#endif
+
+namespace esphome {
+namespace seplos_modbus {
+
+static const uint8_t CAPTURE_RX = 0x00;
+static const uint8_t CAPTURE_TX = 0x01;
+static const uint8_t CAPTURE_HEADER_SIZE = 7;
+// Longest frame recorded, the bytes of a longer run are left out
+static const uint16_t CAPTURE_MAX_FRAME_SIZE = 512;
+
+// Fixed-size ring of the raw frames seen on the bus. Every record is a header of a timestamp in ms (uint32_t),
+// the direction (uint8_t) and the frame length (uint16_t), both little endian, followed by the frame bytes as
+// seen on the wire. The oldest records are dropped to make room for new ones.
+//
+// The bytes of a frame are collected aside and enter the ring at once by end_record(), so the ring only ever
+// holds complete records and is locked once per frame. The ring may be copied from another task, e.g. the one
+// of the web server.
+class SeplosModbusCapture {
+ public:
+  // Prefers PSRAM where available
+  bool allocate(size_t size);
+
+  void begin_record(uint32_t timestamp, uint8_t direction);
+  void append(const uint8_t *data, uint16_t length);
+  void append(uint8_t byte) {
+    if (this->recording_ && this->frame_length_ < CAPTURE_MAX_FRAME_SIZE)
+      this->frame_[this->frame_length_++] = byte;
+  }
+  void end_record();
+  bool is_recording() const { return this->recording_; }
+
+  // Copies the records from the oldest to the newest
+  void copy_to(std::vector<uint8_t> &out);
+
+ protected:
+  bool make_room_(size_t length);
+  void write_at_(size_t position, const uint8_t *data, size_t length);
+  uint8_t read_at_(size_t position) const { return this->buffer_[position % this->capacity_]; }
+
+  // Guards the ring below
+  Mutex lock_;
+  uint8_t *buffer_{nullptr};
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t length_{0};
+
+  // The record in progress, only touched by the task recording
+  uint32_t timestamp_{0};
+  uint8_t direction_{0};
+  bool recording_{false};
+  uint16_t frame_length_{0};
+  uint8_t frame_[CAPTURE_MAX_FRAME_SIZE];
+};
+
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+// Serves the capture as application/octet-stream
+class SeplosModbusCaptureHandler : public AsyncWebHandler {
+ public:
+  SeplosModbusCaptureHandler(SeplosModbusCapture *capture, const char *url) : capture_(capture), url_(url) {}
+
+  bool canHandle(AsyncWebServerRequest *request) override {
+    return request->method() == HTTP_GET && request->url() == this->url_;
+  }
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ protected:
+  SeplosModbusCapture *capture_;
+  const char *url_;
+};
+#endif
+
+}  // namespace seplos_modbus
+}  // namespace esphome
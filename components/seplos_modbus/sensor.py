@@ -0,0 +1,128 @@
+import esphome.codegen as cg
+from esphome.components import sensor
+import esphome.config_validation as cv
+from esphome.const import (
+    DEVICE_CLASS_EMPTY,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_EMPTY,
+    UNIT_MILLISECOND,
+)
+
+from . import CONF_SEPLOS_MODBUS_ID, SeplosModbus
+
+DEPENDENCIES = ["seplos_modbus"]
+
+CODEOWNERS = ["@syssi"]
+
+CONF_MIN_FREE_HEAP = "min_free_heap"
+CONF_REQUESTS_SENT = "requests_sent"
+CONF_RESPONSES_RECEIVED = "responses_received"
+CONF_CRC_ERRORS = "crc_errors"
+CONF_HEADER_RESYNCS = "header_resyncs"
+CONF_RX_TIMEOUTS = "rx_timeouts"
+CONF_UNKNOWN_ADDRESS_FRAMES = "unknown_address_frames"
+CONF_STRAY_FRAMES = "stray_frames"
+CONF_MIN_LATENCY = "min_latency"
+CONF_AVERAGE_LATENCY = "average_latency"
+CONF_P95_LATENCY = "p95_latency"
+CONF_THROUGHPUT = "throughput"
+
+ICON_MIN_FREE_HEAP = "mdi:memory"
+ICON_REQUESTS_SENT = "mdi:upload-network-outline"
+ICON_RESPONSES_RECEIVED = "mdi:download-network-outline"
+ICON_CRC_ERRORS = "mdi:alert-circle-outline"
+ICON_HEADER_RESYNCS = "mdi:sync-alert"
+ICON_RX_TIMEOUTS = "mdi:timer-alert-outline"
+ICON_UNKNOWN_ADDRESS_FRAMES = "mdi:help-network-outline"
+ICON_STRAY_FRAMES = "mdi:network-off-outline"
+ICON_LATENCY = "mdi:timer-outline"
+ICON_THROUGHPUT = "mdi:swap-horizontal"
+
+UNIT_BYTES = "B"
+UNIT_BYTES_PER_SECOND = "B/s"
+
+COUNTERS = {
+    CONF_REQUESTS_SENT: ICON_REQUESTS_SENT,
+    CONF_RESPONSES_RECEIVED: ICON_RESPONSES_RECEIVED,
+    CONF_CRC_ERRORS: ICON_CRC_ERRORS,
+    CONF_HEADER_RESYNCS: ICON_HEADER_RESYNCS,
+    CONF_RX_TIMEOUTS: ICON_RX_TIMEOUTS,
+    CONF_UNKNOWN_ADDRESS_FRAMES: ICON_UNKNOWN_ADDRESS_FRAMES,
+    CONF_STRAY_FRAMES: ICON_STRAY_FRAMES,
+}
+
+LATENCIES = [
+    CONF_MIN_LATENCY,
+    CONF_AVERAGE_LATENCY,
+    CONF_P95_LATENCY,
+]
+
+SENSORS = [
+    CONF_MIN_FREE_HEAP,
+    CONF_THROUGHPUT,
+    *COUNTERS,
+    *LATENCIES,
+]
+
+CONFIG_SCHEMA = (
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_SEPLOS_MODBUS_ID): cv.use_id(SeplosModbus),
+            cv.Optional(CONF_MIN_FREE_HEAP): sensor.sensor_schema(
+                unit_of_measurement=UNIT_BYTES,
+                icon=ICON_MIN_FREE_HEAP,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_EMPTY,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            # Bytes sent and received per second since the previous update
+            cv.Optional(CONF_THROUGHPUT): sensor.sensor_schema(
+                unit_of_measurement=UNIT_BYTES_PER_SECOND,
+                icon=ICON_THROUGHPUT,
+                accuracy_decimals=1,
+                device_class=DEVICE_CLASS_EMPTY,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+        }
+    )
+    .extend(
+        {
+            cv.Optional(key): sensor.sensor_schema(
+                unit_of_measurement=UNIT_EMPTY,
+                icon=icon,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_EMPTY,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key, icon in COUNTERS.items()
+        }
+    )
+    .extend(
+        {
+            # Request to response latency of the recent requests of all devices
+            cv.Optional(key): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                icon=ICON_LATENCY,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_EMPTY,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in LATENCIES
+        }
+    )
+)
+
+
+async def to_code(config):
+    hub = await cg.get_variable(config[CONF_SEPLOS_MODBUS_ID])
+    for key in SENSORS:
+        if key in config:
+            conf = config[key]
+            sens = await sensor.new_sensor(conf)
+            cg.add(getattr(hub, f"set_{key}_sensor")(sens))
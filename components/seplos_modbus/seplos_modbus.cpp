@@ -1,40 +1,754 @@
 #include "seplos_modbus.h"
+#include "esphome/core/application.h"
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
 
+#include <cmath>
+
+#ifdef USE_ESP8266
+#include <Esp.h>
+#endif
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#endif
+
 namespace esphome {
 namespace seplos_modbus {
 
 static const char *const TAG = "seplos_modbus";
 
-static const uint16_t MAX_RESPONSE_SIZE = 340;
+// The records of a batch response are split by the dynamic layout of this protocol version
+static const uint8_t BATCH_PROTOCOL_VERSION = 0x20;
 
 void SeplosModbus::setup() {
   if (this->flow_control_pin_ != nullptr) {
     this->flow_control_pin_->setup();
   }
+
+#ifdef USE_SENSOR
+  if (this->publish_budget_ > 0) {
+    const auto &sensors = App.get_sensors();
+    this->deferred_slots_.reserve(sensors.size());
+    this->deferred_states_.reserve(sensors.size());
+    for (auto *sensor : sensors) {
+      if (this->deferred_slots_.emplace(sensor, this->deferred_states_.size()).second)
+        this->deferred_states_.push_back({sensor, NAN, false});
+    }
+    this->deferred_queue_.resize(this->deferred_states_.size());
+  }
+#endif
+
+  if (this->capture_buffer_size_ > 0) {
+    this->capture_ = new SeplosModbusCapture();  // NOLINT(cppcoreguidelines-owning-memory)
+    if (!this->capture_->allocate(this->capture_buffer_size_)) {
+      ESP_LOGE(TAG, "Failed to allocate %u bytes for the capture", (unsigned) this->capture_buffer_size_);
+      delete this->capture_;  // NOLINT(cppcoreguidelines-owning-memory)
+      this->capture_ = nullptr;
+    }
+  }
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+  if (this->capture_ != nullptr && this->web_server_base_ != nullptr) {
+    this->web_server_base_->add_handler(new SeplosModbusCaptureHandler(this->capture_, this->capture_url_));
+  }
+#endif
+
+  this->start_discovery_();
+  if (this->discovery_state_ == DISCOVERY_IDLE) {
+    this->start_task_();
+  }
 }
-void SeplosModbus::loop() {
+
+void SeplosModbus::start_task_() {
+#ifdef USE_ESP32
+  if (this->dedicated_task_ &&
+      xTaskCreate(SeplosModbus::bus_task_, "seplos_modbus", 4096, this, 5, &this->task_handle_) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create the bus task");
+    this->mark_failed();
+  }
+#endif
+}
+
+#ifdef USE_ESP32
+void SeplosModbus::bus_task_(void *params) {
+  auto *bus = reinterpret_cast<SeplosModbus *>(params);
+  while (true) {
+    SeplosModbusRequest *request;
+    while ((request = bus->request_inbox_.front()) != nullptr) {
+      bus->enqueue_request_(*request);
+      bus->request_inbox_.pop();
+    }
+    bus->poll_bus_(millis());
+    vTaskDelay(1);
+  }
+}
+#endif
+
+void SeplosModbus::update() {
+  if (this->min_free_heap_ != UINT32_MAX) {
+    this->publish_state_(this->min_free_heap_sensor_, (float) this->min_free_heap_);
+  }
+
+  // Published from a snapshot, the bus task keeps updating the statistics meanwhile
+  uint32_t requests_sent, responses_received, crc_errors, header_resyncs, rx_timeouts, unknown_address_frames,
+      stray_frames, bus_bytes;
+  LatencyHistogram latencies;
+  {
+    LockGuard guard(this->statistics_lock_);
+    requests_sent = this->requests_sent_;
+    responses_received = this->responses_received_;
+    crc_errors = this->crc_errors_;
+    header_resyncs = this->header_resyncs_;
+    rx_timeouts = this->rx_timeouts_;
+    unknown_address_frames = this->unknown_address_frames_;
+    stray_frames = this->stray_frames_;
+    bus_bytes = this->bus_bytes_;
+    latencies = this->latencies_;
+  }
+
+  this->publish_state_(this->requests_sent_sensor_, (float) requests_sent);
+  this->publish_state_(this->responses_received_sensor_, (float) responses_received);
+  this->publish_state_(this->crc_errors_sensor_, (float) crc_errors);
+  this->publish_state_(this->header_resyncs_sensor_, (float) header_resyncs);
+  this->publish_state_(this->rx_timeouts_sensor_, (float) rx_timeouts);
+  this->publish_state_(this->unknown_address_frames_sensor_, (float) unknown_address_frames);
+  this->publish_state_(this->stray_frames_sensor_, (float) stray_frames);
+  if (latencies.count() > 0) {
+    this->publish_state_(this->min_latency_sensor_, (float) latencies.min());
+    this->publish_state_(this->average_latency_sensor_, latencies.average());
+    this->publish_state_(this->p95_latency_sensor_, (float) latencies.percentile(0.95f));
+  }
+
   const uint32_t now = millis();
+  if (this->last_update_ != 0 && now != this->last_update_) {
+    this->publish_state_(this->throughput_sensor_,
+                         (bus_bytes - this->last_bus_bytes_) * 1000.0f / (now - this->last_update_));
+  }
+  this->last_bus_bytes_ = bus_bytes;
+  this->last_update_ = now;
+}
+
+uint32_t LatencyHistogram::percentile(float fraction) const {
+  const uint32_t rank = this->count_ * fraction;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += this->buckets_[i];
+    if (seen > rank)
+      return (i + 1) * LATENCY_BUCKET_WIDTH;
+  }
+  return LATENCY_BUCKETS * LATENCY_BUCKET_WIDTH;
+}
+
+void LatencyHistogram::decay_() {
+  uint32_t count = 0;
+  for (auto &bucket : this->buckets_) {
+    bucket /= 2;
+    count += bucket;
+  }
+  this->sum_ = (uint64_t) this->sum_ * count / this->count_;
+  this->count_ = count;
+  // A single low outlier is forgotten after two windows
+  this->min_ = this->window_min_;
+  this->window_min_ = UINT32_MAX;
+}
+
+void SeplosModbus::track_free_heap_() {
+  if (this->min_free_heap_sensor_ == nullptr)
+    return;
+
+  uint32_t free_heap = UINT32_MAX;
+#ifdef USE_ESP8266
+  free_heap = ESP.getFreeHeap();  // NOLINT(readability-static-accessed-through-instance)
+#endif
+#ifdef USE_ESP32
+  free_heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+#endif
+  this->min_free_heap_ = std::min(this->min_free_heap_, free_heap);
+}
+
+void SeplosModbus::publish_state_(sensor::Sensor *sensor, float value) {
+  if (sensor == nullptr)
+    return;
 
+  sensor->publish_state(value);
+}
+void SeplosModbus::loop() {
+  this->publish_deferred_states_();
+
+#ifdef USE_ESP32
+  if (this->task_handle_ != nullptr) {
+    SeplosModbusFrame *frame;
+    while ((frame = this->frame_outbox_.front()) != nullptr) {
+      if (frame->failed_device != nullptr) {
+        frame->failed_device->on_seplos_modbus_failure(frame->function);
+      } else {
+        this->dispatch_(frame->function, frame->batch, frame->transport, frame->register_address, frame->data,
+                        frame->length);
+      }
+      this->frame_outbox_.pop();
+    }
+    return;
+  }
+#endif
+
+  // The decoding of the frame finished by the previous loop gets a loop of its own
+  if (this->dispatch_pending_) {
+    this->dispatch_pending_ = false;
+    this->dispatch_(this->dispatch_function_, this->dispatch_batch_, this->dispatch_transport_,
+                    this->dispatch_register_address_, this->frame_, this->dispatch_length_);
+    return;
+  }
+
+  this->poll_bus_(millis());
+}
+
+void SeplosModbus::publish_sensor_state(sensor::Sensor *sensor, float value) {
+  if (this->publish_budget_ == 0) {
+    sensor->publish_state(value);
+    return;
+  }
+
+  // A sensor without a slot wasn't registered with the application
+  const auto slot = this->deferred_slots_.find(sensor);
+  if (slot == this->deferred_slots_.end()) {
+    sensor->publish_state(value);
+    return;
+  }
+
+  DeferredState &state = this->deferred_states_[slot->second];
+  state.value = value;
+  if (!state.pending) {
+    state.pending = true;
+    this->deferred_queue_[(this->deferred_head_ + this->deferred_count_) % this->deferred_queue_.size()] =
+        slot->second;
+    this->deferred_count_++;
+  }
+}
+
+PollStatistics SeplosModbus::get_poll_statistics(const SeplosModbusDevice *device) {
+  LockGuard guard(this->statistics_lock_);
+  return device->poll_statistics_;
+}
+
+bool SeplosModbus::get_sensor_state(sensor::Sensor *sensor, float *state) const {
+  if (this->publish_budget_ > 0) {
+    const auto slot = this->deferred_slots_.find(sensor);
+    if (slot != this->deferred_slots_.end() && this->deferred_states_[slot->second].pending) {
+      *state = this->deferred_states_[slot->second].value;
+      return true;
+    }
+  }
+
+  if (!sensor->has_state())
+    return false;
+  *state = sensor->get_raw_state();
+  return true;
+}
+
+void SeplosModbus::publish_deferred_states_() {
+  for (uint8_t i = 0; i < this->publish_budget_ && this->deferred_count_ > 0; i++) {
+    DeferredState &state = this->deferred_states_[this->deferred_queue_[this->deferred_head_]];
+    this->deferred_head_ = (this->deferred_head_ + 1) % this->deferred_queue_.size();
+    this->deferred_count_--;
+    state.pending = false;
+    state.sensor->publish_state(state.value);
+  }
+}
+
+void SeplosModbus::poll_bus_(uint32_t now) {
   if (now - this->last_seplos_modbus_byte_ > this->rx_timeout_) {
-    ESP_LOGVV(TAG, "Buffer cleared due to timeout: %s",
-              format_hex_pretty(&this->rx_buffer_.front(), this->rx_buffer_.size()).c_str());
-    this->rx_buffer_.clear();
+    if (this->rx_length_ > 0) {
+      ESP_LOGVV(TAG, "Buffer cleared due to timeout: %s", format_hex_pretty(this->frame_, this->frame_length_).c_str());
+      this->count_(this->rx_timeouts_);
+    }
+    if (this->capture_ != nullptr) {
+      this->capture_->end_record();
+    }
+    this->rx_length_ = 0;
+    this->skip_until_silence_ = false;
     this->last_seplos_modbus_byte_ = now;
   }
 
-  while (this->available()) {
+  uint32_t received = 0;
+  for (uint16_t bytes = 0; this->available(); bytes++) {
+    // Leave the rest to the next loop
+    if (bytes == this->rx_byte_budget_ && this->rx_byte_budget_ > 0)
+      break;
+
     uint8_t byte;
     this->read_byte(&byte);
-    if (this->parse_seplos_modbus_byte_(byte)) {
+    this->last_bus_activity_ = now;
+    received++;
+    if (this->capture_ != nullptr) {
+      if (!this->capture_->is_recording()) {
+        this->capture_->begin_record(now, CAPTURE_RX);
+      }
+      this->capture_->append(byte);
+    }
+    // A Modbus-RTU response has no start of frame. It's expected while a Modbus-RTU request is pending only
+    const bool parsed = (this->waiting_for_response_ && this->pending_.transport == TRANSPORT_MODBUS_RTU)
+                            ? this->parse_modbus_rtu_byte_(byte)
+                            : this->parse_seplos_modbus_byte_(byte);
+    if (parsed) {
       this->last_seplos_modbus_byte_ = now;
     } else {
-      ESP_LOGVV(TAG, "Buffer cleared due to reset: %s",
-                format_hex_pretty(&this->rx_buffer_.front(), this->rx_buffer_.size()).c_str());
-      this->rx_buffer_.clear();
+      if (this->capture_ != nullptr) {
+        this->capture_->end_record();
+      }
+      // Drop the remainder of an aborted frame silently. Bytes after a finished frame are a new run
+      if (this->rx_length_ > 0 && byte != 0x0D) {
+        ESP_LOGVV(TAG, "Buffer cleared due to reset: %s", format_hex_pretty(this->frame_, this->frame_length_).c_str());
+        this->skip_until_sof_ = true;
+      }
+      this->rx_length_ = 0;
     }
+    if (this->dispatch_pending_)
+      break;
+  }
+  if (received > 0)
+    this->count_(this->bus_bytes_, received);
+
+  if (this->discovery_state_ != DISCOVERY_IDLE) {
+    this->poll_discovery_(now);
+    return;
   }
+
+  this->check_response_timeout_(now);
+  this->transmit_next_request_(now);
+}
+
+void SeplosModbus::start_discovery_() {
+  bool needed = false;
+  for (auto *device : this->devices_) {
+    needed |= !device->bound_;
+  }
+  if (!needed || this->discovery_protocol_versions_.empty())
+    return;
+
+  // A changed discovery configuration invalidates the cache
+  std::string key = "seplos_modbus_discovery_" + this->discovery_key_ + "_" + to_string(this->discovery_max_address_);
+  for (uint8_t protocol_version : this->discovery_protocol_versions_) {
+    key += "_" + to_string(protocol_version);
+  }
+  this->discovery_preference_ = global_preferences->make_preference<SeplosDiscoveryCache>(fnv1_hash(key), true);
+
+  this->probe_index_ = 0;
+  this->probe_version_ = 0;
+  if (this->discovery_preference_.load(&this->discovered_) && this->discovered_.count > 0 &&
+      this->discovered_.count <= MAX_DISCOVERED_PACKS) {
+    ESP_LOGI(TAG, "Verifying the %d packs of the last discovery", this->discovered_.count);
+    this->discovery_state_ = DISCOVERY_VERIFY;
+  } else {
+    ESP_LOGI(TAG, "Sweeping addresses 0x00 to 0x%02X for packs", this->discovery_max_address_);
+    this->discovered_.count = 0;
+    this->discovery_state_ = DISCOVERY_SWEEP;
+  }
+}
+
+void SeplosModbus::poll_discovery_(uint32_t now) {
+  if (this->waiting_for_response_) {
+    // Like a response to a request, a probe response still arriving is waited for. A stalled one is cleared by
+    // poll_bus_() after the RX timeout
+    if (now - this->last_send_ < this->discovery_timeout_ || this->available() || this->rx_length_ > 0)
+      return;
+
+    this->waiting_for_response_ = false;
+    this->next_probe_(false);
+    if (this->discovery_state_ == DISCOVERY_IDLE)
+      return;
+  }
+
+  if (this->rx_length_ > 0 || this->available() || now - this->last_bus_activity_ < this->inter_frame_gap_)
+    return;
+
+  SeplosModbusRequest request{};
+  if (this->discovery_state_ == DISCOVERY_VERIFY) {
+    request.address = this->discovered_.addresses[this->probe_index_];
+    request.protocol_version = this->discovered_.protocol_versions[this->probe_index_];
+  } else {
+    request.address = this->probe_index_;
+    request.protocol_version = this->discovery_protocol_versions_[this->probe_version_];
+  }
+  request.cid1 = 0x46;
+  request.function = 0x4F;
+  request.transport = TRANSPORT_ASCII;
+  this->pending_ = request;
+
+  this->send(request.protocol_version, request.address, request.cid1, request.function, request.info, 0);
+  this->waiting_for_response_ = true;
+  this->count_(this->requests_sent_);
+  this->last_send_ = millis();
+  this->last_bus_activity_ = this->last_send_;
+}
+
+// Any response proves a pack at the address. Its VER is the protocol version of the pack
+void SeplosModbus::on_probe_response_(uint8_t protocol_version) {
+  this->waiting_for_response_ = false;
+  this->count_(this->responses_received_);
+  this->last_bus_activity_ = millis();
+
+  const uint8_t address = this->pending_.address;
+  ESP_LOGI(TAG, "Found pack 0x%02X (protocol version 0x%02X)", address, protocol_version);
+  if (this->discovery_state_ == DISCOVERY_VERIFY) {
+    this->discovered_.protocol_versions[this->probe_index_] = protocol_version;
+  } else if (this->discovered_.count < MAX_DISCOVERED_PACKS) {
+    this->discovered_.addresses[this->discovered_.count] = address;
+    this->discovered_.protocol_versions[this->discovered_.count] = protocol_version;
+    this->discovered_.count++;
+  } else {
+    ESP_LOGW(TAG, "More than %d packs found. Ignoring pack 0x%02X", MAX_DISCOVERED_PACKS, address);
+  }
+
+  this->next_probe_(true);
+}
+
+void SeplosModbus::next_probe_(bool found) {
+  if (this->discovery_state_ == DISCOVERY_VERIFY) {
+    if (!found) {
+      ESP_LOGI(TAG, "Pack 0x%02X of the last discovery didn't respond. Sweeping the bus",
+               this->discovered_.addresses[this->probe_index_]);
+      this->discovered_.count = 0;
+      this->probe_index_ = 0;
+      this->discovery_state_ = DISCOVERY_SWEEP;
+      return;
+    }
+    if (++this->probe_index_ == this->discovered_.count) {
+      this->finish_discovery_();
+    }
+    return;
+  }
+
+  // Try the next protocol version before giving up on an address
+  if (!found && ++this->probe_version_ < this->discovery_protocol_versions_.size())
+    return;
+
+  this->probe_version_ = 0;
+  if (this->probe_index_ == this->discovery_max_address_) {
+    this->finish_discovery_();
+    return;
+  }
+  this->probe_index_++;
+}
+
+void SeplosModbus::finish_discovery_() {
+  // Nothing found isn't cached. The next boot sweeps again
+  if (this->discovery_state_ == DISCOVERY_SWEEP && this->discovered_.count > 0) {
+    this->discovery_preference_.save(&this->discovered_);
+  }
+  this->discovery_state_ = DISCOVERY_IDLE;
+  ESP_LOGI(TAG, "Discovery finished: %d packs", this->discovered_.count);
+
+  this->bind_discovered_();
+  this->start_task_();
+}
+
+// Devices with a discovered address get the packs in ascending order of their addresses, skipping the
+// addresses configured for other devices
+void SeplosModbus::bind_discovered_() {
+  auto is_claimed = [this](uint8_t address) {
+    for (auto *device : this->devices_) {
+      if (!device->discover_address_ && device->address_ == address)
+        return true;
+    }
+    return false;
+  };
+
+  uint8_t next = 0;
+  for (auto *device : this->devices_) {
+    if (device->bound_)
+      continue;
+
+    int8_t found = -1;
+    if (device->discover_address_) {
+      while (next < this->discovered_.count && is_claimed(this->discovered_.addresses[next]))
+        next++;
+      if (next == this->discovered_.count) {
+        ESP_LOGW(TAG, "No pack left to bind. A device stays idle");
+        continue;
+      }
+      found = next++;
+      device->address_ = this->discovered_.addresses[found];
+      if (device->discover_pack_) {
+        device->pack_ = device->address_;
+      }
+    } else {
+      for (uint8_t i = 0; i < this->discovered_.count; i++) {
+        if (this->discovered_.addresses[i] == device->address_)
+          found = i;
+      }
+    }
+
+    if (device->discover_protocol_version_) {
+      if (found >= 0) {
+        device->protocol_version_ = this->discovered_.protocol_versions[found];
+      } else {
+        device->protocol_version_ = this->discovery_protocol_versions_[0];
+        ESP_LOGW(TAG, "Pack 0x%02X not found. Assuming protocol version 0x%02X", device->address_,
+                 device->protocol_version_);
+      }
+    }
+    device->bound_ = true;
+    device->on_seplos_modbus_discovered();
+  }
+}
+
+void SeplosModbus::queue_request(SeplosModbusDevice *device, uint8_t function, uint8_t value, uint8_t info_length,
+                                 bool batch) {
+  uint8_t protocol_version = device->protocol_version_;
+  uint8_t address = device->address_;
+
+  // A single request to the master collects the telemetry of the whole bank
+  if (this->batch_poll_ && batch && function == 0x42) {
+    device = nullptr;
+    address = this->batch_address_;
+    value = 0xFF;
+  }
+
+  SeplosModbusRequest request{};
+  request.device = device;
+  request.address = address;
+  request.protocol_version = protocol_version;
+  request.cid1 = 0x46;
+  request.function = function;
+  request.info[0] = value;
+  request.info_length = std::min<uint8_t>(info_length, 1);
+  request.transport = TRANSPORT_ASCII;
+  this->submit_request_(request);
+}
+
+void SeplosModbus::queue_command(SeplosModbusDevice *device, uint8_t cid1, uint8_t function, const uint8_t *info,
+                                 uint8_t info_length) {
+  if (info_length > MAX_INFO_SIZE) {
+    ESP_LOGE(TAG, "INFO of command 0x%02X too long (%d bytes)", function, info_length);
+    device->on_seplos_modbus_failure(function);
+    return;
+  }
+
+  SeplosModbusRequest request{};
+  request.device = device;
+  request.address = device->address_;
+  request.protocol_version = device->protocol_version_;
+  request.cid1 = cid1;
+  request.function = function;
+  if (info_length > 0) {
+    memcpy(request.info, info, info_length);
+  }
+  request.info_length = info_length;
+  request.transport = TRANSPORT_ASCII;
+  request.priority = true;
+  this->submit_request_(request);
+}
+
+void SeplosModbus::queue_modbus_rtu_request(SeplosModbusDevice *device, uint8_t function, uint16_t register_address,
+                                            uint16_t register_count) {
+  SeplosModbusRequest request{};
+  request.device = device;
+  request.address = device->address_;
+  request.protocol_version = device->protocol_version_;
+  request.function = function;
+  request.transport = TRANSPORT_MODBUS_RTU;
+  request.register_address = register_address;
+  request.register_count = register_count;
+  this->submit_request_(request);
+}
+
+void SeplosModbus::submit_request_(const SeplosModbusRequest &request) {
+  if (request.device != nullptr && !request.device->bound_) {
+    ESP_LOGV(TAG, "Device not bound by the discovery yet. Dropping request 0x%02X", request.function);
+    request.device->on_seplos_modbus_failure(request.function);
+    return;
+  }
+
+#ifdef USE_ESP32
+  if (this->task_handle_ != nullptr) {
+    SeplosModbusRequest *slot = this->request_inbox_.write_slot();
+    if (slot == nullptr) {
+      ESP_LOGW(TAG, "Request inbox full. Dropping request 0x%02X to 0x%02X", request.function, request.address);
+      return;
+    }
+    *slot = request;
+    this->request_inbox_.push();
+    return;
+  }
+#endif
+
+  this->enqueue_request_(request);
+}
+
+void SeplosModbus::enqueue_request_(const SeplosModbusRequest &request) {
+  if (request.priority) {
+    this->enqueue_command_(request);
+    return;
+  }
+
+  SeplosModbusDevice *device = request.device;
+  const uint8_t address = request.address;
+  const uint8_t function = request.function;
+  const uint16_t register_address = request.register_address;
+
+  // Keep at most one request per device and function in flight. A device polling faster than the
+  // bus can serve it doesn't grow the queue and the remaining devices keep their round-robin slot.
+  if (this->waiting_for_response_ && this->pending_.device == device && this->pending_.function == function &&
+      this->pending_.register_address == register_address) {
+    ESP_LOGV(TAG, "Request 0x%02X to 0x%02X still pending. Skipping", function, address);
+    return;
+  }
+
+  for (uint8_t i = 0; i < this->queue_length_; i++) {
+    const SeplosModbusRequest &request = this->queue_[(this->queue_head_ + i) % MAX_QUEUE_SIZE];
+    if (request.device == device && request.function == function && request.register_address == register_address) {
+      ESP_LOGV(TAG, "Request 0x%02X to 0x%02X already queued. Skipping", function, address);
+      return;
+    }
+  }
+
+  if (this->queue_length_ == MAX_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Request queue full. Dropping request 0x%02X to 0x%02X", function, address);
+    return;
+  }
+
+  this->queue_[(this->queue_head_ + this->queue_length_) % MAX_QUEUE_SIZE] = request;
+  this->queue_length_++;
+}
+
+// Commands are never deduplicated. Each of them is acknowledged on its own
+void SeplosModbus::enqueue_command_(const SeplosModbusRequest &request) {
+  if (this->priority_queue_length_ == MAX_PRIORITY_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Command queue full. Dropping command 0x%02X to 0x%02X", request.function, request.address);
+    this->report_failure_(request);
+    return;
+  }
+
+  this->priority_queue_[(this->priority_queue_head_ + this->priority_queue_length_) % MAX_PRIORITY_QUEUE_SIZE] =
+      request;
+  this->priority_queue_length_++;
+}
+
+void SeplosModbus::report_failure_(const SeplosModbusRequest &request) {
+  if (request.device == nullptr)
+    return;
+
+#ifdef USE_ESP32
+  if (this->task_handle_ != nullptr) {
+    SeplosModbusFrame *frame = this->frame_outbox_.write_slot();
+    if (frame == nullptr) {
+      ESP_LOGW(TAG, "Frame queue full. Dropping the failure of request 0x%02X", request.function);
+      return;
+    }
+    frame->failed_device = request.device;
+    frame->function = request.function;
+    frame->length = 0;
+    this->frame_outbox_.push();
+    return;
+  }
+#endif
+
+  request.device->on_seplos_modbus_failure(request.function);
+}
+
+void SeplosModbus::transmit_next_request_(uint32_t now) {
+  if (this->waiting_for_response_ || (this->queue_length_ == 0 && this->priority_queue_length_ == 0))
+    return;
+
+  // Never talk into a frame which is still being received or left to the next loop
+  if (this->rx_length_ > 0 || this->dispatch_pending_ || this->available())
+    return;
+
+  if (now - this->last_bus_activity_ < this->inter_frame_gap_)
+    return;
+
+  if (this->priority_queue_length_ > 0) {
+    this->pending_ = this->priority_queue_[this->priority_queue_head_];
+    this->priority_queue_head_ = (this->priority_queue_head_ + 1) % MAX_PRIORITY_QUEUE_SIZE;
+    this->priority_queue_length_--;
+  } else {
+    this->pending_ = this->queue_[this->queue_head_];
+    this->queue_head_ = (this->queue_head_ + 1) % MAX_QUEUE_SIZE;
+    this->queue_length_--;
+  }
+
+  if (this->pending_.transport == TRANSPORT_MODBUS_RTU) {
+    this->send_modbus_rtu(this->pending_.address, this->pending_.function, this->pending_.register_address,
+                          this->pending_.register_count);
+  } else {
+    this->send(this->pending_.protocol_version, this->pending_.address, this->pending_.cid1, this->pending_.function,
+               this->pending_.info, this->pending_.info_length);
+  }
+
+  this->waiting_for_response_ = true;
+  this->count_(this->requests_sent_);
+  this->last_send_ = millis();
+  this->last_bus_activity_ = this->last_send_;
+}
+
+void SeplosModbus::complete_request_(uint8_t address) {
+  if (!this->waiting_for_response_ || this->pending_.address != address)
+    return;
+
+  const uint32_t now = millis();
+  const uint32_t latency = now - this->last_send_;
+  {
+    LockGuard guard(this->statistics_lock_);
+    if (this->pending_.device != nullptr) {
+      this->pending_.device->poll_statistics_.latency = latency;
+      this->pending_.device->poll_statistics_.latencies.add(latency);
+    } else {
+      for (auto *device : this->devices_) {
+        device->poll_statistics_.latency = latency;
+        device->poll_statistics_.latencies.add(latency);
+      }
+    }
+    this->responses_received_++;
+    this->latencies_.add(latency);
+  }
+  this->waiting_for_response_ = false;
+  this->last_bus_activity_ = now;
+  this->track_free_heap_();
+}
+
+void SeplosModbus::check_response_timeout_(uint32_t now) {
+  if (!this->waiting_for_response_ || now - this->last_send_ < this->response_timeout_)
+    return;
+
+  // The response might be among the bytes left to the next loop or still arriving. A frame stalled for longer
+  // than the RX timeout is cleared by poll_bus_() beforehand, so this waits at most that long
+  if (this->available() || this->rx_length_ > 0)
+    return;
+
+  this->waiting_for_response_ = false;
+
+  if (this->pending_.retries < this->max_retries_) {
+    this->pending_.retries++;
+    ESP_LOGD(TAG, "No response from 0x%02X to request 0x%02X. Retrying (%d/%d)", this->pending_.address,
+             this->pending_.function, this->pending_.retries, this->max_retries_);
+    // The queue might be full of newer requests. Overwriting the newest one in that case is fine
+    // because a retry is more urgent than anything queued behind it.
+    if (this->pending_.priority) {
+      this->priority_queue_head_ = (this->priority_queue_head_ + MAX_PRIORITY_QUEUE_SIZE - 1) % MAX_PRIORITY_QUEUE_SIZE;
+      this->priority_queue_[this->priority_queue_head_] = this->pending_;
+      this->priority_queue_length_ = std::min<uint8_t>(this->priority_queue_length_ + 1, MAX_PRIORITY_QUEUE_SIZE);
+    } else {
+      this->queue_head_ = (this->queue_head_ + MAX_QUEUE_SIZE - 1) % MAX_QUEUE_SIZE;
+      this->queue_[this->queue_head_] = this->pending_;
+      this->queue_length_ = std::min<uint8_t>(this->queue_length_ + 1, MAX_QUEUE_SIZE);
+    }
+    return;
+  }
+
+  ESP_LOGW(TAG, "No response from 0x%02X to request 0x%02X after %d retries", this->pending_.address,
+           this->pending_.function, this->max_retries_);
+  this->fail_request_(this->pending_);
+}
+
+// Counts a failed poll and reports it to the device
+void SeplosModbus::fail_request_(const SeplosModbusRequest &request) {
+  if (request.device != nullptr) {
+    this->count_(request.device->poll_statistics_.timeouts);
+  } else {
+    for (auto *device : this->devices_) {
+      this->count_(device->poll_statistics_.timeouts);
+    }
+  }
+  this->report_failure_(request);
 }
 
 uint16_t chksum(const uint8_t data[], const uint16_t len) {
@@ -59,122 +773,499 @@ uint16_t lchksum(const uint16_t len) {
   return (lchecksum << 12) + len;  // 4 byte checksum + 12 bytes length
 }
 
-uint8_t ascii_hex_to_byte(char a, char b) {
-  a = (a <= '9') ? a - '0' : (a & 0x7) + 9;
-  b = (b <= '9') ? b - '0' : (b & 0x7) + 9;
+uint16_t crc16(const uint8_t *data, uint8_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++) {
+      if ((crc & 0x01) != 0) {
+        crc >>= 1;
+        crc ^= 0xA001;
+      } else {
+        crc >>= 1;
+      }
+    }
+  }
+  return crc;
+}
 
-  return (a << 4) + b;
+static bool ascii_hex_to_nibble(uint8_t c, uint8_t *nibble) {
+  if (c >= '0' && c <= '9') {
+    *nibble = c - '0';
+  } else if (c >= 'A' && c <= 'F') {
+    *nibble = c - 'A' + 10;
+  } else if (c >= 'a' && c <= 'f') {
+    *nibble = c - 'a' + 10;
+  } else {
+    return false;
+  }
+  return true;
 }
 
 static char byte_to_ascii_hex(uint8_t v) { return v >= 10 ? 'A' + (v - 10) : '0' + v; }
-std::string byte_to_ascii_hex(const uint8_t *data, size_t length) {
-  if (length == 0)
-    return "";
-  std::string ret;
-  ret.resize(2 * length);
+size_t byte_to_ascii_hex(const uint8_t *data, size_t length, char *out) {
   for (size_t i = 0; i < length; i++) {
-    ret[2 * i] = byte_to_ascii_hex((data[i] & 0xF0) >> 4);
-    ret[2 * i + 1] = byte_to_ascii_hex(data[i] & 0x0F);
+    out[2 * i] = byte_to_ascii_hex((data[i] & 0xF0) >> 4);
+    out[2 * i + 1] = byte_to_ascii_hex(data[i] & 0x0F);
   }
-  return ret;
+  return 2 * length;
 }
 
+// The frame is decoded while it arrives: every pair of ASCII hex characters is turned into a byte,
+// the checksum is accumulated over the characters of the body and the LENID header field is
+// validated as soon as it's complete. The end of frame just compares two numbers.
 bool SeplosModbus::parse_seplos_modbus_byte_(uint8_t byte) {
-  size_t at = this->rx_buffer_.size();
-  this->rx_buffer_.push_back(byte);
-  const uint8_t *raw = &this->rx_buffer_[0];
-
   // Start of frame
-  if (at == 0) {
-    if (raw[0] != 0x7E) {
-      ESP_LOGW(TAG, "Invalid header: 0x%02X", raw[0]);
+  if (this->rx_length_ == 0) {
+    if (byte != 0x7E) {
+      // Count and log a run of stray bytes once
+      if (!this->skip_until_sof_) {
+        ESP_LOGW(TAG, "Invalid header: 0x%02X", byte);
+        this->count_(this->header_resyncs_);
+        this->skip_until_sof_ = true;
+      }
 
       // return false to reset buffer
       return false;
     }
 
+    this->skip_until_sof_ = false;
+    this->rx_length_ = 1;
+    this->frame_length_ = 0;
+    this->body_length_ = 0;
+    this->rx_checksum_ = 0;
     return true;
   }
 
   // End of frame '\r'
-  if (raw[at] != 0x0D)
+  if (byte == 0x0D)
+    return this->finish_frame_();
+
+  uint8_t nibble;
+  if (!ascii_hex_to_nibble(byte, &nibble)) {
+    ESP_LOGW(TAG, "Invalid character 0x%02X at position %d", byte, this->rx_length_);
+    return false;
+  }
+
+  // The checksum covers the ASCII characters between SOF and CHKSUM
+  if (this->body_length_ == 0 || this->frame_length_ < this->body_length_) {
+    this->rx_checksum_ += byte;
+  }
+
+  // First character of a pair
+  if (this->rx_length_++ % 2 == 1) {
+    this->high_nibble_ = nibble;
     return true;
+  }
 
-  if (at > MAX_RESPONSE_SIZE) {
+  if (this->frame_length_ >= sizeof(this->frame_) ||
+      (this->body_length_ > 0 && this->frame_length_ >= this->body_length_ + 2)) {
     ESP_LOGW(TAG, "Maximum response size exceeded. Flushing RX buffer...");
     return false;
   }
+  this->frame_[this->frame_length_++] = (this->high_nibble_ << 4) | nibble;
+
+  // VER + ADR + CID1 + CID2/RTN + LENGTH (2) received
+  if (this->frame_length_ == 6) {
+    const uint16_t lenid = encode_uint16(this->frame_[4], this->frame_[5]);
+    const uint16_t info_length = lenid & 0x0FFF;
+    if (lchksum(info_length) != lenid || info_length % 2 != 0) {
+      ESP_LOGW(TAG, "Invalid LENID 0x%04X. Flushing RX buffer...", lenid);
+      return false;
+    }
+
+    this->body_length_ = 6 + info_length / 2;
+    if (this->body_length_ + 2 > sizeof(this->frame_)) {
+      ESP_LOGW(TAG, "Maximum response size exceeded (LENID 0x%04X). Flushing RX buffer...", lenid);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool SeplosModbus::finish_frame_() {
+  if (this->body_length_ == 0 || this->frame_length_ != this->body_length_ + 2 || this->rx_length_ % 2 == 0) {
+    ESP_LOGW(TAG, "Incomplete frame (%d of %d bytes). Flushing RX buffer...", this->frame_length_,
+             this->body_length_ + 2);
+    return false;
+  }
+
+  const uint16_t computed_crc = ~this->rx_checksum_ + 1;
+  const uint16_t remote_crc = encode_uint16(this->frame_[this->body_length_], this->frame_[this->body_length_ + 1]);
+  if (computed_crc != remote_crc) {
+    ESP_LOGW(TAG, "CRC check failed! 0x%04X != 0x%04X", computed_crc, remote_crc);
+    this->count_(this->crc_errors_);
+    return false;
+  }
+
+  const uint16_t length = this->body_length_;
+  const uint8_t address = this->frame_[1];
+  // Only the response to the request in flight is decoded. Frames of another master on the bus and responses
+  // arriving after their request timed out are dropped here
+  if (!this->waiting_for_response_ || this->pending_.transport != TRANSPORT_ASCII ||
+      this->pending_.address != address || this->pending_.cid1 != this->frame_[2]) {
+    if (this->unsolicited_frames_) {
+      this->deliver_frame_(0x42, false, TRANSPORT_ASCII, 0x0000, length);
+    } else {
+      ESP_LOGD(TAG, "Dropping stray frame of 0x%02X (CID1 0x%02X)", address, this->frame_[2]);
+      this->count_(this->stray_frames_);
+    }
+    return false;
+  }
+
+  if (this->discovery_state_ != DISCOVERY_IDLE) {
+    this->on_probe_response_(this->frame_[0]);
+    return false;
+  }
 
-  uint16_t data_len = at - 4 - 1;
-  uint16_t computed_crc = chksum(raw + 1, data_len);
-  uint16_t remote_crc = uint16_t(ascii_hex_to_byte(raw[at - 4], raw[at - 3])) << 8 |
-                        (uint16_t(ascii_hex_to_byte(raw[at - 2], raw[at - 1])) << 0);
+  const uint8_t function = this->pending_.function;
+  const bool batch_response = this->pending_.device == nullptr && function == 0x42;
+  this->complete_request_(address);
+  this->deliver_frame_(function, batch_response, TRANSPORT_ASCII, 0x0000, length);
+
+  // return false to reset buffer
+  return false;
+}
+
+// Modbus-RTU frames are delimited by silence on the bus. The response is decoded against the pending request:
+//
+//   0    Address                  uint8_t
+//   1    Function                 uint8_t             Function of the request, with bit 7 set on an exception
+//   2    Byte count N             uint8_t             The exception code of an exception response
+//   3    Data                     N bytes             Registers big endian, coils LSB first
+//        CRC16                    uint16_t            Little endian
+bool SeplosModbus::parse_modbus_rtu_byte_(uint8_t byte) {
+  // The rest of a rejected frame is dropped until the bus falls silent
+  if (this->skip_until_silence_)
+    return true;
+
+  if (this->rx_length_ == 0) {
+    this->frame_length_ = 0;
+    this->body_length_ = 0;
+  }
+  this->rx_length_++;
+  this->frame_[this->frame_length_++] = byte;
+
+  bool valid = true;
+  switch (this->frame_length_) {
+    case 1:
+      valid = byte == this->pending_.address;
+      break;
+    case 2:
+      if (byte == (this->pending_.function | 0x80)) {
+        this->body_length_ = 3;
+      } else {
+        valid = byte == this->pending_.function;
+      }
+      break;
+    case 3:
+      if (this->body_length_ == 0) {
+        const uint16_t expected = (this->pending_.function <= 0x02) ? (this->pending_.register_count + 7) / 8
+                                                                     : this->pending_.register_count * 2;
+        valid = byte == expected && 3 + byte + 2 <= sizeof(this->frame_);
+        this->body_length_ = 3 + byte;
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (!valid) {
+    ESP_LOGW(TAG, "Unexpected Modbus-RTU byte 0x%02X at position %d. Skipping the frame", byte, this->frame_length_);
+    this->count_(this->header_resyncs_);
+    this->skip_until_silence_ = true;
+    this->rx_length_ = 0;
+    return true;
+  }
+
+  if (this->body_length_ > 0 && this->frame_length_ == this->body_length_ + 2)
+    return this->finish_modbus_rtu_frame_();
+
+  return true;
+}
+
+bool SeplosModbus::finish_modbus_rtu_frame_() {
+  // The frame ends here. A reset of the buffer must not be taken for an aborted frame
+  this->rx_length_ = 0;
+
+  const uint16_t computed_crc = crc16(this->frame_, this->body_length_);
+  const uint16_t remote_crc = encode_uint16(this->frame_[this->body_length_ + 1], this->frame_[this->body_length_]);
   if (computed_crc != remote_crc) {
     ESP_LOGW(TAG, "CRC check failed! 0x%04X != 0x%04X", computed_crc, remote_crc);
+    this->count_(this->crc_errors_);
+    return false;
+  }
+
+  const uint8_t address = this->frame_[0];
+  if (!this->waiting_for_response_ || this->pending_.transport != TRANSPORT_MODBUS_RTU) {
+    ESP_LOGD(TAG, "Dropping stray Modbus-RTU frame of 0x%02X", address);
+    this->count_(this->stray_frames_);
     return false;
   }
 
-  std::vector<uint8_t> data;
-  for (uint16_t i = 1; i < data_len; i = i + 2) {
-    data.push_back(ascii_hex_to_byte(raw[i], raw[i + 1]));
+  const SeplosModbusRequest request = this->pending_;
+  const uint8_t function = request.function;
+  const uint16_t register_address = request.register_address;
+  this->complete_request_(address);
+
+  // The pack rejected the request. It failed like a request without a response, just without the wait
+  if (this->frame_[1] & 0x80) {
+    ESP_LOGW(TAG, "Request 0x%02X of 0x%04X rejected by 0x%02X (exception 0x%02X)", function, register_address,
+             address, this->frame_[2]);
+    this->fail_request_(request);
+    return false;
   }
 
-  uint8_t address = data[1];
+  this->deliver_frame_(function, false, TRANSPORT_MODBUS_RTU, register_address, this->body_length_);
+
+  // return false to reset buffer
+  return false;
+}
 
+// Hands the frame in frame_ over to the main loop, to the next loop or dispatches it right away
+void SeplosModbus::deliver_frame_(uint8_t function, bool batch, SeplosTransport transport, uint16_t register_address,
+                                  uint16_t length) {
+#ifdef USE_ESP32
+  if (this->task_handle_ != nullptr) {
+    SeplosModbusFrame *frame = this->frame_outbox_.write_slot();
+    if (frame == nullptr) {
+      ESP_LOGW(TAG, "Frame queue full. Dropping frame of 0x%02X",
+               (transport == TRANSPORT_ASCII) ? this->frame_[1] : this->frame_[0]);
+      return;
+    }
+    frame->failed_device = nullptr;
+    frame->function = function;
+    frame->batch = batch;
+    frame->transport = transport;
+    frame->register_address = register_address;
+    frame->length = length;
+    memcpy(frame->data, this->frame_, length);
+    this->frame_outbox_.push();
+    return;
+  }
+#endif
+
+  if (this->rx_byte_budget_ > 0) {
+    this->dispatch_pending_ = true;
+    this->dispatch_function_ = function;
+    this->dispatch_batch_ = batch;
+    this->dispatch_transport_ = transport;
+    this->dispatch_register_address_ = register_address;
+    this->dispatch_length_ = length;
+    return;
+  }
+
+  this->dispatch_(function, batch, transport, register_address, this->frame_, length);
+}
+
+void SeplosModbus::dispatch_(uint8_t function, bool batch, SeplosTransport transport, uint16_t register_address,
+                             uint8_t *data, uint16_t length) {
+  if (transport == TRANSPORT_MODBUS_RTU) {
+    this->dispatch_registers_(register_address, data, length);
+  } else {
+    this->dispatch_frame_(function, batch, data, length);
+  }
+}
+
+void SeplosModbus::dispatch_frame_(uint8_t function, bool batch, uint8_t *data, uint16_t length) {
+  if (batch) {
+    this->dispatch_batch_response_(data, length);
+    return;
+  }
+
+  const uint8_t address = data[1];
   bool found = false;
   for (auto *device : this->devices_) {
-    if (device->address_ == address) {
-      device->on_seplos_modbus_data(data);
+    if (device->address_ == address && device->transport_ == TRANSPORT_ASCII) {
+      device->on_seplos_modbus_data(function, data, length);
       found = true;
     }
   }
 
   if (!found) {
     ESP_LOGW(TAG, "Got SeplosModbus frame from unknown address 0x%02X! ", address);
+    this->count_(this->unknown_address_frames_);
   }
+}
 
-  // return false to reset buffer
-  return false;
+// Multi-pack telemetry response of the master (CID2 0x42, COMMAND 0xFF)
+//
+//   0    VER, ADR, CID1, RTN, LENGTH (2)
+//   6    DATAFLAG
+//   7    Number of packs M
+//   8    M records: cells (1), cell voltages (2 * cells), temperature sensors (1), temperatures (2 * sensors),
+//        current (2), total voltage (2), residual capacity (2), custom number P (1), P user defined values (2 * P)
+//
+// A single pack response of protocol version 0x20 is the M = 1 case of the same layout. Other versions place
+// their fields at fixed offsets, so their batch responses are rejected. Each record is turned into such a single pack
+// frame in place by writing the 8 header bytes right in front of the record. The preceding record was
+// dispatched already, so its tail can be overwritten.
+void SeplosModbus::dispatch_batch_response_(uint8_t *data, uint16_t length) {
+  if (length < 8 || data[3] != 0x00) {
+    ESP_LOGW(TAG, "Invalid batch response (RTN 0x%02X, %d bytes)", data[3], length);
+    return;
+  }
+  if (data[0] != BATCH_PROTOCOL_VERSION) {
+    ESP_LOGW(TAG, "Batch response of protocol version 0x%02X not supported", data[0]);
+    return;
+  }
+
+  uint8_t header[8];
+  memcpy(header, data, sizeof(header));
+  header[7] = 1;
+
+  const uint8_t packs = data[7];
+  uint16_t start = 8;
+  for (uint8_t pack = 0; pack < packs; pack++) {
+    uint16_t end = start;
+    if (end >= length)
+      break;
+    end += 1 + data[end] * 2;  // Cell voltages
+    if (end >= length)
+      break;
+    end += 1 + data[end] * 2 + 6;  // Temperatures, current, total voltage, residual capacity
+    if (end >= length)
+      break;
+    end += 1 + data[end] * 2;  // User defined values
+    if (end > length) {
+      ESP_LOGW(TAG, "Batch response truncated at pack %d", pack);
+      break;
+    }
+
+    const uint8_t pack_index = this->batch_address_ + pack;
+    memcpy(data + start - sizeof(header), header, sizeof(header));
+    for (auto *device : this->devices_) {
+      if (device->pack_ == pack_index && device->transport_ == TRANSPORT_ASCII) {
+        data[start - sizeof(header) + 1] = device->address_;
+        device->on_seplos_modbus_data(0x42, data + start - sizeof(header), end - start + sizeof(header));
+      }
+    }
+    start = end;
+  }
+}
+
+void SeplosModbus::dispatch_registers_(uint16_t register_address, const uint8_t *data, uint16_t length) {
+  const uint8_t address = data[0];
+  bool found = false;
+  for (auto *device : this->devices_) {
+    if (device->address_ == address && device->transport_ == TRANSPORT_MODBUS_RTU) {
+      device->on_seplos_modbus_registers(data[1], register_address, data + 3, length - 3);
+      found = true;
+    }
+  }
+
+  if (!found) {
+    ESP_LOGW(TAG, "Got Modbus-RTU frame from unknown address 0x%02X! ", address);
+    this->count_(this->unknown_address_frames_);
+  }
 }
 
 void SeplosModbus::dump_config() {
   ESP_LOGCONFIG(TAG, "SeplosModbus:");
   LOG_PIN("  Flow Control Pin: ", this->flow_control_pin_);
   ESP_LOGCONFIG(TAG, "  RX timeout: %d ms", this->rx_timeout_);
+  ESP_LOGCONFIG(TAG, "  Response timeout: %d ms", this->response_timeout_);
+  ESP_LOGCONFIG(TAG, "  Inter-frame gap: %d ms", this->inter_frame_gap_);
+  ESP_LOGCONFIG(TAG, "  Max retries: %d", this->max_retries_);
+  ESP_LOGCONFIG(TAG, "  Batch poll: %s", YESNO(this->batch_poll_));
+  if (this->batch_poll_) {
+    ESP_LOGCONFIG(TAG, "  Batch address: 0x%02X", this->batch_address_);
+  }
+  ESP_LOGCONFIG(TAG, "  Unsolicited frames: %s", YESNO(this->unsolicited_frames_));
+  for (auto *device : this->devices_) {
+    if (device->discover_address_ || device->discover_protocol_version_) {
+      ESP_LOGCONFIG(TAG, "  Discovery: addresses up to 0x%02X, timeout %d ms", this->discovery_max_address_,
+                    this->discovery_timeout_);
+      break;
+    }
+  }
+  ESP_LOGCONFIG(TAG, "  Dedicated task: %s", YESNO(this->dedicated_task_));
+  if (this->rx_byte_budget_ > 0 || this->publish_budget_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Loop budget: %d bytes, %d publishes", this->rx_byte_budget_, this->publish_budget_);
+  }
+  if (this->capture_buffer_size_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Capture buffer: %u bytes%s", (unsigned) this->capture_buffer_size_,
+                  (this->capture_ == nullptr) ? " (allocation failed)" : "");
+  }
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("", "Minimum Free Heap", this->min_free_heap_sensor_);
+  LOG_SENSOR("", "Requests Sent", this->requests_sent_sensor_);
+  LOG_SENSOR("", "Responses Received", this->responses_received_sensor_);
+  LOG_SENSOR("", "CRC Errors", this->crc_errors_sensor_);
+  LOG_SENSOR("", "Header Resyncs", this->header_resyncs_sensor_);
+  LOG_SENSOR("", "RX Timeouts", this->rx_timeouts_sensor_);
+  LOG_SENSOR("", "Unknown Address Frames", this->unknown_address_frames_sensor_);
+  LOG_SENSOR("", "Stray Frames", this->stray_frames_sensor_);
+  LOG_SENSOR("", "Minimum Latency", this->min_latency_sensor_);
+  LOG_SENSOR("", "Average Latency", this->average_latency_sensor_);
+  LOG_SENSOR("", "P95 Latency", this->p95_latency_sensor_);
+  LOG_SENSOR("", "Throughput", this->throughput_sensor_);
 }
 float SeplosModbus::get_setup_priority() const {
   // After UART bus
   return setup_priority::BUS - 1.0f;
 }
 
-void SeplosModbus::send(uint8_t protocol_version, uint8_t address, uint8_t function, uint8_t value) {
-  if (this->flow_control_pin_ != nullptr)
-    this->flow_control_pin_->digital_write(true);
+void SeplosModbus::send(uint8_t protocol_version, uint8_t address, uint8_t cid1, uint8_t function,
+                        const uint8_t *info, uint8_t info_length) {
+  info_length = std::min(info_length, MAX_INFO_SIZE);
+  const uint16_t lenid = lchksum(info_length * 2);
+  const uint8_t header[] = {
+      protocol_version,     // VER
+      address,              // ADDR
+      cid1,                 // CID1 (0x46)
+      function,             // CID2 (0x42)
+      uint8_t(lenid >> 8),  // LCHKSUM (0xE0)
+      uint8_t(lenid >> 0),  // LENGTH (0x02)
+  };
 
-  const uint16_t lenid = lchksum(1 * 2);
-  std::vector<uint8_t> data;
-  data.push_back(protocol_version);  // VER
-  data.push_back(address);           // ADDR
-  data.push_back(0x46);              // CID1
-  data.push_back(function);          // CID2 (0x42)
-  data.push_back(lenid >> 8);        // LCHKSUM (0xE0)
-  data.push_back(lenid >> 0);        // LENGTH (0x02)
-  data.push_back(value);             // VALUE (0x00)
+  char *payload = this->tx_buffer_;
+  size_t at = 0;
+  payload[at++] = '~';  // SOF (0x7E)
+  at += byte_to_ascii_hex(header, sizeof(header), payload + at);
+  at += byte_to_ascii_hex(info, info_length, payload + at);  // INFO (0x00)
 
-  const uint16_t frame_len = data.size();
-  std::string payload = "~";  // SOF (0x7E)
-  payload.append(byte_to_ascii_hex(data.data(), frame_len));
+  const uint16_t crc = chksum((const uint8_t *) payload + 1, at - 1);
+  const uint8_t checksum[] = {uint8_t(crc >> 8), uint8_t(crc >> 0)};  // CHKSUM (0xFD37)
+  at += byte_to_ascii_hex(checksum, sizeof(checksum), payload + at);
+  payload[at++] = '\r';  // EOF (0x0D)
+  payload[at] = '\0';
 
-  uint16_t crc = chksum((const uint8_t *) payload.data() + 1, payload.size() - 1);
-  data.push_back(crc >> 8);  // CHKSUM (0xFD)
-  data.push_back(crc >> 0);  // CHKSUM (0x37)
+  ESP_LOGD(TAG, "Send frame: %s", payload);
+  this->write_frame_((const uint8_t *) payload, at);
+}
 
-  payload.append(byte_to_ascii_hex(data.data() + frame_len, data.size() - frame_len));  // Append checksum
-  payload.append("\r");                                                                 // EOF (0x0D)
+void SeplosModbus::send_modbus_rtu(uint8_t address, uint8_t function, uint16_t register_address,
+                                   uint16_t register_count) {
+  auto *frame = (uint8_t *) this->tx_buffer_;
+  frame[0] = address;
+  frame[1] = function;
+  frame[2] = register_address >> 8;
+  frame[3] = register_address >> 0;
+  frame[4] = register_count >> 8;
+  frame[5] = register_count >> 0;
+  const uint16_t crc = crc16(frame, 6);
+  frame[6] = crc >> 0;
+  frame[7] = crc >> 8;
+
+  ESP_LOGD(TAG, "Send Modbus-RTU request 0x%02X of %d at 0x%04X to 0x%02X", function, register_count,
+           register_address, address);
+  this->write_frame_(frame, 8);
+}
 
-  ESP_LOGD(TAG, "Send frame: %s", payload.c_str());
+void SeplosModbus::write_frame_(const uint8_t *frame, size_t length) {
+  if (this->flow_control_pin_ != nullptr)
+    this->flow_control_pin_->digital_write(true);
+
+  if (this->capture_ != nullptr) {
+    this->capture_->begin_record(millis(), CAPTURE_TX);
+    this->capture_->append(frame, length);
+    this->capture_->end_record();
+  }
 
-  this->write_str(payload.c_str());
+  this->write_array(frame, length);
+  this->count_(this->bus_bytes_, length);
   this->flush();
 
   if (this->flow_control_pin_ != nullptr)
@@ -1,14 +1,140 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/sensor/sensor.h"
 #include "esphome/components/uart/uart.h"
+#include "capture.h"
+
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 namespace esphome {
 namespace seplos_modbus {
 
+// In ASCII characters. The longest response is the system parameters (CID2 0x47): 6 + 169 bytes and the checksum
+static const uint16_t MAX_RESPONSE_SIZE = 360;
+static const uint8_t MAX_INFO_SIZE = 16;
+// SOF + (VER ADR CID1 CID2 LENGTH INFO) as ASCII hex + CHKSUM + EOF + NUL
+static const uint8_t MAX_REQUEST_SIZE = 1 + (6 + MAX_INFO_SIZE) * 2 + 4 + 1 + 1;
+static const uint8_t MAX_QUEUE_SIZE = 32;
+static const uint8_t MAX_PRIORITY_QUEUE_SIZE = 8;
+static const uint8_t MAX_FRAME_QUEUE_SIZE = 4;
+static const uint8_t LATENCY_BUCKETS = 64;
+static const uint8_t LATENCY_BUCKET_WIDTH = 16;  // ms
+static const uint16_t LATENCY_WINDOW = 1024;
+static const uint8_t MAX_DISCOVERED_PACKS = 16;
+
 class SeplosModbusDevice;
 
-class SeplosModbus : public uart::UARTDevice, public Component {
+enum SeplosTransport : uint8_t {
+  TRANSPORT_ASCII = 0,   // Seplos V2: ~VER ADR CID1 CID2 LENID INFO CHKSUM\r as ASCII hex
+  TRANSPORT_MODBUS_RTU,  // Seplos V3: Binary Modbus-RTU frames protected by a CRC16
+};
+
+struct SeplosModbusRequest {
+  SeplosModbusDevice *device;  // nullptr for requests on behalf of all devices
+  uint8_t address;
+  uint8_t protocol_version;
+  uint8_t cid1;
+  uint8_t function;  // CID2 or Modbus function code
+  uint8_t info[MAX_INFO_SIZE];
+  uint8_t info_length;
+  SeplosTransport transport;
+  uint16_t register_address;  // Modbus-RTU: First register or coil and number of them
+  uint16_t register_count;
+  uint8_t retries;
+  bool priority;  // Commands skip the queue of the polls
+};
+
+// Packs found by the discovery. Kept in flash, so later boots only verify them instead of sweeping the bus
+struct SeplosDiscoveryCache {
+  uint8_t count;
+  uint8_t addresses[MAX_DISCOVERED_PACKS];
+  uint8_t protocol_versions[MAX_DISCOVERED_PACKS];
+};
+
+struct SeplosModbusFrame {
+  SeplosModbusDevice *failed_device;  // A frame without data reports the failed request of this device
+  uint8_t function;
+  bool batch;
+  SeplosTransport transport;
+  uint16_t register_address;
+  uint16_t length;
+  uint8_t data[MAX_RESPONSE_SIZE / 2];
+};
+
+// Lock-free ring buffer for exactly one producer and one consumer task. The producer fills the slot returned
+// by write_slot() and publishes it with push(), the consumer releases the slot returned by front() with pop().
+// One slot is kept free to tell a full ring from an empty one.
+template<typename T, uint8_t N> class SpscQueue {
+ public:
+  T *write_slot() {
+    const uint8_t head = this->head_.load(std::memory_order_relaxed);
+    if ((head + 1) % N == this->tail_.load(std::memory_order_acquire))
+      return nullptr;
+    return &this->items_[head];
+  }
+  void push() { this->head_.store((this->head_.load(std::memory_order_relaxed) + 1) % N, std::memory_order_release); }
+  T *front() {
+    const uint8_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire))
+      return nullptr;
+    return &this->items_[tail];
+  }
+  void pop() { this->tail_.store((this->tail_.load(std::memory_order_relaxed) + 1) % N, std::memory_order_release); }
+
+ protected:
+  T items_[N];
+  std::atomic<uint8_t> head_{0};
+  std::atomic<uint8_t> tail_{0};
+};
+
+// Request to response latencies in buckets of LATENCY_BUCKET_WIDTH ms, the last bucket collects everything
+// above. Once LATENCY_WINDOW samples are collected all counts are halved, so the statistics follow the bus
+// without storing the samples. The minimum covers the samples since the previous decay.
+class LatencyHistogram {
+ public:
+  void add(uint32_t latency) {
+    this->buckets_[std::min<uint32_t>(latency / LATENCY_BUCKET_WIDTH, LATENCY_BUCKETS - 1)]++;
+    this->count_++;
+    this->sum_ += latency;
+    this->min_ = std::min(this->min_, latency);
+    this->window_min_ = std::min(this->window_min_, latency);
+    if (this->count_ >= LATENCY_WINDOW)
+      this->decay_();
+  }
+  uint32_t count() const { return this->count_; }
+  uint32_t min() const { return this->min_; }
+  float average() const { return (float) this->sum_ / this->count_; }
+  // Upper bound of the bucket holding the percentile
+  uint32_t percentile(float fraction) const;
+
+ protected:
+  uint16_t buckets_[LATENCY_BUCKETS]{};
+  uint32_t count_{0};
+  uint32_t sum_{0};
+  uint32_t min_{UINT32_MAX};
+  uint32_t window_min_{UINT32_MAX};
+
+  void decay_();
+};
+
+// Poll statistics of a device, maintained by the bus scheduler
+struct PollStatistics {
+  uint32_t latency{0};
+  uint32_t timeouts{0};  // Requests failed after all retries or rejected by the device
+  LatencyHistogram latencies;
+};
+
+class SeplosModbus : public uart::UARTDevice, public PollingComponent {
  public:
   SeplosModbus() = default;
 
@@ -16,25 +142,239 @@ class SeplosModbus : public uart::UARTDevice, public Component {
 
   void loop() override;
 
+  void update() override;
+
   void dump_config() override;
 
   void register_device(SeplosModbusDevice *device) { this->devices_.push_back(device); }
 
   float get_setup_priority() const override;
 
-  void send(uint8_t protocol_version, uint8_t address, uint8_t function, uint8_t value);
+  // Encodes and writes a frame with an INFO of up to MAX_INFO_SIZE bytes
+  void send(uint8_t protocol_version, uint8_t address, uint8_t cid1, uint8_t function, const uint8_t *info,
+            uint8_t info_length);
+  void queue_request(SeplosModbusDevice *device, uint8_t function, uint8_t value, uint8_t info_length = 1,
+                     bool batch = true);
+  // Queued ahead of all polls. The device learns about the outcome by the response (RTN) or
+  // on_seplos_modbus_failure()
+  void queue_command(SeplosModbusDevice *device, uint8_t cid1, uint8_t function, const uint8_t *info,
+                     uint8_t info_length);
+  void send_modbus_rtu(uint8_t address, uint8_t function, uint16_t register_address, uint16_t register_count);
+  // Publishes the state right away or, with a publish budget, by one of the next loops
+  void publish_sensor_state(sensor::Sensor *sensor, float value);
+  // The state last handed over to publish_sensor_state(), still deferred or published. False if there is none
+  bool get_sensor_state(sensor::Sensor *sensor, float *state) const;
+  // Copy of the poll statistics of the device, consistent also while the bus task updates them
+  PollStatistics get_poll_statistics(const SeplosModbusDevice *device);
+  void queue_modbus_rtu_request(SeplosModbusDevice *device, uint8_t function, uint16_t register_address,
+                                uint16_t register_count);
   void set_rx_timeout(uint16_t rx_timeout) { rx_timeout_ = rx_timeout; }
+  void set_response_timeout(uint16_t response_timeout) { response_timeout_ = response_timeout; }
+  void set_inter_frame_gap(uint16_t inter_frame_gap) { inter_frame_gap_ = inter_frame_gap; }
+  void set_max_retries(uint8_t max_retries) { max_retries_ = max_retries; }
+  void set_batch_poll(bool batch_poll) { batch_poll_ = batch_poll; }
+  void set_unsolicited_frames(bool unsolicited_frames) { unsolicited_frames_ = unsolicited_frames; }
+  void set_batch_address(uint8_t batch_address) { batch_address_ = batch_address; }
+  void set_dedicated_task(bool dedicated_task) { dedicated_task_ = dedicated_task; }
+  void set_rx_byte_budget(uint16_t rx_byte_budget) { rx_byte_budget_ = rx_byte_budget; }
+  void set_publish_budget(uint8_t publish_budget) { publish_budget_ = publish_budget; }
+  void set_discovery_key(const std::string &discovery_key) { discovery_key_ = discovery_key; }
+  void set_discovery_max_address(uint8_t discovery_max_address) { discovery_max_address_ = discovery_max_address; }
+  void set_discovery_timeout(uint16_t discovery_timeout) { discovery_timeout_ = discovery_timeout; }
+  void add_discovery_protocol_version(uint8_t protocol_version) {
+    discovery_protocol_versions_.push_back(protocol_version);
+  }
   void set_flow_control_pin(GPIOPin *flow_control_pin) { this->flow_control_pin_ = flow_control_pin; }
+  void set_min_free_heap_sensor(sensor::Sensor *min_free_heap_sensor) { min_free_heap_sensor_ = min_free_heap_sensor; }
+  void set_requests_sent_sensor(sensor::Sensor *requests_sent_sensor) { requests_sent_sensor_ = requests_sent_sensor; }
+  void set_responses_received_sensor(sensor::Sensor *responses_received_sensor) {
+    responses_received_sensor_ = responses_received_sensor;
+  }
+  void set_crc_errors_sensor(sensor::Sensor *crc_errors_sensor) { crc_errors_sensor_ = crc_errors_sensor; }
+  void set_header_resyncs_sensor(sensor::Sensor *header_resyncs_sensor) {
+    header_resyncs_sensor_ = header_resyncs_sensor;
+  }
+  void set_rx_timeouts_sensor(sensor::Sensor *rx_timeouts_sensor) { rx_timeouts_sensor_ = rx_timeouts_sensor; }
+  void set_unknown_address_frames_sensor(sensor::Sensor *unknown_address_frames_sensor) {
+    unknown_address_frames_sensor_ = unknown_address_frames_sensor;
+  }
+  void set_stray_frames_sensor(sensor::Sensor *stray_frames_sensor) { stray_frames_sensor_ = stray_frames_sensor; }
+  void set_min_latency_sensor(sensor::Sensor *min_latency_sensor) { min_latency_sensor_ = min_latency_sensor; }
+  void set_average_latency_sensor(sensor::Sensor *average_latency_sensor) {
+    average_latency_sensor_ = average_latency_sensor;
+  }
+  void set_p95_latency_sensor(sensor::Sensor *p95_latency_sensor) { p95_latency_sensor_ = p95_latency_sensor; }
+  void set_throughput_sensor(sensor::Sensor *throughput_sensor) { throughput_sensor_ = throughput_sensor; }
+  void set_capture_buffer_size(size_t capture_buffer_size) { capture_buffer_size_ = capture_buffer_size; }
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+  void set_capture_web_server(web_server_base::WebServerBase *web_server_base, const char *url) {
+    web_server_base_ = web_server_base;
+    capture_url_ = url;
+  }
+#endif
 
  protected:
   uint16_t rx_timeout_{150};
+  uint16_t response_timeout_{500};
+  uint16_t inter_frame_gap_{50};
+  uint8_t max_retries_{2};
+  bool batch_poll_{false};
+  // Decode frames answering no request as telemetry instead of dropping them
+  bool unsolicited_frames_{false};
+  uint8_t batch_address_{0x00};
+  bool dedicated_task_{false};
+  uint16_t rx_byte_budget_{0};
+  uint8_t publish_budget_{0};
   GPIOPin *flow_control_pin_{nullptr};
 
+  sensor::Sensor *min_free_heap_sensor_{nullptr};
+  sensor::Sensor *requests_sent_sensor_{nullptr};
+  sensor::Sensor *responses_received_sensor_{nullptr};
+  sensor::Sensor *crc_errors_sensor_{nullptr};
+  sensor::Sensor *header_resyncs_sensor_{nullptr};
+  sensor::Sensor *rx_timeouts_sensor_{nullptr};
+  sensor::Sensor *unknown_address_frames_sensor_{nullptr};
+  sensor::Sensor *stray_frames_sensor_{nullptr};
+  sensor::Sensor *min_latency_sensor_{nullptr};
+  sensor::Sensor *average_latency_sensor_{nullptr};
+  sensor::Sensor *p95_latency_sensor_{nullptr};
+  sensor::Sensor *throughput_sensor_{nullptr};
+  uint32_t min_free_heap_{UINT32_MAX};
+
+  // Bus statistics and the poll statistics of the devices. With a dedicated task the task updates them while
+  // the main loop publishes them, so both sides access them under the statistics lock only
+  Mutex statistics_lock_;
+  uint32_t requests_sent_{0};
+  uint32_t responses_received_{0};
+  uint32_t crc_errors_{0};
+  uint32_t header_resyncs_{0};
+  uint32_t rx_timeouts_{0};
+  uint32_t unknown_address_frames_{0};
+  // Frames not answering the request in flight
+  uint32_t stray_frames_{0};
+  uint32_t bus_bytes_{0};
+  uint32_t last_bus_bytes_{0};
+  uint32_t last_update_{0};
+  LatencyHistogram latencies_;
+
+  size_t capture_buffer_size_{0};
+  SeplosModbusCapture *capture_{nullptr};
+#ifdef USE_SEPLOS_MODBUS_CAPTURE
+  web_server_base::WebServerBase *web_server_base_{nullptr};
+  const char *capture_url_{nullptr};
+#endif
+
+  void start_task_();
+  void count_(uint32_t &counter, uint32_t amount = 1) {
+    LockGuard guard(this->statistics_lock_);
+    counter += amount;
+  }
+  void poll_bus_(uint32_t now);
+  void submit_request_(const SeplosModbusRequest &request);
+  void enqueue_request_(const SeplosModbusRequest &request);
+  void enqueue_command_(const SeplosModbusRequest &request);
+  void report_failure_(const SeplosModbusRequest &request);
+  void fail_request_(const SeplosModbusRequest &request);
   bool parse_seplos_modbus_byte_(uint8_t byte);
-  std::vector<uint8_t> rx_buffer_;
+  bool finish_frame_();
+  bool parse_modbus_rtu_byte_(uint8_t byte);
+  bool finish_modbus_rtu_frame_();
+  void deliver_frame_(uint8_t function, bool batch, SeplosTransport transport, uint16_t register_address,
+                      uint16_t length);
+  void dispatch_(uint8_t function, bool batch, SeplosTransport transport, uint16_t register_address, uint8_t *data,
+                 uint16_t length);
+  void dispatch_frame_(uint8_t function, bool batch, uint8_t *data, uint16_t length);
+  void dispatch_batch_response_(uint8_t *data, uint16_t length);
+  void dispatch_registers_(uint16_t register_address, const uint8_t *data, uint16_t length);
+  void write_frame_(const uint8_t *frame, size_t length);
+  void transmit_next_request_(uint32_t now);
+  void complete_request_(uint8_t address);
+  void check_response_timeout_(uint32_t now);
+  void publish_deferred_states_();
+  void track_free_heap_();
+  void publish_state_(sensor::Sensor *sensor, float value);
+
+  // Until all devices are bound to an address and protocol version the bus probes for packs with CID2 0x4F
+  // (protocol version) instead of serving the queue. The cached packs of the last sweep are verified first.
+  // A sweep takes place only if one of them doesn't respond. The bus task is started once the discovery finished.
+  enum DiscoveryState : uint8_t {
+    DISCOVERY_IDLE = 0,
+    DISCOVERY_VERIFY,
+    DISCOVERY_SWEEP,
+  };
+  DiscoveryState discovery_state_{DISCOVERY_IDLE};
+  std::string discovery_key_;
+  uint8_t discovery_max_address_{0x0F};
+  uint16_t discovery_timeout_{100};
+  std::vector<uint8_t> discovery_protocol_versions_;
+  uint8_t probe_index_{0};  // Address of the sweep or entry of the cache to verify
+  uint8_t probe_version_{0};
+  SeplosDiscoveryCache discovered_{};
+  ESPPreferenceObject discovery_preference_;
+
+  void start_discovery_();
+  void poll_discovery_(uint32_t now);
+  void on_probe_response_(uint8_t protocol_version);
+  void next_probe_(bool found);
+  void finish_discovery_();
+  void bind_discovered_();
+
+  // Preallocated frame buffers. Nothing on the RX/TX path touches the heap.
+  uint16_t rx_length_{0};
+  uint8_t frame_[MAX_RESPONSE_SIZE / 2];
+  uint16_t frame_length_{0};
+  uint16_t body_length_{0};
+  uint16_t rx_checksum_{0};
+  uint8_t high_nibble_{0};
+  bool skip_until_sof_{false};
+  bool skip_until_silence_{false};
+  char tx_buffer_[MAX_REQUEST_SIZE];
   uint32_t last_seplos_modbus_byte_{0};
   uint32_t last_send_{0};
+  uint32_t last_bus_activity_{0};
   std::vector<SeplosModbusDevice *> devices_;
+
+  SeplosModbusRequest queue_[MAX_QUEUE_SIZE];
+  uint8_t queue_head_{0};
+  uint8_t queue_length_{0};
+  // Priority lane of the commands. A command waits for the request in flight only
+  SeplosModbusRequest priority_queue_[MAX_PRIORITY_QUEUE_SIZE];
+  uint8_t priority_queue_head_{0};
+  uint8_t priority_queue_length_{0};
+  SeplosModbusRequest pending_{};
+  bool waiting_for_response_{false};
+
+  // With a byte budget a finished frame stays in frame_ and is dispatched by the next loop. The RX path
+  // pauses until then.
+  bool dispatch_pending_{false};
+  uint8_t dispatch_function_{0};
+  bool dispatch_batch_{false};
+  SeplosTransport dispatch_transport_{TRANSPORT_ASCII};
+  uint16_t dispatch_register_address_{0};
+  uint16_t dispatch_length_{0};
+
+  // Sensor states waiting for the publish budget of the next loops. Every sensor of the node has a slot and is
+  // queued at most once, a newer state of a waiting sensor replaces the older one. So the queue of slot
+  // indices never holds more than one entry per sensor
+  struct DeferredState {
+    sensor::Sensor *sensor;
+    float value;
+    bool pending;
+  };
+  std::unordered_map<sensor::Sensor *, uint16_t> deferred_slots_;
+  std::vector<DeferredState> deferred_states_;
+  std::vector<uint16_t> deferred_queue_;
+  size_t deferred_head_{0};
+  size_t deferred_count_{0};
+
+#ifdef USE_ESP32
+  // With a dedicated task the task owns the bus and everything above. Requests are handed over to the
+  // task and decoded frames back to the main loop, which publishes the sensor states.
+  static void bus_task_(void *params);
+  TaskHandle_t task_handle_{nullptr};
+  SpscQueue<SeplosModbusRequest, MAX_QUEUE_SIZE> request_inbox_;
+  SpscQueue<SeplosModbusFrame, MAX_FRAME_QUEUE_SIZE> frame_outbox_;
+#endif
 };
 
 uint16_t crc16(const uint8_t *data, uint8_t len);
@@ -45,18 +385,58 @@ class SeplosModbusDevice {
   void set_address(uint8_t address) { address_ = address; }
   void set_pack(uint8_t pack) { pack_ = pack; }
   void set_protocol_version(uint8_t protocol_version) { protocol_version_ = protocol_version; }
-  virtual void on_seplos_modbus_data(const std::vector<uint8_t> &data) = 0;
-  void send(uint8_t function, uint8_t value) {
-    this->parent_->send(this->protocol_version_, this->address_, function, value);
+  void set_transport(SeplosTransport transport) { transport_ = transport; }
+  // Learn the address or protocol version from the discovery of the bus. The pack follows a discovered
+  // address unless it's overridden
+  void set_discover_address(bool discover_address) {
+    discover_address_ = discover_address;
+    bound_ = !discover_address_ && !discover_protocol_version_;
+  }
+  void set_discover_pack(bool discover_pack) { discover_pack_ = discover_pack; }
+  void set_discover_protocol_version(bool discover_protocol_version) {
+    discover_protocol_version_ = discover_protocol_version;
+    bound_ = !discover_address_ && !discover_protocol_version_;
+  }
+  // No requests of the device are sent before the discovery bound its address and protocol version
+  bool is_bound() const { return this->bound_; }
+  // The discovery assigned the address, pack or protocol version
+  virtual void on_seplos_modbus_discovered() {}
+  // The function (CID2) of the request answered by this frame. Frames answering no request are dropped
+  // by the bus, unless it accepts unsolicited frames. These are reported as telemetry (0x42).
+  virtual void on_seplos_modbus_data(uint8_t function, const uint8_t *data, uint16_t length) = 0;
+  // The values of the registers or coils read by read_registers(), without the Modbus-RTU header and CRC
+  virtual void on_seplos_modbus_registers(uint8_t function, uint16_t register_address, const uint8_t *data,
+                                          uint16_t length) {}
+  // A request of this device got no response after all retries, was rejected or was dropped
+  virtual void on_seplos_modbus_failure(uint8_t function) {}
+  void send(uint8_t function, uint8_t value) { this->parent_->queue_request(this, function, value); }
+  // Request without INFO
+  void send(uint8_t function) { this->parent_->queue_request(this, function, 0x00, 0); }
+  // Addressed to this device even if the bus polls the telemetry of all devices in a single request
+  void send_direct(uint8_t function, uint8_t value) { this->parent_->queue_request(this, function, value, 1, false); }
+  void send_command(uint8_t cid1, uint8_t function, const uint8_t *info, uint8_t info_length) {
+    this->parent_->queue_command(this, cid1, function, info, info_length);
+  }
+  // Modbus-RTU read (function 0x01..0x04) of a block of coils or registers
+  void read_registers(uint8_t function, uint16_t register_address, uint16_t register_count) {
+    this->parent_->queue_modbus_rtu_request(this, function, register_address, register_count);
   }
 
  protected:
   friend SeplosModbus;
 
   SeplosModbus *parent_;
-  uint8_t address_;
-  uint8_t pack_;
-  uint8_t protocol_version_;
+  uint8_t address_{0};
+  uint8_t pack_{0};
+  uint8_t protocol_version_{0};
+  SeplosTransport transport_{TRANSPORT_ASCII};
+  bool discover_address_{false};
+  bool discover_pack_{false};
+  bool discover_protocol_version_{false};
+  bool bound_{true};
+
+  // Maintained by the parent bus scheduler, read through SeplosModbus::get_poll_statistics()
+  PollStatistics poll_statistics_;
 };
 
 }  // namespace seplos_modbus
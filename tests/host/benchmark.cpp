@@ -0,0 +1,164 @@
+// Replays the responses of tests/esp8266-fake-bms.yaml and reports the cost of
+//
+//   - the RX path: the bytes from the UART through parse_seplos_modbus_byte_() up to the dispatch of the frame
+//   - the decoding by the BMS: on_seplos_modbus_data() of the telemetry frames, which is on_telemetry_data_(),
+//     and of all frames
+//
+// Exits with an error if a frame isn't received or decoded, or if the RX path touches the heap.
+#include "esphome/components/seplos_modbus/seplos_modbus.h"
+#include "esphome/components/uart/uart.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "bms_fixture.h"
+#include "host.h"
+
+using namespace esphome;
+
+static uint64_t allocations = 0;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void *operator new(size_t size) {
+  allocations++;
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t size) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t size) noexcept { free(ptr); }
+
+namespace {
+
+// Takes the frames of all packs, so the RX path is measured without the decoding
+class FrameCounter : public seplos_modbus::SeplosModbusDevice {
+ public:
+  void on_seplos_modbus_data(uint8_t function, const uint8_t *data, uint16_t length) override { this->frames++; }
+
+  uint32_t frames{0};
+};
+
+struct Measurement {
+  double seconds;
+  uint64_t allocations;
+};
+
+template<typename F> Measurement measure(F &&f) {
+  const uint64_t allocations_before = allocations;
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return Measurement{elapsed.count(), allocations - allocations_before};
+}
+
+void report(const char *name, const Measurement &measurement, uint64_t frames, uint64_t bytes) {
+  printf("%-18s %12.0f frames/s %9.2f ns/byte %8.3f allocations/frame\n", name, frames / measurement.seconds,
+         measurement.seconds * 1e9 / bytes, (double) measurement.allocations / frames);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 1000;
+  const char *path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = strtoul(argv[++i], nullptr, 10);
+    } else {
+      path = argv[i];
+    }
+  }
+  if (path == nullptr || iterations == 0) {
+    fprintf(stderr, "Usage: %s [--iterations N] tests/esp8266-fake-bms.yaml\n", argv[0]);
+    return 2;
+  }
+
+  const std::vector<host::FakeBmsFrame> frames = host::read_fake_bms_frames(path);
+  if (frames.empty()) {
+    fprintf(stderr, "No frames found in %s\n", path);
+    return 1;
+  }
+
+  std::string stream;
+  std::vector<std::vector<uint8_t>> decoded;
+  std::vector<std::vector<uint8_t>> telemetry;
+  for (const auto &frame : frames) {
+    stream += frame.frame;
+    decoded.push_back(host::decode_ascii_frame(frame.frame));
+    if (frame.function == 0x42)
+      telemetry.push_back(decoded.back());
+  }
+  uint64_t decoded_bytes = 0;
+  for (const auto &data : decoded)
+    decoded_bytes += data.size();
+  uint64_t telemetry_bytes = 0;
+  for (const auto &data : telemetry)
+    telemetry_bytes += data.size();
+  printf("%u frames (%u telemetry, %u bytes on the wire) x %" PRIu32 " iterations\n", (unsigned) frames.size(),
+         (unsigned) telemetry.size(), (unsigned) stream.size(), iterations);
+
+  int result = 0;
+
+  // RX path. The frames answer no request, so the bus takes them as unsolicited frames
+  uart::UARTComponent rx_uart;
+  seplos_modbus::SeplosModbus rx_bus{};
+  rx_bus.set_uart_parent(&rx_uart);
+  rx_bus.set_unsolicited_frames(true);
+  FrameCounter counter{};
+  counter.set_parent(&rx_bus);
+  rx_bus.register_device(&counter);
+  rx_bus.setup();
+  rx_uart.reserve(stream.size());
+
+  const Measurement rx = measure([&]() {
+    for (uint32_t i = 0; i < iterations; i++) {
+      rx_uart.receive(stream);
+      while (rx_uart.rx_available() > 0)
+        rx_bus.loop();
+    }
+  });
+  report("RX path", rx, (uint64_t) frames.size() * iterations, (uint64_t) stream.size() * iterations);
+  if (counter.frames != frames.size() * iterations) {
+    fprintf(stderr, "RX path: %" PRIu32 " of %" PRIu64 " frames received\n", counter.frames,
+            (uint64_t) frames.size() * iterations);
+    result = 1;
+  }
+  if (rx.allocations > 0) {
+    fprintf(stderr, "RX path: %" PRIu64 " heap allocations\n", rx.allocations);
+    result = 1;
+  }
+
+  // Decoding by a BMS with all entities
+  host::BmsFixture fixture(0x20);
+  fixture.setup();
+
+  const Measurement decode_telemetry = measure([&]() {
+    for (uint32_t i = 0; i < iterations; i++) {
+      for (const auto &data : telemetry)
+        fixture.bms.on_seplos_modbus_data(0x42, data.data(), data.size());
+    }
+  });
+  report("Telemetry decode", decode_telemetry, (uint64_t) telemetry.size() * iterations,
+         telemetry_bytes * iterations);
+  if (!telemetry.empty() && !(fixture.cell_voltages[0]->has_state() && fixture.cell_voltages[0]->state > 0.0f)) {
+    fprintf(stderr, "Telemetry decode: no cell voltage published\n");
+    result = 1;
+  }
+
+  const Measurement decode_all = measure([&]() {
+    for (uint32_t i = 0; i < iterations; i++) {
+      for (size_t j = 0; j < frames.size(); j++)
+        fixture.bms.on_seplos_modbus_data(frames[j].function, decoded[j].data(), decoded[j].size());
+    }
+  });
+  report("All responses", decode_all, (uint64_t) frames.size() * iterations, decoded_bytes * iterations);
+
+  return result;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "esphome/core/application.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/seplos_bms/seplos_bms.h"
+#include "esphome/components/seplos_modbus/seplos_modbus.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/components/uart/uart.h"
+
+#include <deque>
+
+namespace esphome {
+namespace host {
+
+// A bus on the UART of the host with a single BMS at address 0x00 publishing all of its entities
+struct BmsFixture {
+  static const uint8_t CELLS = 16;
+  static const uint8_t TEMPERATURES = 6;
+
+  uart::UARTComponent uart;
+  // Value initialized like the `new T()` of the generated code, which zeroes the members without an initializer
+  seplos_modbus::SeplosModbus bus{};
+  seplos_bms::SeplosBms bms{};
+  std::deque<sensor::Sensor> sensors;
+  sensor::Sensor *cell_voltages[CELLS];
+  sensor::Sensor *temperatures[TEMPERATURES];
+  sensor::Sensor *system_parameters[seplos_bms::SYSTEM_PARAMETERS];
+  sensor::Sensor *charged_energy, *discharged_energy;
+  binary_sensor::BinarySensor charging_switch, discharging_switch, balancing;
+  text_sensor::TextSensor errors, device_name, software_version, manufacturer_name;
+
+  explicit BmsFixture(uint8_t protocol_version,
+                      seplos_modbus::SeplosTransport transport = seplos_modbus::TRANSPORT_ASCII) {
+    this->bus.set_uart_parent(&this->uart);
+    this->bms.set_parent(&this->bus);
+    this->bms.set_address(0x00);
+    this->bms.set_pack(0x00);
+    this->bms.set_protocol_version(protocol_version);
+    this->bms.set_transport(transport);
+    this->bus.register_device(&this->bms);
+
+    for (uint8_t cell = 0; cell < CELLS; cell++) {
+      this->cell_voltages[cell] = this->make_sensor_();
+      this->bms.set_cell_voltage_sensor(cell, this->cell_voltages[cell]);
+      this->bms.set_cell_resistance_sensor(cell, this->make_sensor_());
+      this->bms.set_cell_drift_sensor(cell, this->make_sensor_());
+    }
+    for (uint8_t temperature = 0; temperature < TEMPERATURES; temperature++) {
+      this->temperatures[temperature] = this->make_sensor_();
+      this->bms.set_temperature_sensor(temperature, this->temperatures[temperature]);
+    }
+    for (uint8_t parameter = 0; parameter < seplos_bms::SYSTEM_PARAMETERS; parameter++) {
+      this->system_parameters[parameter] = this->make_sensor_();
+      this->bms.set_system_parameter_sensor(parameter, this->system_parameters[parameter]);
+    }
+    this->bms.set_min_cell_voltage_sensor(this->make_sensor_());
+    this->bms.set_max_cell_voltage_sensor(this->make_sensor_());
+    this->bms.set_min_voltage_cell_sensor(this->make_sensor_());
+    this->bms.set_max_voltage_cell_sensor(this->make_sensor_());
+    this->bms.set_delta_cell_voltage_sensor(this->make_sensor_());
+    this->bms.set_average_cell_voltage_sensor(this->make_sensor_());
+    this->bms.set_total_voltage_sensor(this->make_sensor_());
+    this->bms.set_current_sensor(this->make_sensor_());
+    this->bms.set_power_sensor(this->make_sensor_());
+    this->bms.set_charging_power_sensor(this->make_sensor_());
+    this->bms.set_discharging_power_sensor(this->make_sensor_());
+    this->bms.set_state_of_charge_sensor(this->make_sensor_());
+    this->bms.set_residual_capacity_sensor(this->make_sensor_());
+    this->bms.set_battery_capacity_sensor(this->make_sensor_());
+    this->bms.set_rated_capacity_sensor(this->make_sensor_());
+    this->bms.set_charging_cycles_sensor(this->make_sensor_());
+    this->bms.set_state_of_health_sensor(this->make_sensor_());
+    this->bms.set_port_voltage_sensor(this->make_sensor_());
+    this->charged_energy = this->make_sensor_();
+    this->bms.set_charged_energy_sensor(this->charged_energy);
+    this->discharged_energy = this->make_sensor_();
+    this->bms.set_discharged_energy_sensor(this->discharged_energy);
+    this->bms.set_charging_switch_binary_sensor(&this->charging_switch);
+    this->bms.set_discharging_switch_binary_sensor(&this->discharging_switch);
+    this->bms.set_balancing_binary_sensor(&this->balancing);
+    this->bms.set_errors_text_sensor(&this->errors);
+    this->bms.set_device_name_text_sensor(&this->device_name);
+    this->bms.set_software_version_text_sensor(&this->software_version);
+    this->bms.set_manufacturer_name_text_sensor(&this->manufacturer_name);
+  }
+  ~BmsFixture() {
+    for (auto &sensor : this->sensors)
+      App.unregister_sensor(&sensor);
+  }
+  BmsFixture(const BmsFixture &) = delete;
+  BmsFixture &operator=(const BmsFixture &) = delete;
+
+  void setup() {
+    this->bus.setup();
+    this->bms.setup();
+  }
+
+ protected:
+  // Registered with the application like the sensors of the generated code
+  sensor::Sensor *make_sensor_() {
+    sensor::Sensor *sensor = &this->sensors.emplace_back();
+    App.register_sensor(sensor);
+    return sensor;
+  }
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,187 @@
+// Records of the capture ring, its download while another thread records, and the responses of the web handler
+#include "esphome/components/seplos_modbus/capture.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+using namespace esphome;
+using seplos_modbus::CAPTURE_HEADER_SIZE;
+using seplos_modbus::CAPTURE_MAX_FRAME_SIZE;
+using seplos_modbus::SeplosModbusCapture;
+
+namespace {
+
+struct Record {
+  uint32_t timestamp;
+  uint8_t direction;
+  std::vector<uint8_t> frame;
+};
+
+// Splits the download into its records, fails on a partial record
+bool parse(const std::vector<uint8_t> &data, std::vector<Record> &records) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    if (data.size() - offset < CAPTURE_HEADER_SIZE)
+      return false;
+    Record record;
+    record.timestamp =
+        data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | uint32_t(data[offset + 3]) << 24;
+    record.direction = data[offset + 4];
+    const size_t length = data[offset + 5] | data[offset + 6] << 8;
+    offset += CAPTURE_HEADER_SIZE;
+    if (data.size() - offset < length)
+      return false;
+    record.frame.assign(data.begin() + offset, data.begin() + offset + length);
+    offset += length;
+    records.push_back(record);
+  }
+  return true;
+}
+
+std::vector<Record> download(SeplosModbusCapture &capture) {
+  std::vector<uint8_t> data;
+  capture.copy_to(data);
+  std::vector<Record> records;
+  CHECK(parse(data, records));
+  return records;
+}
+
+void record_rx(SeplosModbusCapture &capture, uint32_t timestamp, const std::vector<uint8_t> &frame) {
+  capture.begin_record(timestamp, seplos_modbus::CAPTURE_RX);
+  for (uint8_t byte : frame)
+    capture.append(byte);
+  capture.end_record();
+}
+
+// Frees the ring, which the component never does
+class Capture : public SeplosModbusCapture {
+ public:
+  explicit Capture(size_t size) { CHECK(this->allocate(size)); }
+  ~Capture() { ExternalRAMAllocator<uint8_t>().deallocate(this->buffer_, this->capacity_); }
+};
+
+void test_records() {
+  Capture capture(1024);
+  CHECK(download(capture).empty());
+
+  record_rx(capture, 0x12345678, {'~', '2', '0', '\r'});
+  const uint8_t request[] = {0x01, 0x04, 0x10, 0x00, 0x00, 0x11, 0x00, 0x00};
+  capture.begin_record(1000, seplos_modbus::CAPTURE_TX);
+  capture.append(request, sizeof(request));
+  capture.end_record();
+  // A record without bytes leaves no trace
+  capture.begin_record(2000, seplos_modbus::CAPTURE_RX);
+  capture.end_record();
+  // The record in progress isn't part of the download yet
+  capture.begin_record(3000, seplos_modbus::CAPTURE_RX);
+  capture.append(0x7E);
+
+  const std::vector<Record> records = download(capture);
+  CHECK(records.size() == 2);
+  if (records.size() == 2) {
+    CHECK(records[0].timestamp == 0x12345678);
+    CHECK(records[0].direction == seplos_modbus::CAPTURE_RX);
+    CHECK(records[0].frame == std::vector<uint8_t>({'~', '2', '0', '\r'}));
+    CHECK(records[1].timestamp == 1000);
+    CHECK(records[1].direction == seplos_modbus::CAPTURE_TX);
+    CHECK(records[1].frame == std::vector<uint8_t>(request, request + sizeof(request)));
+  }
+
+  // Starting the next record completes the one in progress
+  capture.begin_record(4000, seplos_modbus::CAPTURE_RX);
+  CHECK(download(capture).size() == 3);
+}
+
+void test_truncated_frame() {
+  Capture capture(2048);
+  record_rx(capture, 0, std::vector<uint8_t>(CAPTURE_MAX_FRAME_SIZE + 100, 0x30));
+  const std::vector<Record> records = download(capture);
+  CHECK(records.size() == 1);
+  if (records.size() == 1)
+    CHECK(records[0].frame.size() == CAPTURE_MAX_FRAME_SIZE);
+}
+
+void test_ring() {
+  // Records of 7 + 13 bytes, the ring of 100 bytes keeps the newest 5 across the wrap around
+  Capture capture(100);
+  for (uint32_t i = 0; i < 23; i++)
+    record_rx(capture, i, std::vector<uint8_t>(13, uint8_t(i)));
+
+  std::vector<Record> records = download(capture);
+  CHECK(records.size() == 5);
+  for (size_t i = 0; i < records.size(); i++) {
+    CHECK(records[i].timestamp == 18 + i);
+    CHECK(records[i].frame == std::vector<uint8_t>(13, uint8_t(18 + i)));
+  }
+
+  // A record larger than the ring is left out without dropping the others
+  record_rx(capture, 100, std::vector<uint8_t>(100, 0xFF));
+  CHECK(download(capture).size() == 5);
+}
+
+void test_download_while_recording() {
+  Capture capture(512);
+  std::atomic<bool> done{false};
+
+  // Records of varying length and the index in every byte, like the bus task does
+  std::thread recorder([&]() {
+    for (uint32_t i = 0; i < 100000; i++)
+      record_rx(capture, i, std::vector<uint8_t>(1 + i % 60, uint8_t(i)));
+    done = true;
+  });
+
+  uint32_t downloads = 0;
+  while (!done || downloads == 0) {
+    std::vector<Record> records = download(capture);
+    for (size_t i = 0; i < records.size(); i++) {
+      const Record &record = records[i];
+      CHECK(record.frame == std::vector<uint8_t>(1 + record.timestamp % 60, uint8_t(record.timestamp)));
+      if (i > 0)
+        CHECK(record.timestamp == records[i - 1].timestamp + 1);
+    }
+    downloads++;
+  }
+  recorder.join();
+  CHECK(downloads > 0);
+}
+
+void test_handler() {
+  Capture capture(1024);
+  seplos_modbus::SeplosModbusCaptureHandler handler(&capture, "/seplos_modbus/capture");
+
+  AsyncWebServerRequest other("/other");
+  CHECK(!handler.canHandle(&other));
+  AsyncWebServerRequest post("/seplos_modbus/capture", HTTP_POST);
+  CHECK(!handler.canHandle(&post));
+
+  record_rx(capture, 1, {0x01, 0x02});
+  AsyncWebServerRequest first("/seplos_modbus/capture");
+  CHECK(handler.canHandle(&first));
+  handler.handleRequest(&first);
+
+  record_rx(capture, 2, {0x03});
+  AsyncWebServerRequest second("/seplos_modbus/capture");
+  handler.handleRequest(&second);
+
+  CHECK(first.response() != nullptr && second.response() != nullptr);
+  if (first.response() == nullptr || second.response() == nullptr)
+    return;
+  CHECK(first.response()->code == 200);
+  CHECK(first.response()->content_type == "application/octet-stream");
+  CHECK(first.response()->content.size() == CAPTURE_HEADER_SIZE + 2);
+  CHECK(second.response()->content.size() == 2 * CAPTURE_HEADER_SIZE + 3);
+}
+
+}  // namespace
+
+int main() {
+  test_records();
+  test_truncated_frame();
+  test_ring();
+  test_download_while_recording();
+  test_handler();
+  return host::check_result();
+}
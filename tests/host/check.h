@@ -0,0 +1,31 @@
+#pragma once
+
+// Minimal assertions of the host tests: a failed check is reported and counted, the test carries on
+
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+extern int check_failures;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// Exit code of the test program
+inline int check_result() {
+  if (check_failures > 0) {
+    fprintf(stderr, "%d checks failed\n", check_failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
+
+}  // namespace host
+}  // namespace esphome
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      esphome::host::check_failures++; \
+    } \
+  } while (0)
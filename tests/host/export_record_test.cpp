@@ -0,0 +1,202 @@
+// Round trip of the export records through encode_record() and a decoder of the format documented in
+// export_record.h (the one of tests/seplos-export.py)
+#include "esphome/components/seplos_export/export_record.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.h"
+
+using namespace esphome;
+using seplos_export::MAX_RECORD_SIZE;
+using seplos_export::RECORD_HEADER_SIZE;
+
+namespace {
+
+struct Record {
+  uint8_t schema_version;
+  uint8_t pack;
+  uint16_t size;
+  uint32_t timestamp;
+  uint16_t state_of_charge;
+  int16_t current;
+  uint16_t total_voltage;
+  uint16_t residual_capacity;
+  uint16_t battery_capacity;
+  uint16_t state_of_health;
+  uint64_t alarm_bitmask;
+  std::vector<uint16_t> cell_voltages;
+  std::vector<uint16_t> temperatures;
+};
+
+uint16_t get_uint16(const uint8_t *data) { return uint16_t(data[0] | data[1] << 8); }
+uint32_t get_uint32(const uint8_t *data) { return get_uint16(data) | uint32_t(get_uint16(data + 2)) << 16; }
+
+bool decode_record(const std::vector<uint8_t> &data, Record &record) {
+  if (data.size() < RECORD_HEADER_SIZE)
+    return false;
+  record.schema_version = data[0];
+  record.pack = data[1];
+  record.size = get_uint16(&data[2]);
+  record.timestamp = get_uint32(&data[4]);
+  record.state_of_charge = get_uint16(&data[8]);
+  record.current = int16_t(get_uint16(&data[10]));
+  record.total_voltage = get_uint16(&data[12]);
+  record.residual_capacity = get_uint16(&data[14]);
+  record.battery_capacity = get_uint16(&data[16]);
+  record.state_of_health = get_uint16(&data[18]);
+  record.alarm_bitmask = get_uint32(&data[20]) | uint64_t(get_uint32(&data[24])) << 32;
+  const uint8_t cells = data[28];
+  const uint8_t temperature_sensors = data[29];
+  if (record.size != data.size() || record.size != RECORD_HEADER_SIZE + (cells + temperature_sensors) * 2)
+    return false;
+  for (uint8_t i = 0; i < cells; i++)
+    record.cell_voltages.push_back(get_uint16(&data[RECORD_HEADER_SIZE + i * 2]));
+  for (uint8_t i = 0; i < temperature_sensors; i++)
+    record.temperatures.push_back(get_uint16(&data[RECORD_HEADER_SIZE + (cells + i) * 2]));
+  return true;
+}
+
+std::vector<uint8_t> to_big_endian(const std::vector<uint16_t> &values) {
+  std::vector<uint8_t> bytes;
+  for (uint16_t value : values) {
+    bytes.push_back(uint8_t(value >> 8));
+    bytes.push_back(uint8_t(value >> 0));
+  }
+  return bytes;
+}
+
+struct Telemetry {
+  seplos_bms::SeplosTelemetry telemetry{};
+  std::vector<uint16_t> cell_voltages;
+  std::vector<uint16_t> temperatures;
+};
+
+// Encodes behind a prefix, like the records appended to the ring of the component
+Record round_trip(const Telemetry &input, uint32_t timestamp) {
+  const std::vector<uint8_t> cell_voltages = to_big_endian(input.cell_voltages);
+  const std::vector<uint8_t> temperatures = to_big_endian(input.temperatures);
+  seplos_bms::SeplosTelemetry telemetry = input.telemetry;
+  telemetry.cells = uint8_t(input.cell_voltages.size());
+  telemetry.cell_voltages = cell_voltages.empty() ? nullptr : cell_voltages.data();
+  telemetry.temperature_sensors = uint8_t(input.temperatures.size());
+  telemetry.temperatures = temperatures.empty() ? nullptr : temperatures.data();
+
+  std::vector<uint8_t> out = {0xAA, 0x55};
+  const size_t size = seplos_export::encode_record(telemetry, timestamp, out);
+  CHECK(out.size() == 2 + size);
+  CHECK(out[0] == 0xAA && out[1] == 0x55);
+  CHECK(size <= MAX_RECORD_SIZE);
+
+  Record record{};
+  CHECK(decode_record(std::vector<uint8_t>(out.begin() + 2, out.end()), record));
+  CHECK(record.schema_version == seplos_export::SCHEMA_VERSION);
+  CHECK(record.pack == input.telemetry.pack);
+  CHECK(record.timestamp == timestamp);
+  CHECK(record.alarm_bitmask == input.telemetry.alarm_bitmask);
+  return record;
+}
+
+Telemetry random_telemetry(std::mt19937 &random) {
+  Telemetry input;
+  seplos_bms::SeplosTelemetry &telemetry = input.telemetry;
+  telemetry.pack = uint8_t(random() % 16);
+  telemetry.packs = 1;
+  telemetry.state_of_charge = float(random() % 1001) / 10.0f;
+  telemetry.current = float(int32_t(random() % 40001) - 20000) / 100.0f;
+  telemetry.total_voltage = float(4000 + random() % 2000) / 100.0f;
+  telemetry.residual_capacity = float(random() % 28000) / 100.0f;
+  telemetry.battery_capacity = float(random() % 28000) / 100.0f;
+  telemetry.state_of_health = float(random() % 1001) / 10.0f;
+  telemetry.alarm_bitmask = uint64_t(random()) << 32 | random();
+  for (uint32_t cell = random() % 25; cell > 0; cell--)
+    input.cell_voltages.push_back(uint16_t(2500 + random() % 1200));
+  for (uint32_t temperature = random() % 9; temperature > 0; temperature--)
+    input.temperatures.push_back(uint16_t(2731 + random() % 800));
+  return input;
+}
+
+void test_round_trip() {
+  std::mt19937 random(1);
+  for (int i = 0; i < 1000; i++) {
+    const Telemetry input = random_telemetry(random);
+    const uint32_t timestamp = uint32_t(random());
+    const Record record = round_trip(input, timestamp);
+    const seplos_bms::SeplosTelemetry &telemetry = input.telemetry;
+    CHECK(record.state_of_charge == lroundf(telemetry.state_of_charge * 10.0f));
+    CHECK(record.current == lroundf(telemetry.current * 100.0f));
+    CHECK(record.total_voltage == lroundf(telemetry.total_voltage * 100.0f));
+    CHECK(record.residual_capacity == lroundf(telemetry.residual_capacity * 100.0f));
+    CHECK(record.battery_capacity == lroundf(telemetry.battery_capacity * 100.0f));
+    CHECK(record.state_of_health == lroundf(telemetry.state_of_health * 10.0f));
+    CHECK(record.cell_voltages == input.cell_voltages);
+    CHECK(record.temperatures == input.temperatures);
+  }
+}
+
+void test_sixteen_cells_size() {
+  Telemetry input;
+  input.cell_voltages.assign(16, 3300);
+  input.temperatures.assign(6, 2981);
+  CHECK(round_trip(input, 0).size == 74);
+}
+
+void test_unknown_values() {
+  Telemetry input;
+  input.telemetry.state_of_charge = NAN;
+  input.telemetry.current = NAN;
+  input.telemetry.total_voltage = NAN;
+  input.telemetry.residual_capacity = NAN;
+  input.telemetry.battery_capacity = NAN;
+  input.telemetry.state_of_health = NAN;
+  const Record record = round_trip(input, 0);
+  CHECK(record.state_of_charge == 0xFFFF);
+  CHECK(record.current == INT16_MIN);
+  CHECK(record.total_voltage == 0xFFFF);
+  CHECK(record.residual_capacity == 0xFFFF);
+  CHECK(record.battery_capacity == 0xFFFF);
+  CHECK(record.state_of_health == 0xFFFF);
+  CHECK(record.cell_voltages.empty() && record.temperatures.empty());
+}
+
+void test_clamped_values() {
+  // Out of range values saturate instead of wrapping or turning into the markers of unknown values
+  Telemetry input;
+  input.telemetry.state_of_charge = -5.0f;
+  input.telemetry.current = -1000.0f;
+  input.telemetry.total_voltage = 1000.0f;
+  const Record record = round_trip(input, 0);
+  CHECK(record.state_of_charge == 0);
+  CHECK(record.current == INT16_MIN + 1);
+  CHECK(record.total_voltage == 0xFFFE);
+
+  input.telemetry.current = 1000.0f;
+  CHECK(round_trip(input, 0).current == INT16_MAX);
+}
+
+void test_oversized_telemetry() {
+  // The values beyond MAX_RECORD_SIZE are left out, the cells take precedence over the temperatures
+  Telemetry input;
+  for (uint16_t cell = 0; cell < 200; cell++)
+    input.cell_voltages.push_back(3000 + cell);
+  input.temperatures.assign(6, 2981);
+  const Record record = round_trip(input, 0);
+  const size_t cells = (MAX_RECORD_SIZE - RECORD_HEADER_SIZE) / 2;
+  CHECK(record.size == RECORD_HEADER_SIZE + cells * 2);
+  CHECK(record.cell_voltages.size() == cells);
+  CHECK(std::equal(record.cell_voltages.begin(), record.cell_voltages.end(), input.cell_voltages.begin()));
+  CHECK(record.temperatures.empty());
+}
+
+}  // namespace
+
+int main() {
+  test_round_trip();
+  test_sixteen_cells_size();
+  test_unknown_values();
+  test_clamped_values();
+  test_oversized_telemetry();
+  return host::check_result();
+}
@@ -0,0 +1,62 @@
+// libFuzzer entry point. The first byte of an input selects the target, the rest is its data:
+//
+//   0  Bytes received by the bus. Frames answering no request are decoded as telemetry
+//   1  A frame as handed over to SeplosBms::on_seplos_modbus_data(): CID2 of the request, VER, ADR, CID1, RTN,
+//      LENID and INFO
+//   2  Bytes received by the bus while a Modbus-RTU request of a V3 pack is pending
+//
+// The protocol version of the BMS is taken from the second byte for the targets 1 and 2.
+#include <cstddef>
+#include <cstdint>
+
+#include "bms_fixture.h"
+#include "host.h"
+
+using namespace esphome;
+
+static const uint8_t PROTOCOL_VERSIONS[] = {0x20, 0x21, 0x25, 0x26};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 2)
+    return 0;
+
+  const uint8_t target = data[0] % 3;
+  data++;
+  size--;
+  host::now_ms = 1000;
+
+  switch (target) {
+    case 0: {
+      host::BmsFixture fixture(0x20);
+      fixture.bus.set_unsolicited_frames(true);
+      fixture.setup();
+      fixture.uart.receive(data, size);
+      while (fixture.uart.rx_available() > 0)
+        fixture.bus.loop();
+      // A frame finished by the last byte is dispatched by the next loop
+      fixture.bus.loop();
+      break;
+    }
+    case 1: {
+      host::BmsFixture fixture(PROTOCOL_VERSIONS[data[0] % sizeof(PROTOCOL_VERSIONS)]);
+      fixture.setup();
+      fixture.bms.on_seplos_modbus_data(data[0], data + 1, size - 1);
+      break;
+    }
+    case 2: {
+      host::BmsFixture fixture(PROTOCOL_VERSIONS[data[0] % sizeof(PROTOCOL_VERSIONS)],
+                               seplos_modbus::TRANSPORT_MODBUS_RTU);
+      fixture.bus.set_inter_frame_gap(0);
+      fixture.setup();
+      fixture.bms.update();
+      // Sends the first read of the pack info
+      fixture.bus.loop();
+      fixture.uart.receive(data + 1, size - 1);
+      while (fixture.uart.rx_available() > 0)
+        fixture.bus.loop();
+      fixture.bus.loop();
+      break;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+// Runs the fuzz target without libFuzzer: every file of the corpus and then a fixed set of mutations of them.
+//
+//   seplos_fuzz [-mutations=N] [-seed=N] <corpus directory or file>...
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+void read_input(const std::string &path, std::vector<std::vector<uint8_t>> &inputs) {
+  struct stat info {};
+  if (stat(path.c_str(), &info) != 0) {
+    fprintf(stderr, "Cannot read %s\n", path.c_str());
+    exit(2);
+  }
+  if (S_ISDIR(info.st_mode)) {
+    DIR *dir = opendir(path.c_str());
+    std::vector<std::string> names;
+    while (dirent *entry = readdir(dir)) {
+      if (entry->d_name[0] != '.')
+        names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    for (const auto &name : names)
+      read_input(path + "/" + name, inputs);
+    return;
+  }
+  std::ifstream file(path, std::ios::binary);
+  inputs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Byte level mutations in the spirit of libFuzzer. The first byte selects the target and is kept
+std::vector<uint8_t> mutate(std::vector<uint8_t> input, std::mt19937 &random) {
+  const uint32_t mutations = 1 + random() % 4;
+  for (uint32_t i = 0; i < mutations && input.size() > 1; i++) {
+    const size_t position = 1 + random() % (input.size() - 1);
+    switch (random() % 6) {
+      case 0:  // Flip a bit
+        input[position] ^= 1 << (random() % 8);
+        break;
+      case 1:  // Random byte
+        input[position] = random();
+        break;
+      case 2:  // Erase a run
+        input.erase(input.begin() + position,
+                    input.begin() + std::min(input.size(), position + 1 + random() % 8));
+        break;
+      case 3:  // Insert a byte
+        input.insert(input.begin() + position, (uint8_t) random());
+        break;
+      case 4:  // Truncate
+        input.resize(position);
+        break;
+      case 5: {  // Duplicate a run
+        const size_t length = std::min<size_t>(input.size() - position, 1 + random() % 32);
+        std::vector<uint8_t> run(input.begin() + position, input.begin() + position + length);
+        input.insert(input.begin() + position, run.begin(), run.end());
+        break;
+      }
+    }
+  }
+  return input;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t mutations = 0;
+  uint32_t seed = 1;
+  std::vector<std::vector<uint8_t>> inputs;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-mutations=", 11) == 0) {
+      mutations = strtoul(argv[i] + 11, nullptr, 10);
+    } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+      seed = strtoul(argv[i] + 6, nullptr, 10);
+    } else {
+      read_input(argv[i], inputs);
+    }
+  }
+  if (inputs.empty()) {
+    fprintf(stderr, "Usage: %s [-mutations=N] [-seed=N] <corpus directory or file>...\n", argv[0]);
+    return 2;
+  }
+
+  for (const auto &input : inputs)
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+
+  std::mt19937 random(seed);
+  for (uint32_t i = 0; i < mutations; i++) {
+    const std::vector<uint8_t> input = mutate(inputs[random() % inputs.size()], random);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+
+  printf("%u inputs, %" PRIu32 " mutations\n", (unsigned) inputs.size(), mutations);
+  return 0;
+}
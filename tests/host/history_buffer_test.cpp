@@ -0,0 +1,243 @@
+// Round trip of the history records through encode_record(), the ring of HistoryBuffer and a decoder of the
+// format documented in history_buffer.h (the one of tests/seplos-history.py)
+#include "esphome/components/seplos_history/history_buffer.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "check.h"
+
+using namespace esphome;
+using seplos_history::HistorySample;
+using seplos_history::MAX_RECORD_SIZE;
+
+namespace {
+
+struct Sample {
+  uint8_t pack;
+  uint32_t timestamp;
+  uint16_t state_of_charge;
+  int16_t current;
+  uint16_t total_voltage;
+  std::vector<uint16_t> cell_voltages;
+  std::vector<uint16_t> temperatures;
+
+  bool operator==(const Sample &other) const {
+    return pack == other.pack && timestamp == other.timestamp && state_of_charge == other.state_of_charge &&
+           current == other.current && total_voltage == other.total_voltage &&
+           cell_voltages == other.cell_voltages && temperatures == other.temperatures;
+  }
+};
+
+// Reads a record, fails on a truncated record or bytes left over
+class RecordReader {
+ public:
+  RecordReader(const uint8_t *data, size_t length) : data_(data), length_(length) {}
+
+  bool get(uint8_t &byte) {
+    if (this->position_ >= this->length_)
+      return false;
+    byte = this->data_[this->position_++];
+    return true;
+  }
+  bool get_varint(uint32_t &value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+      uint8_t byte;
+      if (!this->get(byte))
+        return false;
+      value |= uint32_t(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+  bool get_zigzag(int32_t &value) {
+    uint32_t raw;
+    if (!this->get_varint(raw))
+      return false;
+    value = int32_t(raw >> 1) ^ -int32_t(raw & 1);
+    return true;
+  }
+  bool get_series(std::vector<uint16_t> &values) {
+    uint32_t count;
+    if (!this->get_varint(count))
+      return false;
+    int32_t value = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      if (i == 0) {
+        uint32_t first;
+        if (!this->get_varint(first))
+          return false;
+        value = int32_t(first);
+      } else {
+        int32_t difference;
+        if (!this->get_zigzag(difference))
+          return false;
+        value += difference;
+      }
+      values.push_back(uint16_t(value));
+    }
+    return true;
+  }
+
+  bool at_end() const { return this->position_ == this->length_; }
+
+ protected:
+  const uint8_t *data_;
+  size_t length_;
+  size_t position_{0};
+};
+
+bool decode_record(const uint8_t *record, size_t length, Sample &sample) {
+  if (length == 0 || size_t(record[0]) + 1 != length)
+    return false;
+
+  RecordReader reader(record + 1, length - 1);
+  uint8_t timestamp[4];
+  uint32_t state_of_charge, total_voltage;
+  int32_t current;
+  if (!reader.get(sample.pack) || !reader.get(timestamp[0]) || !reader.get(timestamp[1]) ||
+      !reader.get(timestamp[2]) || !reader.get(timestamp[3]) || !reader.get_varint(state_of_charge) ||
+      !reader.get_zigzag(current) || !reader.get_varint(total_voltage) || !reader.get_series(sample.cell_voltages) ||
+      !reader.get_series(sample.temperatures))
+    return false;
+
+  sample.timestamp = timestamp[0] | timestamp[1] << 8 | timestamp[2] << 16 | uint32_t(timestamp[3]) << 24;
+  sample.state_of_charge = uint16_t(state_of_charge);
+  sample.current = int16_t(current);
+  sample.total_voltage = uint16_t(total_voltage);
+  return reader.at_end();
+}
+
+std::vector<uint8_t> to_big_endian(const std::vector<uint16_t> &values) {
+  std::vector<uint8_t> bytes;
+  for (uint16_t value : values) {
+    bytes.push_back(uint8_t(value >> 8));
+    bytes.push_back(uint8_t(value >> 0));
+  }
+  return bytes;
+}
+
+// Encodes into a buffer of exactly MAX_RECORD_SIZE bytes, so the sanitizer catches a write beyond it
+std::vector<uint8_t> encode(const Sample &sample) {
+  const std::vector<uint8_t> cell_voltages = to_big_endian(sample.cell_voltages);
+  const std::vector<uint8_t> temperatures = to_big_endian(sample.temperatures);
+  HistorySample history_sample{};
+  history_sample.pack = sample.pack;
+  history_sample.timestamp = sample.timestamp;
+  history_sample.state_of_charge = sample.state_of_charge;
+  history_sample.current = sample.current;
+  history_sample.total_voltage = sample.total_voltage;
+  history_sample.cells = uint8_t(sample.cell_voltages.size());
+  history_sample.cell_voltages = cell_voltages.empty() ? nullptr : cell_voltages.data();
+  history_sample.temperature_sensors = uint8_t(sample.temperatures.size());
+  history_sample.temperatures = temperatures.empty() ? nullptr : temperatures.data();
+
+  std::vector<uint8_t> record(MAX_RECORD_SIZE);
+  record.resize(seplos_history::encode_record(history_sample, record.data()));
+  return record;
+}
+
+Sample random_sample(std::mt19937 &random) {
+  Sample sample{};
+  sample.pack = uint8_t(random() % 16);
+  sample.timestamp = uint32_t(random());
+  sample.state_of_charge = uint16_t(random() % 1001);
+  sample.current = int16_t(random());
+  sample.total_voltage = uint16_t(random());
+  const uint16_t cell_voltage = uint16_t(2500 + random() % 1200);
+  for (uint32_t cell = random() % 25; cell > 0; cell--)
+    sample.cell_voltages.push_back(uint16_t(cell_voltage + random() % 200 - 100));
+  for (uint32_t temperature = random() % 9; temperature > 0; temperature--)
+    sample.temperatures.push_back(uint16_t(2731 + random() % 800));
+  return sample;
+}
+
+void check_round_trip(const Sample &sample) {
+  const std::vector<uint8_t> record = encode(sample);
+  CHECK(!record.empty());
+  Sample decoded{};
+  CHECK(decode_record(record.data(), record.size(), decoded));
+  CHECK(decoded == sample);
+}
+
+void test_round_trip() {
+  std::mt19937 random(1);
+  for (int i = 0; i < 1000; i++)
+    check_round_trip(random_sample(random));
+
+  // No cells and temperatures, and the limits of the fields
+  check_round_trip(Sample{0, 0, 0, 0, 0, {}, {}});
+  check_round_trip(Sample{255, UINT32_MAX, UINT16_MAX, INT16_MIN, UINT16_MAX, {0}, {UINT16_MAX}});
+  check_round_trip(Sample{1, 1, 1000, INT16_MAX, 5312, {0, UINT16_MAX, 0, UINT16_MAX}, {UINT16_MAX, 0}});
+}
+
+void test_sixteen_cells_size() {
+  Sample sample{0, 123456, 870, -1234, 5312, {}, {2981, 2982, 2983, 2984, 2985, 2986}};
+  for (uint16_t cell = 0; cell < 16; cell++)
+    sample.cell_voltages.push_back(uint16_t(3300 + cell % 3));
+  const std::vector<uint8_t> record = encode(sample);
+  CHECK(record.size() > 0 && record.size() <= 48);
+}
+
+void test_oversized_sample() {
+  // Alternating extremes take 3 bytes per cell, 200 cells don't fit
+  Sample sample{0, 0, 0, 0, 0, {}, {}};
+  for (uint16_t cell = 0; cell < 200; cell++)
+    sample.cell_voltages.push_back(cell % 2 ? UINT16_MAX : 0);
+  CHECK(encode(sample).empty());
+}
+
+void test_ring() {
+  // Never freed, like the one of the component
+  static seplos_history::HistoryBuffer buffer;
+  CHECK(buffer.allocate(300));
+
+  std::mt19937 random(2);
+  std::vector<Sample> pushed;
+  std::vector<uint8_t> popped;
+  for (int i = 0; i < 500; i++) {
+    const Sample sample = random_sample(random);
+    const std::vector<uint8_t> record = encode(sample);
+    buffer.push(record.data(), record.size());
+    pushed.push_back(sample);
+
+    // Drain now and then, in chunks smaller and larger than a record
+    if (random() % 4 == 0)
+      buffer.pop(popped, 20 + random() % 200);
+  }
+  while (buffer.pop(popped, MAX_RECORD_SIZE) > 0) {
+  }
+  CHECK(buffer.size() == 0);
+  CHECK(buffer.records() == 0);
+
+  // The popped records are a subsequence of the pushed ones in order, the others were dropped
+  size_t offset = 0;
+  size_t decoded = 0;
+  size_t next = 0;
+  while (offset < popped.size()) {
+    const size_t length = 1 + size_t(popped[offset]);
+    Sample sample{};
+    CHECK(offset + length <= popped.size() && decode_record(popped.data() + offset, length, sample));
+    while (next < pushed.size() && !(pushed[next] == sample))
+      next++;
+    CHECK(next < pushed.size());
+    next++;
+    offset += length;
+    decoded++;
+  }
+  CHECK(decoded + buffer.dropped() == pushed.size());
+  CHECK(buffer.dropped() > 0);
+}
+
+}  // namespace
+
+int main() {
+  test_round_trip();
+  test_sixteen_cells_size();
+  test_oversized_sample();
+  test_ring();
+  return host::check_result();
+}
@@ -0,0 +1,236 @@
+// Encodes telemetry into the Pylontech frames and sends them over the virtual CAN bus of the canbus stand-in
+#include "esphome/components/canbus/canbus.h"
+#include "esphome/components/pylontech_can/pylontech_can.h"
+
+#include <cmath>
+#include <functional>
+#include <string>
+
+#include "check.h"
+#include "host.h"
+
+using namespace esphome;
+
+namespace {
+
+// Stands in for a seplos_bms pack or a seplos_bank
+class TelemetrySource {
+ public:
+  void add_on_telemetry_callback(std::function<void(const seplos_bms::SeplosTelemetry &)> &&callback) {
+    this->callback_.add(std::move(callback));
+  }
+  void publish(const seplos_bms::SeplosTelemetry &telemetry) { this->callback_.call(telemetry); }
+  void set_alarms_required(bool alarms_required) { this->alarms_required = alarms_required; }
+  bool alarms_required{false};
+
+ protected:
+  CallbackManager<void(const seplos_bms::SeplosTelemetry &)> callback_;
+};
+
+constexpr uint64_t alarm_bit(uint8_t bit) { return uint64_t(1) << bit; }
+
+seplos_bms::SeplosTelemetry make_telemetry(uint64_t alarm_bitmask) {
+  seplos_bms::SeplosTelemetry telemetry{};
+  telemetry.packs = 2;
+  telemetry.cells = 16;
+  telemetry.max_temperature = 25.4f;
+  telemetry.current = -12.3f;
+  telemetry.total_voltage = 53.12f;
+  telemetry.state_of_charge = 87.0f;
+  telemetry.state_of_health = 99.0f;
+  telemetry.alarm_bitmask = alarm_bitmask;
+  telemetry.alarms_received = true;
+  return telemetry;
+}
+
+uint16_t get_16bit(const std::vector<uint8_t> &data, size_t pos) { return uint16_t(data[pos] | data[pos + 1] << 8); }
+
+const canbus::Canbus::Frame *find_frame(const canbus::Canbus &canbus, uint32_t can_id) {
+  for (const auto &frame : canbus.sent) {
+    if (frame.can_id == can_id)
+      return &frame;
+  }
+  return nullptr;
+}
+
+struct Fixture {
+  canbus::Canbus canbus;
+  TelemetrySource source;
+  pylontech_can::PylontechCan pylontech{};
+
+  Fixture() {
+    this->pylontech.set_canbus(&this->canbus);
+    this->pylontech.set_source(&this->source);
+    this->pylontech.set_charge_voltage(56.0f);
+    this->pylontech.set_charge_current(100.0f);
+    this->pylontech.set_discharge_current(150.0f);
+    this->pylontech.set_discharge_voltage(48.0f);
+    this->pylontech.set_timeout(30000);
+    this->pylontech.setup();
+  }
+
+  // Publishes the telemetry and returns the frames of the next update
+  const canbus::Canbus &send(uint64_t alarm_bitmask) {
+    this->source.publish(make_telemetry(alarm_bitmask));
+    this->canbus.sent.clear();
+    this->pylontech.update();
+    return this->canbus;
+  }
+};
+
+void test_frames() {
+  Fixture fixture;
+  fixture.pylontech.update();
+  CHECK(fixture.canbus.sent.empty());
+
+  const canbus::Canbus &canbus = fixture.send(0);
+  CHECK(canbus.sent.size() == pylontech_can::PYLONTECH_FRAMES);
+  for (const auto &frame : canbus.sent)
+    CHECK(!frame.use_extended_id);
+
+  const auto *limits = find_frame(canbus, 0x351);
+  CHECK(limits != nullptr && limits->data.size() == 8);
+  if (limits != nullptr) {
+    CHECK(get_16bit(limits->data, 0) == 560);
+    CHECK(get_16bit(limits->data, 2) == 1000);
+    CHECK(get_16bit(limits->data, 4) == 1500);
+    CHECK(get_16bit(limits->data, 6) == 480);
+  }
+
+  const auto *state = find_frame(canbus, 0x355);
+  CHECK(state != nullptr && state->data.size() == 4);
+  if (state != nullptr) {
+    CHECK(get_16bit(state->data, 0) == 87);
+    CHECK(get_16bit(state->data, 2) == 99);
+  }
+
+  const auto *measurements = find_frame(canbus, 0x356);
+  CHECK(measurements != nullptr && measurements->data.size() == 6);
+  if (measurements != nullptr) {
+    CHECK(get_16bit(measurements->data, 0) == 5312);
+    CHECK(int16_t(get_16bit(measurements->data, 2)) == -123);
+    CHECK(get_16bit(measurements->data, 4) == 254);
+  }
+
+  const auto *alarms = find_frame(canbus, 0x359);
+  CHECK(alarms != nullptr && alarms->data.size() == 8);
+  if (alarms != nullptr) {
+    CHECK(alarms->data[0] == 0 && alarms->data[1] == 0 && alarms->data[2] == 0 && alarms->data[3] == 0);
+    CHECK(alarms->data[4] == 2);
+    CHECK(alarms->data[5] == 'P' && alarms->data[6] == 'N');
+  }
+
+  const auto *request = find_frame(canbus, 0x35C);
+  CHECK(request != nullptr && request->data.size() == 2);
+  if (request != nullptr)
+    CHECK(request->data[0] == 0xC0);
+
+  const auto *manufacturer = find_frame(canbus, 0x35E);
+  CHECK(manufacturer != nullptr && manufacturer->data.size() == 8);
+  if (manufacturer != nullptr)
+    CHECK(std::string(manufacturer->data.begin(), manufacturer->data.begin() + 5) == "PYLON");
+}
+
+void test_cell_low_voltage_charging_prohibition() {
+  Fixture fixture;
+  const canbus::Canbus &canbus = fixture.send(alarm_bit(44));
+  const auto *limits = find_frame(canbus, 0x351);
+  const auto *request = find_frame(canbus, 0x35C);
+  CHECK(limits != nullptr && request != nullptr);
+  if (limits == nullptr || request == nullptr)
+    return;
+  // Charging is blocked and not requested at the same time
+  CHECK(get_16bit(limits->data, 2) == 0);
+  CHECK(get_16bit(limits->data, 4) == 1500);
+  CHECK(request->data[0] == 0x40);
+}
+
+void test_lockouts_block_discharging() {
+  for (uint8_t bit : {38, 39}) {
+    Fixture fixture;
+    const canbus::Canbus &canbus = fixture.send(alarm_bit(bit));
+    const auto *limits = find_frame(canbus, 0x351);
+    const auto *alarms = find_frame(canbus, 0x359);
+    const auto *request = find_frame(canbus, 0x35C);
+    CHECK(limits != nullptr && alarms != nullptr && request != nullptr);
+    if (limits == nullptr || alarms == nullptr || request == nullptr)
+      continue;
+    CHECK(get_16bit(limits->data, 2) == 1000);
+    CHECK(get_16bit(limits->data, 4) == 0);
+    CHECK(alarms->data[0] == 1 << 7);  // Discharge overcurrent protection
+    CHECK(request->data[0] == 0x80);
+  }
+}
+
+void test_force_charge() {
+  Fixture fixture;
+  const canbus::Canbus &canbus = fixture.send(alarm_bit(10));
+  const auto *alarms = find_frame(canbus, 0x359);
+  const auto *request = find_frame(canbus, 0x35C);
+  CHECK(alarms != nullptr && request != nullptr);
+  if (alarms == nullptr || request == nullptr)
+    return;
+  CHECK(alarms->data[2] == 1 << (18 - 16));  // Cell low voltage alarm
+  CHECK(request->data[0] == 0xE0);
+}
+
+void test_system_fault() {
+  Fixture fixture;
+  const canbus::Canbus &canbus = fixture.send(alarm_bit(0));
+  const auto *alarms = find_frame(canbus, 0x359);
+  CHECK(alarms != nullptr);
+  if (alarms != nullptr)
+    CHECK(alarms->data[1] == 1 << (11 - 8));
+}
+
+void test_timeout() {
+  Fixture fixture;
+  host::now_ms = 1000;
+  fixture.send(0);
+  CHECK(fixture.canbus.sent.size() == pylontech_can::PYLONTECH_FRAMES);
+
+  host::now_ms += 30001;
+  fixture.canbus.sent.clear();
+  fixture.pylontech.update();
+  CHECK(fixture.canbus.sent.empty());
+
+  fixture.send(0);
+  CHECK(fixture.canbus.sent.size() == pylontech_can::PYLONTECH_FRAMES);
+}
+
+void test_unknown_state() {
+  Fixture fixture;
+  CHECK(fixture.source.alarms_required);
+
+  // Without an alarm frame yet the protections aren't known
+  seplos_bms::SeplosTelemetry telemetry = make_telemetry(0);
+  telemetry.alarms_received = false;
+  fixture.source.publish(telemetry);
+  fixture.pylontech.update();
+  CHECK(fixture.canbus.sent.empty());
+
+  // An unknown SOC keeps the last valid one instead of reporting an empty battery
+  fixture.send(0);
+  telemetry = make_telemetry(0);
+  telemetry.state_of_charge = NAN;
+  fixture.source.publish(telemetry);
+  fixture.canbus.sent.clear();
+  fixture.pylontech.update();
+  const auto *state = find_frame(fixture.canbus, 0x355);
+  CHECK(state != nullptr);
+  if (state != nullptr)
+    CHECK(get_16bit(state->data, 0) == 87);
+}
+
+}  // namespace
+
+int main() {
+  test_frames();
+  test_cell_low_voltage_charging_prohibition();
+  test_lockouts_block_discharging();
+  test_force_charge();
+  test_system_fault();
+  test_timeout();
+  test_unknown_state();
+  return host::check_result();
+}
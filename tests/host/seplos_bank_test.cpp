@@ -0,0 +1,117 @@
+// Aggregates of a bank kept per frame compared to a rescan of all packs, also while packs drop out
+#include "esphome/components/seplos_bank/seplos_bank.h"
+
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "host.h"
+
+using namespace esphome;
+
+namespace {
+
+// Hands over the telemetry directly instead of decoding frames
+class Pack : public seplos_bms::SeplosBms {
+ public:
+  void publish(const seplos_bms::SeplosTelemetry &telemetry) { this->telemetry_callback_.call(telemetry); }
+};
+
+seplos_bms::SeplosTelemetry random_telemetry(std::mt19937 &random, uint8_t pack) {
+  seplos_bms::SeplosTelemetry telemetry{};
+  telemetry.pack = pack;
+  telemetry.packs = 1;
+  telemetry.cells = uint8_t(8 + random() % 9);
+  telemetry.min_cell_voltage = float(3000 + random() % 200) / 1000.0f;
+  telemetry.max_cell_voltage = telemetry.min_cell_voltage + float(random() % 100) / 1000.0f;
+  telemetry.min_temperature = float(random() % 300) / 10.0f;
+  telemetry.max_temperature = telemetry.min_temperature + float(random() % 50) / 10.0f;
+  telemetry.current = float(int32_t(random() % 2001) - 1000) / 100.0f;
+  telemetry.total_voltage = float(5000 + random() % 400) / 100.0f;
+  telemetry.battery_capacity = 280.0f;
+  telemetry.residual_capacity = float(random() % 28000) / 100.0f;
+  telemetry.state_of_charge = telemetry.residual_capacity / 2.8f;
+  telemetry.state_of_health = float(900 + random() % 101) / 10.0f;
+  // Sparse alarms, so bits are raised and cleared by several packs
+  telemetry.alarm_bitmask = uint64_t(1) << (random() % 64) | uint64_t(1) << (random() % 64);
+  if (random() % 2)
+    telemetry.alarm_bitmask = 0;
+  telemetry.alarms_received = random() % 8 != 0;
+  return telemetry;
+}
+
+// The bank values by a rescan of the latest telemetry of the online packs
+seplos_bms::SeplosTelemetry rescan(const std::vector<const seplos_bms::SeplosTelemetry *> &online) {
+  seplos_bms::SeplosTelemetry expected{};
+  expected.state_of_health = NAN;
+  expected.min_cell_voltage = NAN;
+  expected.max_cell_voltage = NAN;
+  expected.alarms_received = true;
+  for (const auto *telemetry : online) {
+    expected.cells = std::max(expected.cells, telemetry->cells);
+    expected.state_of_health = std::fmin(expected.state_of_health, telemetry->state_of_health);
+    expected.min_cell_voltage = std::fmin(expected.min_cell_voltage, telemetry->min_cell_voltage);
+    expected.max_cell_voltage = std::fmax(expected.max_cell_voltage, telemetry->max_cell_voltage);
+    expected.alarm_bitmask |= telemetry->alarm_bitmask;
+    expected.alarms_received &= telemetry->alarms_received;
+  }
+  return expected;
+}
+
+}  // namespace
+
+int main() {
+  const uint8_t packs = 5;
+  std::deque<Pack> components(packs);
+  seplos_bank::SeplosBank bank{};
+  bank.set_pack_timeout(10000);
+  for (auto &component : components)
+    bank.add_pack(&component);
+
+  seplos_bms::SeplosTelemetry published{};
+  uint32_t publishes = 0;
+  bank.add_on_telemetry_callback([&](const seplos_bms::SeplosTelemetry &telemetry) {
+    published = telemetry;
+    publishes++;
+  });
+
+  std::mt19937 random(1);
+  std::vector<seplos_bms::SeplosTelemetry> latest(packs);
+  std::vector<uint32_t> last_seen(packs, 0);
+  std::vector<bool> online(packs, false);
+  host::now_ms = 1;
+  for (int i = 0; i < 20000; i++) {
+    host::now_ms += 100;
+    // Pack 4 falls silent for a while every now and then
+    const uint8_t pack = uint8_t(random() % (((i / 2000) % 2) ? packs - 1 : packs));
+    latest[pack] = random_telemetry(random, pack);
+    components[pack].publish(latest[pack]);
+    online[pack] = true;
+    last_seen[pack] = host::now_ms;
+
+    if (i % 10 == 0) {
+      bank.update();
+      for (uint8_t j = 0; j < packs; j++)
+        online[j] = online[j] && host::now_ms - last_seen[j] <= 10000;
+    }
+
+    std::vector<const seplos_bms::SeplosTelemetry *> reporting;
+    for (uint8_t j = 0; j < packs; j++) {
+      if (online[j])
+        reporting.push_back(&latest[j]);
+    }
+    const seplos_bms::SeplosTelemetry expected = rescan(reporting);
+    CHECK(published.packs == reporting.size());
+    CHECK(published.cells == expected.cells);
+    CHECK(published.state_of_health == expected.state_of_health);
+    CHECK(published.min_cell_voltage == expected.min_cell_voltage);
+    CHECK(published.max_cell_voltage == expected.max_cell_voltage);
+    CHECK(published.alarm_bitmask == expected.alarm_bitmask);
+    CHECK(published.alarms_received == expected.alarms_received);
+  }
+  CHECK(publishes >= 20000);
+
+  return host::check_result();
+}
@@ -0,0 +1,215 @@
+// Decodes the telemetry frames of tests/esp8266-fake-bms.yaml by a BMS with all entities
+#include "esphome/components/seplos_bms/seplos_bms.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bms_fixture.h"
+#include "check.h"
+#include "host.h"
+
+using namespace esphome;
+
+namespace {
+
+std::vector<std::vector<uint8_t>> telemetry;          // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+std::vector<std::vector<uint8_t>> system_parameters;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+std::string probe_response;                           // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void decode_telemetry(host::BmsFixture &fixture, uint32_t interval) {
+  for (const auto &data : telemetry) {
+    host::now_ms += interval;
+    fixture.bms.on_seplos_modbus_data(0x42, data.data(), data.size());
+  }
+}
+
+float energy(const host::BmsFixture &fixture) {
+  return fixture.charged_energy->state + fixture.discharged_energy->state;
+}
+
+void test_energy_keys() {
+  // Two packs with the same number on different buses
+  {
+    host::BmsFixture first(0x20), second(0x20);
+    first.bms.set_energy_key("first_bus_bms");
+    second.bms.set_energy_key("second_bus_bms");
+    first.setup();
+    second.setup();
+    decode_telemetry(first, 60000);
+    CHECK(energy(first) > 0.0f);
+    first.bms.on_shutdown();
+    second.bms.on_shutdown();
+  }
+
+  // After a reboot each of them restores its own counters
+  host::BmsFixture first(0x20), second(0x20);
+  first.bms.set_energy_key("first_bus_bms");
+  second.bms.set_energy_key("second_bus_bms");
+  first.setup();
+  second.setup();
+  decode_telemetry(first, 0);
+  decode_telemetry(second, 0);
+  CHECK(energy(first) > 0.0f);
+  CHECK(energy(second) == 0.0f);
+}
+
+void test_energy_until_bound() {
+  {
+    host::BmsFixture fixture(0x20);
+    fixture.bus.set_discovery_max_address(0x00);
+    fixture.bus.add_discovery_protocol_version(0x20);
+    fixture.bms.set_energy_key("discovered_bms");
+    fixture.bms.set_discover_address(true);
+    fixture.setup();
+
+    // Nothing is saved while the pack number of the key isn't known
+    const size_t entries = host::flash().size();
+    fixture.bms.on_shutdown();
+    CHECK(host::flash().size() == entries);
+
+    for (int i = 0; i < 10 && fixture.uart.tx().empty(); i++) {
+      host::now_ms += 100;
+      fixture.bus.loop();
+    }
+    fixture.uart.receive(probe_response);
+    fixture.bus.loop();
+    CHECK(fixture.bms.is_bound());
+
+    decode_telemetry(fixture, 60000);
+    CHECK(energy(fixture) > 0.0f);
+    fixture.bms.on_shutdown();
+  }
+
+  // Saved under the key of the bound pack
+  host::BmsFixture fixture(0x20);
+  fixture.bms.set_energy_key("discovered_bms");
+  fixture.setup();
+  decode_telemetry(fixture, 0);
+  CHECK(energy(fixture) > 0.0f);
+}
+
+void test_deferred_publishing() {
+  // The same frames once published right away and once with a publish budget of 4 states per loop. The
+  // deadbands hold back the small changes between the frames
+  host::BmsFixture direct(0x20), deferred(0x20);
+  deferred.bus.set_publish_budget(4);
+  for (auto *fixture : {&direct, &deferred}) {
+    fixture->bms.set_heartbeat_interval(600000);
+    fixture->bms.set_cell_voltage_deadband(0.005f);
+    fixture->bms.set_voltage_deadband(0.1f);
+    fixture->bms.set_temperature_deadband(0.5f);
+  }
+  direct.setup();
+  deferred.setup();
+  for (auto *fixture : {&direct, &deferred}) {
+    fixture->bms.on_seplos_modbus_data(0x42, telemetry.front().data(), telemetry.front().size());
+    decode_telemetry(*fixture, 0);
+  }
+
+  // Nothing is published before the loop. The pending state counts as the last one
+  sensor::Sensor *cell_voltage = deferred.cell_voltages[0];
+  float state;
+  CHECK(cell_voltage->publishes() == 0);
+  CHECK(deferred.bus.get_sensor_state(cell_voltage, &state) && state == direct.cell_voltages[0]->state);
+
+  // Every sensor waits at most once, with its latest state
+  const size_t loops = (deferred.sensors.size() + 3) / 4;
+  for (size_t i = 0; i < loops; i++)
+    deferred.bus.loop();
+  auto expected = direct.sensors.begin();
+  for (const auto &sensor : deferred.sensors) {
+    CHECK(sensor.publishes() <= 1);
+    CHECK(sensor.has_state() == expected->has_state());
+    CHECK(!sensor.has_state() || sensor.state == expected->state);
+    ++expected;
+  }
+  uint32_t publishes = 0;
+  for (const auto &sensor : deferred.sensors)
+    publishes += sensor.publishes();
+  deferred.bus.loop();
+  for (const auto &sensor : deferred.sensors)
+    publishes -= sensor.publishes();
+  CHECK(publishes == 0);
+}
+
+void test_deadband_without_heartbeat() {
+  // The default heartbeat interval of 0 publishes every frame, only the deadband holds back the small changes
+  host::BmsFixture plain(0x20), filtered(0x20);
+  filtered.bms.set_cell_voltage_deadband(0.005f);
+  plain.setup();
+  filtered.setup();
+  decode_telemetry(plain, 1000);
+  decode_telemetry(filtered, 1000);
+
+  CHECK(plain.cell_voltages[0]->publishes() == telemetry.size());
+  CHECK(filtered.cell_voltages[0]->publishes() >= 1);
+  CHECK(filtered.cell_voltages[0]->publishes() < telemetry.size());
+}
+
+void test_system_parameters() {
+  host::BmsFixture fixture(0x20);
+  fixture.setup();
+  const std::vector<uint8_t> &data = system_parameters.front();
+  fixture.bms.on_seplos_modbus_data(0x47, data.data(), data.size());
+
+  // The thresholds of the captured response, in the order of SYSTEM_PARAMETER_LAYOUT
+  const float expected[seplos_bms::SYSTEM_PARAMETERS] = {3.5f,  2.9f,  2.6f,  55.0f, 2.0f,  100.0f,
+                                                         54.0f, 43.5f, 39.0f, 55.0f, -10.0f, -105.0f};
+  for (uint8_t i = 0; i < seplos_bms::SYSTEM_PARAMETERS; i++) {
+    CHECK(fixture.system_parameters[i]->has_state());
+    CHECK(std::fabs(fixture.system_parameters[i]->state - expected[i]) < 0.001f);
+  }
+
+  // An unchanged response publishes nothing
+  fixture.bms.on_seplos_modbus_data(0x47, data.data(), data.size());
+  for (auto *sensor : fixture.system_parameters)
+    CHECK(sensor->publishes() == 1);
+}
+
+void test_override_cell_count() {
+  // The pack reports 16 cells, only the first 14 are published. The fields behind the cells stay in place
+  host::BmsFixture reported(0x20), overridden(0x20);
+  overridden.bms.set_override_cell_count(14);
+  reported.setup();
+  overridden.setup();
+  for (auto *fixture : {&reported, &overridden}) {
+    fixture->bms.on_seplos_modbus_data(0x42, telemetry.front().data(), telemetry.front().size());
+  }
+
+  for (uint8_t cell = 0; cell < host::BmsFixture::CELLS; cell++) {
+    CHECK(overridden.cell_voltages[cell]->has_state() == (cell < 14));
+    CHECK(cell >= 14 || overridden.cell_voltages[cell]->state == reported.cell_voltages[cell]->state);
+  }
+  for (uint8_t temperature = 0; temperature < host::BmsFixture::TEMPERATURES; temperature++) {
+    CHECK(reported.temperatures[temperature]->has_state());
+    CHECK(overridden.temperatures[temperature]->state == reported.temperatures[temperature]->state);
+  }
+  CHECK(overridden.charged_energy->state == reported.charged_energy->state);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s tests/esp8266-fake-bms.yaml\n", argv[0]);
+    return 2;
+  }
+  for (const auto &frame : host::read_fake_bms_frames(argv[1])) {
+    if (frame.function == 0x42)
+      telemetry.push_back(host::decode_ascii_frame(frame.frame));
+    if (frame.function == 0x47)
+      system_parameters.push_back(host::decode_ascii_frame(frame.frame));
+    if (frame.function == 0x4F)
+      probe_response = frame.frame;
+  }
+  CHECK(!telemetry.empty() && !system_parameters.empty() && !probe_response.empty());
+
+  test_energy_keys();
+  test_energy_until_bound();
+  test_deferred_publishing();
+  test_deadband_without_heartbeat();
+  test_system_parameters();
+  test_override_cell_count();
+  return host::check_result();
+}
@@ -0,0 +1,82 @@
+// Serves the export records of the telemetry frames of tests/esp8266-fake-bms.yaml, also while another thread
+// decodes new frames
+#include "esphome/components/seplos_export/seplos_export.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bms_fixture.h"
+#include "check.h"
+#include "host.h"
+
+using namespace esphome;
+
+namespace {
+
+std::vector<uint8_t> download(seplos_export::SeplosExportHandler &handler) {
+  AsyncWebServerRequest request("/seplos_export");
+  CHECK(handler.canHandle(&request));
+  handler.handleRequest(&request);
+  CHECK(request.response() != nullptr);
+  if (request.response() == nullptr)
+    return {};
+  CHECK(request.response()->code == 200);
+  CHECK(request.response()->content_type == "application/octet-stream");
+  return request.response()->content;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s tests/esp8266-fake-bms.yaml\n", argv[0]);
+    return 2;
+  }
+  std::vector<std::vector<uint8_t>> telemetry;
+  for (const auto &frame : host::read_fake_bms_frames(argv[1])) {
+    if (frame.function == 0x42)
+      telemetry.push_back(host::decode_ascii_frame(frame.frame));
+  }
+  CHECK(telemetry.size() >= 2);
+
+  host::BmsFixture fixture(0x20);
+  seplos_export::SeplosExport exporter{};
+  exporter.add_pack(&fixture.bms);
+  fixture.setup();
+  exporter.setup();
+  seplos_export::SeplosExportHandler handler(&exporter, "/seplos_export");
+
+  // Nothing to serve before the first frame
+  CHECK(download(handler).empty());
+
+  // The record of every frame, the timestamp doesn't change on the host
+  std::vector<std::vector<uint8_t>> records;
+  for (const auto &data : telemetry) {
+    fixture.bms.on_seplos_modbus_data(0x42, data.data(), data.size());
+    records.push_back(download(handler));
+    CHECK(records.back().size() >= seplos_export::RECORD_HEADER_SIZE);
+  }
+
+  // Every download is one of them as a whole while the frames are decoded by another thread
+  std::atomic<bool> done{false};
+  std::thread decoder([&]() {
+    for (int i = 0; i < 2000; i++) {
+      const auto &data = telemetry[i % telemetry.size()];
+      fixture.bms.on_seplos_modbus_data(0x42, data.data(), data.size());
+    }
+    done = true;
+  });
+  uint32_t downloads = 0;
+  while (!done || downloads == 0) {
+    const std::vector<uint8_t> content = download(handler);
+    bool known = false;
+    for (const auto &record : records)
+      known |= content == record;
+    CHECK(known);
+    downloads++;
+  }
+  decoder.join();
+
+  return host::check_result();
+}
@@ -0,0 +1,246 @@
+// Requests and responses on the bus, replayed with the responses of tests/esp8266-fake-bms.yaml
+#include "esphome/components/seplos_modbus/seplos_modbus.h"
+
+#include <string>
+#include <vector>
+
+#include "bms_fixture.h"
+#include "check.h"
+#include "host.h"
+
+using namespace esphome;
+
+namespace {
+
+std::vector<host::FakeBmsFrame> frames;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// The first response of the fake BMS to the function
+std::string response(uint8_t function) {
+  for (const auto &frame : frames) {
+    if (frame.function == function)
+      return frame.frame;
+  }
+  CHECK(false);
+  return {};
+}
+
+// The function (CID2) of every request sent, "~VER ADR CID1 CID2 ..."
+std::vector<uint8_t> requests(uart::UARTComponent &uart) {
+  std::vector<uint8_t> functions;
+  const std::string &tx = uart.tx();
+  for (size_t start = tx.find('~'); start != std::string::npos; start = tx.find('~', start + 1)) {
+    if (start + 9 <= tx.size())
+      functions.push_back(uint8_t(std::stoul(tx.substr(start + 7, 2), nullptr, 16)));
+  }
+  return functions;
+}
+
+// Records what the bus hands over
+class RecordingDevice : public seplos_modbus::SeplosModbusDevice {
+ public:
+  void on_seplos_modbus_data(uint8_t function, const uint8_t *data, uint16_t length) override { this->frames++; }
+  void on_seplos_modbus_registers(uint8_t function, uint16_t register_address, const uint8_t *data,
+                                  uint16_t length) override {
+    this->registers++;
+  }
+  void on_seplos_modbus_failure(uint8_t function) override { this->failures.push_back(function); }
+  void on_seplos_modbus_discovered() override { this->discovered = true; }
+
+  bool discovered{false};
+  uint32_t frames{0};
+  uint32_t registers{0};
+  std::vector<uint8_t> failures;
+};
+
+void run(host::BmsFixture &fixture, uint32_t ms) {
+  host::now_ms += ms;
+  fixture.bus.loop();
+}
+
+void test_stray_frames() {
+  for (bool unsolicited_frames : {false, true}) {
+    host::BmsFixture fixture(0x20);
+    sensor::Sensor stray_frames;
+    fixture.bus.set_stray_frames_sensor(&stray_frames);
+    fixture.bus.set_unsolicited_frames(unsolicited_frames);
+    fixture.setup();
+
+    // A telemetry frame without a request
+    fixture.uart.receive(response(0x42));
+    run(fixture, 10);
+    fixture.bus.update();
+
+    // Only a frame which is dropped is a stray one
+    CHECK(stray_frames.state == (unsolicited_frames ? 0.0f : 1.0f));
+    CHECK(fixture.cell_voltages[0]->has_state() == unsolicited_frames);
+  }
+}
+
+void test_slow_response() {
+  host::BmsFixture fixture(0x20);
+  sensor::Sensor rx_timeouts;
+  fixture.bus.set_rx_timeouts_sensor(&rx_timeouts);
+  fixture.setup();
+
+  fixture.bms.update();
+  for (int i = 0; i < 10 && fixture.uart.tx().empty(); i++)
+    run(fixture, 100);
+  const std::vector<uint8_t> sent = requests(fixture.uart);
+  CHECK(sent.size() == 1);
+  if (sent.size() != 1)
+    return;
+
+  // The response trickles in over more than the response timeout, every chunk within the RX timeout
+  const std::string frame = response(sent.front());
+  const size_t chunks = 8;
+  for (size_t i = 0; i < chunks; i++) {
+    fixture.uart.receive(frame.substr(i * frame.size() / chunks, frame.size() / chunks + (i + 1 == chunks ? 8 : 0)));
+    run(fixture, 100);
+  }
+  run(fixture, 10);
+
+  // Received as a whole instead of being taken for a timeout, and neither retried nor cut off
+  fixture.bus.update();
+  CHECK(rx_timeouts.state == 0.0f);
+  CHECK(requests(fixture.uart).size() >= 1);
+  CHECK(requests(fixture.uart).front() == sent.front());
+  if (sent.front() == 0x42)
+    CHECK(fixture.cell_voltages[0]->has_state());
+  const std::vector<uint8_t> after = requests(fixture.uart);
+  for (size_t i = 1; i < after.size(); i++)
+    CHECK(after[i] != sent.front());
+}
+
+void test_modbus_rtu_exception() {
+  uart::UARTComponent uart;
+  seplos_modbus::SeplosModbus bus{};
+  RecordingDevice device;
+  bus.set_uart_parent(&uart);
+  device.set_parent(&bus);
+  device.set_address(0x01);
+  device.set_transport(seplos_modbus::TRANSPORT_MODBUS_RTU);
+  bus.register_device(&device);
+  bus.setup();
+
+  device.read_registers(0x04, 0x1000, 17);
+  for (int i = 0; i < 10 && uart.tx().empty(); i++) {
+    host::now_ms += 100;
+    bus.loop();
+  }
+  CHECK(uart.tx().size() == 8);
+  uart.tx().clear();
+
+  // Illegal data address
+  uint8_t exception[5] = {0x01, 0x84, 0x02};
+  const uint16_t crc = seplos_modbus::crc16(exception, 3);
+  exception[3] = uint8_t(crc >> 0);
+  exception[4] = uint8_t(crc >> 8);
+  uart.receive(exception, sizeof(exception));
+  host::now_ms += 10;
+  bus.loop();
+
+  // Reported right away as a failed poll, neither retried nor left to the response timeout
+  CHECK(device.failures == std::vector<uint8_t>({0x04}));
+  CHECK(device.registers == 0);
+  CHECK(bus.get_poll_statistics(&device).timeouts == 1);
+  for (int i = 0; i < 20; i++) {
+    host::now_ms += 100;
+    bus.loop();
+  }
+  CHECK(uart.tx().empty());
+  CHECK(device.failures.size() == 1);
+}
+
+void test_slow_probe_response() {
+  uart::UARTComponent uart;
+  seplos_modbus::SeplosModbus bus{};
+  RecordingDevice device;
+  bus.set_uart_parent(&uart);
+  bus.set_discovery_max_address(0x00);
+  bus.set_discovery_timeout(100);
+  bus.add_discovery_protocol_version(0x20);
+  device.set_parent(&bus);
+  device.set_discover_address(true);
+  bus.register_device(&device);
+  bus.setup();
+
+  for (int i = 0; i < 10 && uart.tx().empty(); i++) {
+    host::now_ms += 100;
+    bus.loop();
+  }
+  CHECK(requests(uart) == std::vector<uint8_t>({0x4F}));
+  uart.tx().clear();
+
+  // The response of the pack at 0x00 takes longer than the discovery timeout, every chunk within the RX timeout
+  const std::string frame = response(0x4F);
+  for (size_t i = 0; i < frame.size(); i += 6) {
+    uart.receive(frame.substr(i, 6));
+    host::now_ms += 60;
+    bus.loop();
+  }
+  host::now_ms += 10;
+  bus.loop();
+
+  CHECK(device.discovered && device.is_bound());
+  CHECK(uart.tx().empty() || requests(uart).front() != 0x4F);
+}
+
+void test_alarms_required() {
+  // Without an entity of the alarm frame only a consumer of the alarm bitmask makes the BMS poll the alarms
+  for (bool alarms_required : {false, true}) {
+    host::BmsFixture fixture(0x20);
+    fixture.bms.set_errors_text_sensor(nullptr);
+    fixture.bms.set_charging_switch_binary_sensor(nullptr);
+    fixture.bms.set_discharging_switch_binary_sensor(nullptr);
+    fixture.bms.set_balancing_binary_sensor(nullptr);
+    fixture.bms.set_alarms_required(alarms_required);
+    fixture.setup();
+
+    fixture.bms.update();
+    bool alarms_polled = false;
+    for (int i = 0; i < 50; i++) {
+      run(fixture, 100);
+      // Answer every request so the queue drains
+      const std::vector<uint8_t> sent = requests(fixture.uart);
+      if (!sent.empty() && fixture.uart.tx().back() == '\r') {
+        alarms_polled |= sent.back() == 0x44;
+        fixture.uart.tx().clear();
+        fixture.uart.receive(response(sent.back()));
+      }
+    }
+    CHECK(alarms_polled == alarms_required);
+  }
+}
+
+void test_latency_minimum() {
+  seplos_modbus::LatencyHistogram latencies;
+  latencies.add(5);
+  for (uint16_t i = 1; i < seplos_modbus::LATENCY_WINDOW; i++)
+    latencies.add(200);
+  CHECK(latencies.min() == 5);
+
+  // The outlier is part of the minimum until the samples since the first decay fill another window
+  for (uint32_t i = 0; i < 2 * seplos_modbus::LATENCY_WINDOW && latencies.min() == 5; i++)
+    latencies.add(200);
+  CHECK(latencies.min() == 200);
+  CHECK(latencies.count() < seplos_modbus::LATENCY_WINDOW);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s tests/esp8266-fake-bms.yaml\n", argv[0]);
+    return 2;
+  }
+  frames = host::read_fake_bms_frames(argv[1]);
+  CHECK(!frames.empty());
+
+  test_stray_frames();
+  test_slow_response();
+  test_modbus_rtu_exception();
+  test_slow_probe_response();
+  test_alarms_required();
+  test_latency_minimum();
+  return host::check_result();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace esphome {
+namespace button {
+
+class Button {
+ public:
+  virtual ~Button() = default;
+
+ protected:
+  virtual void press_action() = 0;
+};
+
+}  // namespace button
+}  // namespace esphome
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace canbus {
+
+enum Error : uint8_t {
+  ERROR_OK = 0,
+  ERROR_FAIL = 1,
+};
+
+// Virtual CAN bus: keeps the sent frames for the test
+class Canbus : public Component {
+ public:
+  struct Frame {
+    uint32_t can_id;
+    bool use_extended_id;
+    std::vector<uint8_t> data;
+  };
+
+  Error send_data(uint32_t can_id, bool use_extended_id, bool remote_transmission_request,
+                  const std::vector<uint8_t> &data) {
+    this->sent.push_back(Frame{can_id, use_extended_id, data});
+    return ERROR_OK;
+  }
+
+  std::vector<Frame> sent;
+};
+
+}  // namespace canbus
+}  // namespace esphome
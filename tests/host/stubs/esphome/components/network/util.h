@@ -0,0 +1,15 @@
+#pragma once
+
+namespace esphome {
+namespace network {
+
+bool is_connected();
+
+}  // namespace network
+
+namespace host {
+// Answer of network::is_connected()
+extern bool network_connected;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+}  // namespace host
+
+}  // namespace esphome
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->raw_state = state;
+    this->has_state_ = true;
+    this->publishes_++;
+  }
+  float get_state() const { return this->state; }
+  float get_raw_state() const { return this->raw_state; }
+  bool has_state() const { return this->has_state_; }
+  uint32_t publishes() const { return this->publishes_; }
+
+  float state{NAN};
+  float raw_state{NAN};
+
+ protected:
+  bool has_state_{false};
+  uint32_t publishes_{0};
+};
+
+}  // namespace sensor
+}  // namespace esphome
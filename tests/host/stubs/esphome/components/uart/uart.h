@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace uart {
+
+// Loopback of the host: the test queues the bytes the bus receives and inspects the bytes it sent
+class UARTComponent {
+ public:
+  void receive(const uint8_t *data, size_t length) { this->rx_.insert(this->rx_.end(), data, data + length); }
+  void receive(const std::string &data) { this->receive(reinterpret_cast<const uint8_t *>(data.data()), data.size()); }
+  size_t rx_available() const { return this->rx_.size() - this->rx_position_; }
+  bool read_byte(uint8_t *data) {
+    if (this->rx_available() == 0)
+      return false;
+    *data = this->rx_[this->rx_position_++];
+    if (this->rx_position_ == this->rx_.size()) {
+      this->rx_.clear();
+      this->rx_position_ = 0;
+    }
+    return true;
+  }
+  void write_array(const uint8_t *data, size_t length) { this->tx_.append(reinterpret_cast<const char *>(data), length); }
+  std::string &tx() { return this->tx_; }
+  // Keeps the capacity, so receiving the same amount again doesn't allocate
+  void reserve(size_t length) { this->rx_.reserve(length); }
+
+ protected:
+  std::vector<uint8_t> rx_;
+  size_t rx_position_{0};
+  std::string tx_;
+};
+
+class UARTDevice {
+ public:
+  UARTDevice() = default;
+  explicit UARTDevice(UARTComponent *parent) : parent_(parent) {}
+  void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+
+  int available() { return (int) this->parent_->rx_available(); }
+  bool read_byte(uint8_t *data) { return this->parent_->read_byte(data); }
+  bool read_array(uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      if (!this->read_byte(data + i))
+        return false;
+    }
+    return true;
+  }
+  void write_byte(uint8_t data) { this->parent_->write_array(&data, 1); }
+  void write_array(const uint8_t *data, size_t length) { this->parent_->write_array(data, length); }
+  void write_str(const char *str) { this->write_array(reinterpret_cast<const uint8_t *>(str), strlen(str)); }
+  void flush() {}
+
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+
+}  // namespace uart
+}  // namespace esphome
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum WebRequestMethod : uint8_t {
+  HTTP_GET = 1 << 0,
+  HTTP_POST = 1 << 1,
+};
+
+// Keeps the content like the responses of web_server_idf, which are sent before send() returns
+class AsyncWebServerResponse {
+ public:
+  AsyncWebServerResponse(int code, const char *content_type, const uint8_t *data, size_t length)
+      : code(code), content_type(content_type), content(data, data + length) {}
+  virtual ~AsyncWebServerResponse() = default;
+  void addHeader(const char *name, const char *value) { this->headers.emplace_back(name, value); }
+
+  int code;
+  std::string content_type;
+  std::vector<uint8_t> content;
+  std::vector<std::pair<std::string, std::string>> headers;
+};
+
+// Takes the response sent, see response()
+class AsyncWebServerRequest {
+ public:
+  explicit AsyncWebServerRequest(std::string url, WebRequestMethod method = HTTP_GET)
+      : method_(method), url_(std::move(url)) {}
+  WebRequestMethod method() const { return this->method_; }
+  std::string url() const { return this->url_; }
+  AsyncWebServerResponse *beginResponse_P(int code, const char *content_type, const uint8_t *data, size_t length) {
+    return new AsyncWebServerResponse(code, content_type, data, length);  // NOLINT(cppcoreguidelines-owning-memory)
+  }
+  void send(AsyncWebServerResponse *response) { this->response_.reset(response); }
+  void send(int code, const char *content_type = nullptr, const char *content = nullptr) {
+    const std::string body = content != nullptr ? content : "";
+    this->response_ = std::make_unique<AsyncWebServerResponse>(
+        code, content_type != nullptr ? content_type : "", reinterpret_cast<const uint8_t *>(body.data()),
+        body.size());
+  }
+
+  const AsyncWebServerResponse *response() const { return this->response_.get(); }
+
+ protected:
+  WebRequestMethod method_;
+  std::string url_;
+  std::unique_ptr<AsyncWebServerResponse> response_;
+};
+
+class AsyncWebHandler {
+ public:
+  virtual ~AsyncWebHandler() = default;
+  virtual bool canHandle(AsyncWebServerRequest *request) { return false; }
+  virtual void handleRequest(AsyncWebServerRequest *request) {}
+};
+
+namespace esphome {
+namespace web_server_base {
+
+class WebServerBase {
+ public:
+  void init() {}
+  void add_handler(AsyncWebHandler *handler) {}
+};
+
+}  // namespace web_server_base
+}  // namespace esphome
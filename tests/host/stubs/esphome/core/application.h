@@ -0,0 +1,37 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+
+#ifdef USE_SENSOR
+#include "esphome/components/sensor/sensor.h"
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace esphome {
+
+class Application {
+ public:
+  void feed_wdt() {}
+  uint32_t get_loop_component_start_time() const { return millis(); }
+
+#ifdef USE_SENSOR
+  void register_sensor(sensor::Sensor *sensor) { this->sensors_.push_back(sensor); }
+  const std::vector<sensor::Sensor *> &get_sensors() { return this->sensors_; }
+  // Only on the host, the sensors of a test go away with it
+  void unregister_sensor(sensor::Sensor *sensor) {
+    this->sensors_.erase(std::remove(this->sensors_.begin(), this->sensors_.end(), sensor), this->sensors_.end());
+  }
+#endif
+
+ protected:
+#ifdef USE_SENSOR
+  std::vector<sensor::Sensor *> sensors_;
+#endif
+};
+
+extern Application App;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
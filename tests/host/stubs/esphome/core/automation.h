@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+// Hands the arguments to a test instead of running the actions of an automation
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) {
+    if (this->action_)
+      this->action_(x...);
+  }
+  void set_action(std::function<void(Ts...)> &&action) { this->action_ = std::move(action); }
+
+ protected:
+  std::function<void(Ts...)> action_;
+};
+
+}  // namespace esphome
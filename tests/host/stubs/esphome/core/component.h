@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/gpio.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float BUS;
+extern const float DATA;
+extern const float AFTER_CONNECTION;
+extern const float LATE;
+}  // namespace setup_priority
+
+// Timers and intervals are not scheduled on the host. The tests call the component methods themselves
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+  virtual float get_loop_priority() const { return 0.0f; }
+  virtual void on_shutdown() {}
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning() {}
+  void status_clear_warning() {}
+
+ protected:
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {}
+  void set_interval(uint32_t interval, std::function<void()> &&f) {}
+  bool cancel_interval(const std::string &name) { return true; }
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {}
+  void set_timeout(uint32_t timeout, std::function<void()> &&f) {}
+  bool cancel_timeout(const std::string &name) { return true; }
+  void defer(std::function<void()> &&f) {}
+  void defer(const std::string &name, std::function<void()> &&f) {}
+
+  bool failed_{false};
+};
+
+class PollingComponent : public Component {
+ public:
+  PollingComponent() = default;
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+  virtual void update() = 0;
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual uint32_t get_update_interval() const { return this->update_interval_; }
+  void start_poller() {}
+  void stop_poller() {}
+
+ protected:
+  uint32_t update_interval_{0};
+};
+
+}  // namespace esphome
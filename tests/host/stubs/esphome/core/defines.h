@@ -0,0 +1,10 @@
+#pragma once
+
+#define USE_SENSOR
+#define USE_BUTTON
+#define USE_NUMBER
+#define USE_SWITCH
+
+// The optional parts of the components built on the host, the web handlers against the stand-in of the web server
+#define USE_SEPLOS_MODBUS_CAPTURE
+#define USE_SEPLOS_EXPORT_WEB_SERVER
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+namespace esphome {
+
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() {}
+  virtual void digital_write(bool value) {}
+  virtual std::string dump_summary() const { return ""; }
+};
+
+}  // namespace esphome
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+std::string format_hex(const uint8_t *data, size_t length);
+std::string format_hex_pretty(const uint8_t *data, size_t length);
+std::string format_hex_pretty(const std::vector<uint8_t> &data);
+uint32_t fnv1_hash(const std::string &str);
+std::string to_string(int value);
+
+constexpr uint16_t encode_uint16(uint8_t msb, uint8_t lsb) { return (uint16_t(msb) << 8) | lsb; }
+
+template<typename T> T clamp(T value, T min, T max) { return std::min(std::max(value, min), max); }
+
+class HighFrequencyLoopRequester {
+ public:
+  void start() {}
+  void stop() {}
+};
+
+// A real mutex, the host programs may use threads
+class Mutex {
+ public:
+  Mutex() = default;
+  Mutex(const Mutex &) = delete;
+  Mutex &operator=(const Mutex &) = delete;
+  void lock() { this->mutex_.lock(); }
+  bool try_lock() { return this->mutex_.try_lock(); }
+  void unlock() { this->mutex_.unlock(); }
+
+ protected:
+  std::mutex mutex_;
+};
+
+class LockGuard {
+ public:
+  explicit LockGuard(Mutex &mutex) : mutex_(mutex) { this->mutex_.lock(); }
+  ~LockGuard() { this->mutex_.unlock(); }
+
+ protected:
+  Mutex &mutex_;
+};
+
+template<typename T> class RAMAllocator {
+ public:
+  T *allocate(size_t n) { return new T[n]; }  // NOLINT(cppcoreguidelines-owning-memory)
+  void deallocate(T *p, size_t n) { delete[] p; }  // NOLINT(cppcoreguidelines-owning-memory)
+};
+
+// There is no PSRAM on the host
+template<typename T> class ExternalRAMAllocator {
+ public:
+  enum Flags { NONE = 0, REFUSE_INTERNAL = 1 << 0, ALLOW_FAILURE = 1 << 1 };
+  ExternalRAMAllocator() = default;
+  explicit ExternalRAMAllocator(Flags flags) {}
+  T *allocate(size_t n) { return new T[n]; }  // NOLINT(cppcoreguidelines-owning-memory)
+  void deallocate(T *p, size_t n) { delete[] p; }  // NOLINT(cppcoreguidelines-owning-memory)
+};
+
+template<typename... Ts> class CallbackManager;
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_)
+      callback(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+enum LogLevel : int {
+  LOG_LEVEL_NONE = 0,
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_WARN,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_CONFIG,
+  LOG_LEVEL_DEBUG,
+  LOG_LEVEL_VERBOSE,
+  LOG_LEVEL_VERY_VERBOSE,
+};
+
+// Nothing is logged by default, SEPLOS_HOST_LOG_LEVEL=<0..7> raises the level
+extern int log_level;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void log(int level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+}  // namespace host
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_VERY_VERBOSE, tag, __VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) (void) (pin)
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_BINARY_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_TEXT_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_SWITCH(prefix, type, obj) (void) (obj)
+#define LOG_BUTTON(prefix, type, obj) (void) (obj)
+#define LOG_NUMBER(prefix, type, obj) (void) (obj)
+#define LOG_UPDATE_INTERVAL(this) (void) (this)
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+namespace host {
+// The flash of the host, shared by all preferences and kept across "reboots" of a test
+std::map<uint32_t, std::vector<uint8_t>> &flash();
+}  // namespace host
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key), valid_(true) {}
+
+  template<typename T> bool save(const T *src) {
+    if (!this->valid_)
+      return false;
+    const auto *bytes = reinterpret_cast<const uint8_t *>(src);
+    host::flash()[this->key_].assign(bytes, bytes + sizeof(T));
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    if (!this->valid_)
+      return false;
+    auto it = host::flash().find(this->key_);
+    if (it == host::flash().end() || it->second.size() != sizeof(T))
+      return false;
+    memcpy(dest, it->second.data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  uint32_t key_{0};
+  bool valid_{false};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return ESPPreferenceObject(type);
+  }
+};
+
+extern ESPPreferences *global_preferences;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
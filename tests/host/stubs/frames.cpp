@@ -0,0 +1,54 @@
+#include "host.h"
+
+#include <cstdlib>
+#include <fstream>
+
+namespace esphome {
+namespace host {
+
+std::vector<uint8_t> decode_ascii_frame(const std::string &frame) {
+  std::vector<uint8_t> data;
+  size_t end = frame.size();
+  if (end > 0 && frame[end - 1] == '\r')
+    end--;
+  // SOF and CHKSUM
+  if (end < 1 + 4 || frame.front() != '~')
+    return data;
+
+  end -= 4;
+  for (size_t i = 1; i + 2 <= end; i += 2) {
+    data.push_back((uint8_t) strtoul(frame.substr(i, 2).c_str(), nullptr, 16));
+  }
+  return data;
+}
+
+// Every response follows a comment naming the request it answers:
+//
+//   # Responses to "~20004642E00200FD37\r"
+//   - uart.write: "~2000460010960001...DC6C\r"
+std::vector<FakeBmsFrame> read_fake_bms_frames(const std::string &path) {
+  std::vector<FakeBmsFrame> frames;
+  std::ifstream file(path);
+  std::string line;
+  uint8_t function = 0x00;
+  while (std::getline(file, line)) {
+    const size_t start = line.find("\"~");
+    if (start == std::string::npos)
+      continue;
+    const size_t end = line.find("\\r\"", start);
+    if (end == std::string::npos)
+      continue;
+
+    const std::string frame = line.substr(start + 1, end - start - 1);
+    if (line.find("Response") != std::string::npos) {
+      // SOF, VER, ADR, CID1, then CID2
+      function = (uint8_t) strtoul(frame.substr(7, 2).c_str(), nullptr, 16);
+    } else if (line.find("uart.write") != std::string::npos) {
+      frames.push_back(FakeBmsFrame{function, frame + "\r"});
+    }
+  }
+  return frames;
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,99 @@
+// Runtime of the ESPHome stand-ins on the host
+#include "esphome/components/network/util.h"
+#include "esphome/core/application.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+#include <cstdarg>
+#include <cstdlib>
+
+#include "host.h"
+
+namespace esphome {
+
+namespace host {
+
+uint32_t now_ms = 0;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+bool network_connected = true;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+int check_failures = 0;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+static int initial_log_level() {
+  const char *level = getenv("SEPLOS_HOST_LOG_LEVEL");
+  return (level != nullptr) ? atoi(level) : LOG_LEVEL_NONE;
+}
+int log_level = initial_log_level();  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void log(int level, const char *tag, const char *format, ...) {
+  if (level > log_level)
+    return;
+  printf("[%s] ", tag);
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  printf("\n");
+}
+
+std::map<uint32_t, std::vector<uint8_t>> &flash() {
+  static std::map<uint32_t, std::vector<uint8_t>> flash;
+  return flash;
+}
+
+}  // namespace host
+
+uint32_t millis() { return host::now_ms; }
+uint32_t micros() { return host::now_ms * 1000; }
+void delay(uint32_t ms) { host::now_ms += ms; }
+
+namespace setup_priority {
+const float BUS = 1000.0f;
+const float DATA = 600.0f;
+const float AFTER_CONNECTION = 100.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+namespace network {
+bool is_connected() { return host::network_connected; }
+}  // namespace network
+
+std::string format_hex(const uint8_t *data, size_t length) {
+  std::string out;
+  char byte[3];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(byte, sizeof(byte), "%02x", data[i]);
+    out += byte;
+  }
+  return out;
+}
+
+std::string format_hex_pretty(const uint8_t *data, size_t length) {
+  std::string out;
+  char byte[4];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(byte, sizeof(byte), "%02X.", data[i]);
+    out += byte;
+  }
+  if (!out.empty())
+    out.pop_back();
+  return out;
+}
+
+std::string format_hex_pretty(const std::vector<uint8_t> &data) { return format_hex_pretty(data.data(), data.size()); }
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= (uint8_t) c;
+  }
+  return hash;
+}
+
+std::string to_string(int value) { return std::to_string(value); }
+
+static ESPPreferences preferences;                // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+ESPPreferences *global_preferences = &preferences;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+Application App;                                  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
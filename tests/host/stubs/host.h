@@ -0,0 +1,29 @@
+#pragma once
+
+// Controls of the ESPHome stand-ins for the host programs
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace host {
+
+// Time returned by millis()
+extern uint32_t now_ms;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// The binary content of an ASCII frame "~VER ADR CID1 RTN LENID INFO CHKSUM\r" as handed over to the devices,
+// without SOF, checksum and EOF
+std::vector<uint8_t> decode_ascii_frame(const std::string &frame);
+
+// A frame of the fake BMS configuration and the function (CID2) of the request it answers
+struct FakeBmsFrame {
+  uint8_t function;
+  std::string frame;
+};
+
+// The `uart.write` responses of tests/esp8266-fake-bms.yaml, including the commented ones
+std::vector<FakeBmsFrame> read_fake_bms_frames(const std::string &path);
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Print or replay a capture downloaded from `seplos_modbus: capture:`.
+
+  curl -o capture.bin http://seplos-bms.local/seplos_modbus/capture
+  ./seplos-capture.py capture.bin
+  ./seplos-capture.py capture.bin --replay /dev/ttyUSB0 --baud-rate 9600
+
+The replay writes the received frames (RX) to a RS485 adapter with their original
+timing. Wire it to the bus of a node to feed the frames through its decoder again.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("<IBH")
+DIRECTIONS = {0: "RX", 1: "TX"}
+
+
+def read_records(data):
+    offset = 0
+    while offset + HEADER.size <= len(data):
+        timestamp, direction, length = HEADER.unpack_from(data, offset)
+        offset += HEADER.size
+        frame = data[offset : offset + length]
+        if len(frame) != length:
+            print(f"Truncated record at offset {offset}", file=sys.stderr)
+            return
+        offset += length
+        yield timestamp, direction, frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture")
+    parser.add_argument("--replay", metavar="PORT", help="serial port to write the RX frames to")
+    parser.add_argument("--baud-rate", type=int, default=9600)
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as file:
+        records = list(read_records(file.read()))
+
+    if not args.replay:
+        for timestamp, direction, frame in records:
+            text = frame.decode("ascii", errors="backslashreplace")
+            print(f"{timestamp:>10} {DIRECTIONS.get(direction, '??')} {text!r}")
+        return
+
+    import serial  # pylint: disable=import-outside-toplevel
+
+    with serial.Serial(args.replay, args.baud_rate) as port:
+        start = None
+        for timestamp, direction, frame in records:
+            if direction != 0:
+                continue
+            if start is None:
+                start = (timestamp, time.monotonic())
+            delay = (timestamp - start[0]) / 1000 - (time.monotonic() - start[1])
+            if delay > 0:
+                time.sleep(delay)
+            port.write(frame)
+        port.flush()
+
+
+if __name__ == "__main__":
+    main()
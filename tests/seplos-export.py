@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Decode the records of `seplos_export`.
+
+  curl -s http://seplos-bms.local/seplos_export > records.bin
+  mosquitto_sub -t seplos/export -C 1 > records.bin
+  ./seplos-export.py records.bin
+
+A file holds any number of records back to back. Records of a newer schema version are
+decoded as far as this script knows them.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SCHEMA_VERSION = 1
+RECORD_HEADER = struct.Struct("<BBHIHhHHHHQBB")
+
+# Unknown values of the sender
+UNKNOWN_UINT16 = 0xFFFF
+UNKNOWN_INT16 = -0x8000
+
+
+def scale(value, factor, unknown):
+    return None if value == unknown else round(value * factor, 3)
+
+
+def decode_record(record):
+    (
+        version,
+        pack,
+        size,
+        uptime,
+        state_of_charge,
+        current,
+        total_voltage,
+        residual_capacity,
+        battery_capacity,
+        state_of_health,
+        alarm_bitmask,
+        cells,
+        temperature_sensors,
+    ) = RECORD_HEADER.unpack_from(record, 0)
+    values = struct.unpack_from(
+        f"<{cells + temperature_sensors}H", record, RECORD_HEADER.size
+    )
+    return {
+        "version": version,
+        "pack": pack,
+        "uptime": uptime,
+        "state_of_charge": scale(state_of_charge, 0.1, UNKNOWN_UINT16),
+        "current": scale(current, 0.01, UNKNOWN_INT16),
+        "total_voltage": scale(total_voltage, 0.01, UNKNOWN_UINT16),
+        "residual_capacity": scale(residual_capacity, 0.01, UNKNOWN_UINT16),
+        "battery_capacity": scale(battery_capacity, 0.01, UNKNOWN_UINT16),
+        "state_of_health": scale(state_of_health, 0.1, UNKNOWN_UINT16),
+        "alarm_bitmask": alarm_bitmask,
+        "cell_voltages": [value / 1000 for value in values[:cells]],
+        "temperatures": [round((value - 2731) / 10, 1) for value in values[cells:]],
+    }
+
+
+def read_records(data):
+    offset = 0
+    records = []
+    while offset < len(data):
+        if len(data) - offset < RECORD_HEADER.size:
+            print(f"Truncated record at offset {offset}", file=sys.stderr)
+            break
+        (size,) = struct.unpack_from("<H", data, offset + 2)
+        record = data[offset : offset + size]
+        if size < RECORD_HEADER.size or len(record) != size:
+            print(f"Invalid record at offset {offset}", file=sys.stderr)
+            break
+        if record[0] > SCHEMA_VERSION:
+            print(
+                f"Record of schema version {record[0]} at offset {offset}, decoding version {SCHEMA_VERSION}",
+                file=sys.stderr,
+            )
+        records.append(decode_record(record))
+        offset += size
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("records")
+    parser.add_argument("--json", action="store_true", help="print one JSON object per record")
+    args = parser.parse_args()
+
+    with open(args.records, "rb") as file:
+        records = read_records(file.read())
+
+    for record in records:
+        if args.json:
+            print(json.dumps(record))
+            continue
+        cells = " ".join(f"{value:.3f}" for value in record["cell_voltages"])
+        temperatures = " ".join(f"{value:.1f}" for value in record["temperatures"])
+        print(
+            f"{record['uptime']} ms pack {record['pack']}: {record['state_of_charge']} % "
+            f"{record['current']} A {record['total_voltage']} V {record['residual_capacity']}/"
+            f"{record['battery_capacity']} Ah SOH {record['state_of_health']} % "
+            f"alarms 0x{record['alarm_bitmask']:016X} cells {cells} temperatures {temperatures}"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Decode the chunks handed over by `seplos_history: on_drain:`.
+
+  mosquitto_sub -t seplos/history -C 1 > chunk.bin
+  ./seplos-history.py chunk.bin --received 2024-06-01T12:00:00
+
+Every record is printed with its time, derived from the uptime of the node at the time
+of the drain and the time the chunk was received (the modification time of the file).
+"""
+
+import argparse
+from datetime import datetime, timedelta
+import os
+import struct
+import sys
+
+CHUNK_HEADER = struct.Struct("<I")
+RECORD_HEADER = struct.Struct("<BI")
+
+
+def read_varint(data, offset):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, offset
+
+
+def read_zigzag(data, offset):
+    value, offset = read_varint(data, offset)
+    return (value >> 1) ^ -(value & 1), offset
+
+
+def read_series(data, offset):
+    count, offset = read_varint(data, offset)
+    values = []
+    for i in range(count):
+        if i == 0:
+            value, offset = read_varint(data, offset)
+        else:
+            delta, offset = read_zigzag(data, offset)
+            value = values[-1] + delta
+        values.append(value)
+    return values, offset
+
+
+def decode_record(record):
+    pack, timestamp = RECORD_HEADER.unpack_from(record, 0)
+    offset = RECORD_HEADER.size
+    state_of_charge, offset = read_varint(record, offset)
+    current, offset = read_zigzag(record, offset)
+    total_voltage, offset = read_varint(record, offset)
+    cells, offset = read_series(record, offset)
+    temperatures, offset = read_series(record, offset)
+    return {
+        "pack": pack,
+        "timestamp": timestamp,
+        "state_of_charge": state_of_charge / 10,
+        "current": current / 100,
+        "total_voltage": total_voltage / 100,
+        "cell_voltages": [value / 1000 for value in cells],
+        "temperatures": [round((value - 2731) / 10, 1) for value in temperatures],
+    }
+
+
+def read_chunk(data):
+    (uptime,) = CHUNK_HEADER.unpack_from(data, 0)
+    offset = CHUNK_HEADER.size
+    records = []
+    while offset < len(data):
+        length = data[offset]
+        record = data[offset + 1 : offset + 1 + length]
+        if len(record) != length:
+            print(f"Truncated record at offset {offset}", file=sys.stderr)
+            break
+        records.append(decode_record(record))
+        offset += 1 + length
+    return uptime, records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("chunk")
+    parser.add_argument(
+        "--received",
+        type=datetime.fromisoformat,
+        help="time the chunk was received (default: modification time of the file)",
+    )
+    args = parser.parse_args()
+
+    with open(args.chunk, "rb") as file:
+        uptime, records = read_chunk(file.read())
+    received = args.received or datetime.fromtimestamp(os.path.getmtime(args.chunk))
+
+    for record in records:
+        # The uptime is a uint32_t in ms and wraps around after 49 days
+        age = (uptime - record["timestamp"]) % (1 << 32)
+        time = received - timedelta(milliseconds=age)
+        cells = " ".join(f"{value:.3f}" for value in record["cell_voltages"])
+        temperatures = " ".join(f"{value:.1f}" for value in record["temperatures"])
+        print(
+            f"{time.isoformat(timespec='seconds')} pack {record['pack']}: "
+            f"{record['state_of_charge']:.1f} % {record['current']:.2f} A {record['total_voltage']:.2f} V "
+            f"cells {cells} temperatures {temperatures}"
+        )
+
+
+if __name__ == "__main__":
+    main()